@@ -3,10 +3,13 @@
 Script to analyze benchmark results JSON and calculate percentiles for performance metrics.
 
 This script parses the benchmark results JSON file and calculates percentiles (P50, P90, P95, P99, P100)
-for various performance metrics from api_time_info and api_usage blocks.
+for various performance metrics from api_time_info and api_usage blocks. The
+initialization transient is detected with MSER-5 on per-interval throughput and
+latency series, and the percentiles are repeated for the steady-state requests.
 
 Usage:
     python3 analyze_benchmark_results.py input_file.json [--output-csv output.csv]
+        [--steady-state-interval SECONDS]
 """
 
 import json
@@ -42,6 +45,10 @@ def calculate_percentiles(data: List[float], percentiles: List[float] = [50, 90,
     return results
 
 
+CHUNK_METRICS = ["tokens_per_chunk", "mean_chunk_bytes", "gap_p50_seconds", "gap_p99_seconds",
+                 "events_per_read", "smoothness"]
+
+
 def extract_metrics_from_completion(completion: Dict[str, Any]) -> Dict[str, float]:
     """
     Extract metrics from a single completion entry.
@@ -72,16 +79,173 @@ def extract_metrics_from_completion(completion: Dict[str, Any]) -> Dict[str, flo
         metrics["completion_tokens"] = float(usage_info.get("completion_tokens", 0))
         metrics["total_tokens"] = float(usage_info.get("total_tokens", 0))
     
+    # Extract chunk granularity metrics (--chunk_analytics)
+    for key in CHUNK_METRICS:
+        if key in completion.get("chunk_granularity", {}):
+            metrics[key] = float(completion["chunk_granularity"][key])
+    
     return metrics
 
 
-def analyze_benchmark_results(input_file: str, output_csv: str = None) -> Dict[str, Any]:
+MSER_BATCH_SIZE = 5
+MSER_MIN_BATCHES = 4
+AUTO_INTERVALS = 100
+
+
+def mser5_truncation(series: List[float]) -> int:
+    """
+    Find the MSER-5 truncation point of a time series.
+    
+    Observations are averaged in batches of 5, and the truncation minimizing the
+    standard error of the remaining batch means is chosen, within the first half
+    of the batches.
+    
+    Args:
+        series: Evenly spaced observations
+        
+    Returns:
+        Index of the first observation kept (0 with fewer than 4 batches)
+    """
+    batches = len(series) // MSER_BATCH_SIZE
+    if batches < MSER_MIN_BATCHES:
+        return 0
+    means = np.array(series[:batches * MSER_BATCH_SIZE], dtype=float)
+    means = means.reshape(batches, MSER_BATCH_SIZE).mean(axis=1)
+    
+    best, best_statistic = 0, float("inf")
+    for d in range(batches // 2 + 1):
+        kept = means[d:]
+        statistic = float(np.sum((kept - kept.mean()) ** 2)) / len(kept) ** 2
+        if statistic < best_statistic:
+            best, best_statistic = d, statistic
+    return best * MSER_BATCH_SIZE
+
+
+def build_interval_series(completions: List[Dict[str, Any]], run_start: float,
+                          interval: float, intervals: int) -> Dict[str, List[float]]:
+    """
+    Build per-interval throughput and latency series from request timestamps.
+    
+    Requests per second are counted by end_time. Completion tokens are spread
+    evenly over each request's decode phase (ttft_time to end_time). Mean TTFT
+    and latency are taken by start_time, with empty intervals repeating the
+    previous mean.
+    
+    Args:
+        completions: Completion entries with start_time and end_time
+        run_start: Start of the first interval, in the completions' clock
+        interval: Interval width in seconds
+        intervals: Number of intervals
+        
+    Returns:
+        Dictionary mapping series names to per-interval values
+    """
+    def index(time: float) -> int:
+        return min(max(int((time - run_start) // interval), 0), intervals - 1)
+    
+    completed = [0.0] * intervals
+    tokens = [0.0] * intervals
+    sums = {"ttft_seconds": [0.0] * intervals, "latency_seconds": [0.0] * intervals}
+    counts = {"ttft_seconds": [0] * intervals, "latency_seconds": [0] * intervals}
+    for completion in completions:
+        if not completion.get("success", True) or "end_time" not in completion:
+            continue
+        start, end = completion["start_time"], completion["end_time"]
+        completed[index(end)] += 1.0 / interval
+        
+        completion_tokens = completion.get("api_usage", {}).get("completion_tokens", 0)
+        decode_start = completion.get("ttft_time", end)
+        if end > decode_start:
+            rate = completion_tokens / (end - decode_start) / interval
+            for i in range(index(decode_start), index(end) + 1):
+                low = max(decode_start, run_start + i * interval)
+                high = min(end, run_start + (i + 1) * interval)
+                tokens[i] += rate * max(high - low, 0.0)
+        else:
+            tokens[index(end)] += completion_tokens / interval
+        
+        for name, key in (("ttft_seconds", "ttft_duration_seconds"),
+                          ("latency_seconds", "total_duration_seconds")):
+            if key in completion:
+                sums[name][index(start)] += completion[key]
+                counts[name][index(start)] += 1
+    
+    series = {"requests_per_second": completed, "completion_tokens_per_second": tokens}
+    for name in sums:
+        observed = [s / c for s, c in zip(sums[name], counts[name]) if c > 0]
+        previous = observed[0] if observed else 0.0
+        means = []
+        for s, c in zip(sums[name], counts[name]):
+            previous = s / c if c > 0 else previous
+            means.append(previous)
+        series[name] = means
+    return series
+
+
+def detect_steady_state(completions: List[Dict[str, Any]], interval: float = 0.0) -> Dict[str, Any]:
+    """
+    Detect the end of the initialization transient with MSER-5.
+    
+    The cutoff is the latest of the per-series MSER-5 truncation points; the
+    steady-state requests are those started after it.
+    
+    Args:
+        completions: Completion entries with start_time and end_time
+        interval: Interval width in seconds (0 = run duration / 100)
+        
+    Returns:
+        Dictionary with the cutoff, per-series cutoffs and steady-state completions
+    """
+    timed = [c for c in completions if "start_time" in c and "end_time" in c]
+    if not timed:
+        return {}
+    run_start = min(c["start_time"] for c in timed)
+    run_end = max(c["end_time"] for c in timed)
+    duration = run_end - run_start
+    if duration <= 0:
+        return {}
+    if interval <= 0:
+        interval = duration / AUTO_INTERVALS
+    intervals = max(int(np.ceil(duration / interval)), 1)
+    
+    series = build_interval_series(timed, run_start, interval, intervals)
+    cutoffs = {name: mser5_truncation(values) for name, values in series.items()}
+    cutoff_interval = max(cutoffs.values())
+    cutoff_time = run_start + cutoff_interval * interval
+    steady = [c for c in timed if c["start_time"] >= cutoff_time]
+    
+    def throughput(window: List[Dict[str, Any]], seconds: float) -> Dict[str, float]:
+        tokens = sum(c.get("api_usage", {}).get("completion_tokens", 0) for c in window)
+        return {
+            "requests": len(window),
+            "duration_seconds": seconds,
+            "requests_per_second": len(window) / seconds if seconds > 0 else 0.0,
+            "completion_tokens_per_second": tokens / seconds if seconds > 0 else 0.0,
+        }
+    
+    return {
+        "interval_seconds": interval,
+        "intervals": intervals,
+        "sufficient_data": intervals // MSER_BATCH_SIZE >= MSER_MIN_BATCHES,
+        "cutoff_interval": cutoff_interval,
+        "cutoff_seconds": cutoff_interval * interval,
+        "series_cutoff_seconds": {name: d * interval for name, d in cutoffs.items()},
+        "full_run": throughput(timed, duration),
+        "steady_state": throughput(steady, run_end - cutoff_time),
+        "completions": steady,
+    }
+
+
+def analyze_benchmark_results(input_file: str, output_csv: str = None,
+                              steady_state_interval: float = 0.0) -> Dict[str, Any]:
     """
     Analyze benchmark results and calculate percentiles.
     
     Args:
         input_file: Path to the benchmark results JSON file
         output_csv: Optional path to save results as CSV
+        steady_state_interval: Interval width of the steady-state series in
+            seconds (0 = run duration / 100)
         
     Returns:
         Dictionary containing analysis results
@@ -110,6 +274,8 @@ def analyze_benchmark_results(input_file: str, output_csv: str = None) -> Dict[s
         "queue_time", "prompt_time", "completion_time", "total_time", 
         "queue_plus_prompt_time", "prompt_tokens", "completion_tokens", "total_tokens"
     ]
+    if any("chunk_granularity" in completion for completion in completions):
+        metric_names += CHUNK_METRICS
     
     # Initialize metric lists
     for metric in metric_names:
@@ -122,6 +288,16 @@ def analyze_benchmark_results(input_file: str, output_csv: str = None) -> Dict[s
             if metric in metrics:
                 all_metrics[metric].append(metrics[metric])
     
+    # Same metrics over the requests started after the detected warmup
+    steady_state = detect_steady_state(completions, steady_state_interval)
+    for metric in metric_names:
+        all_metrics[f"steady_state_{metric}"] = []
+    for completion in steady_state.get("completions", []):
+        metrics = extract_metrics_from_completion(completion)
+        for metric in metric_names:
+            if metric in metrics:
+                all_metrics[f"steady_state_{metric}"].append(metrics[metric])
+    
     # Calculate percentiles for each metric
     results = {}
     percentiles = [50, 90, 95, 99, 100]
@@ -152,12 +328,67 @@ def analyze_benchmark_results(input_file: str, output_csv: str = None) -> Dict[s
         overall = data["overall_stats"]
         print(f"Total Requests: {overall.get('total_number_requests', 'N/A')}")
         print(f"Total Failures: {overall.get('total_number_failures', 'N/A')}")
-        print(f"Total Duration: {overall.get('total_duration_seconds', 'N/A'):.2f} seconds")
-        print(f"Requests/Second: {overall.get('requests_per_second', 'N/A'):.2f}")
+        # Consolidated rerun reports only carry totals
+        if "total_duration_seconds" in overall:
+            print(f"Total Duration: {overall['total_duration_seconds']:.2f} seconds")
+            print(f"Requests/Second: {overall['requests_per_second']:.2f}")
         print(f"Total Prompt Tokens: {overall.get('total_prompt_tokens', 'N/A'):,}")
         print(f"Total Completion Tokens: {overall.get('total_completion_tokens', 'N/A'):,}")
         print(f"Total Tokens: {overall.get('total_tokens', 'N/A'):,}")
     
+    chunk_granularity = data.get("overall_stats", {}).get("chunk_granularity")
+    if chunk_granularity:
+        print("\n" + "="*80)
+        print("CHUNK GRANULARITY")
+        print("="*80)
+        print(f"Tokens/Chunk: {chunk_granularity['tokens_per_chunk']['overall']:.2f}")
+        print(f"Events/Read: {chunk_granularity['events_per_read']:.2f}")
+        print(f"Chunks/Burst: {chunk_granularity['chunks_per_burst']:.2f}")
+        if chunk_granularity.get("smoothness"):
+            print(f"Smoothness P50: {chunk_granularity['smoothness']['p50']:.3f}")
+        signals = chunk_granularity["coalescing"]["signals"]
+        if signals:
+            print("Coalescing detected:")
+            for signal in signals:
+                print(f"  {signal['signal']}: {signal['value']:.2f} "
+                      f"(threshold {signal['threshold']}) - {signal['meaning']}")
+        else:
+            print("No coalescing detected")
+    
+    wire_bytes = data.get("overall_stats", {}).get("wire_bytes")
+    if wire_bytes:
+        print("\n" + "="*80)
+        print("WIRE BYTES")
+        print("="*80)
+        print(f"Request Bytes/Second: {wire_bytes['request_bytes_per_second']:,.0f}")
+        print(f"Response Bytes/Second: {wire_bytes['response_bytes_per_second']:,.0f}")
+        for encoding, group in wire_bytes["by_accept_encoding"].items():
+            print(f"{encoding}: {group['response_bytes_per_output_token']:.1f} bytes/token, "
+                  f"compression {group['compression_ratio']:.2f}x, "
+                  f"SSE framing {group['sse_framing_fraction']:.1%}")
+        for encoding, comparison in wire_bytes.get("compression", {}).items():
+            print(f"{encoding} vs identity: {comparison['bytes_saved_fraction']:.1%} bytes saved, "
+                  f"TTFT P50 {comparison['ttft_p50_delta_seconds'] * 1000:+.2f} ms, "
+                  f"ITL P50 {comparison['itl_p50_delta_seconds'] * 1000:+.2f} ms")
+    
+    if steady_state:
+        print("\n" + "="*80)
+        print("STEADY STATE (MSER-5)")
+        print("="*80)
+        print(f"Interval: {steady_state['interval_seconds']:.3f} seconds "
+              f"({steady_state['intervals']} intervals)")
+        if not steady_state["sufficient_data"]:
+            print("Too few intervals for MSER-5, no warmup truncated")
+        print(f"Cutoff: {steady_state['cutoff_seconds']:.2f} seconds after the first request")
+        for name, cutoff in steady_state["series_cutoff_seconds"].items():
+            print(f"  {name}: {cutoff:.2f} seconds")
+        print(f"{'':<28}{'Full run':>14}{'Steady state':>14}")
+        for key, label in (("requests", "Requests"), ("duration_seconds", "Duration (s)"),
+                           ("requests_per_second", "Requests/Second"),
+                           ("completion_tokens_per_second", "Completion Tokens/Second")):
+            print(f"{label:<28}{steady_state['full_run'][key]:>14.2f}"
+                  f"{steady_state['steady_state'][key]:>14.2f}")
+    
     # Save to CSV if requested
     if output_csv:
         save_to_csv(results, output_csv, percentiles)
@@ -205,6 +436,9 @@ Examples:
     
     parser.add_argument('input_file', help='Path to benchmark results JSON file')
     parser.add_argument('--output-csv', help='Path to save results as CSV file')
+    parser.add_argument('--steady-state-interval', type=float, default=0.0,
+                        help='Interval width in seconds of the MSER-5 steady-state series '
+                             '(default: run duration / 100)')
     
     args = parser.parse_args()
     
@@ -214,7 +448,7 @@ Examples:
         sys.exit(1)
     
     # Analyze the results
-    analyze_benchmark_results(args.input_file, args.output_csv)
+    analyze_benchmark_results(args.input_file, args.output_csv, args.steady_state_interval)
 
 
 if __name__ == "__main__":
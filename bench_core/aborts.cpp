@@ -0,0 +1,211 @@
+#include "bench_core/aborts.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <utility>
+
+#include "bench_core/rate_limiter.h"
+
+namespace bench_core {
+
+namespace {
+
+// Used when a request does not set max_tokens
+constexpr size_t kDefaultAbortHorizonTokens = 64;
+
+using Clock = std::chrono::steady_clock;
+
+// Completion tokens per content chunk of a request, 1 without reported usage
+double request_tokens_per_chunk(const CompletionStats& completion_stats) {
+    size_t chunks = completion_stats.content_chunks();
+    if (chunks == 0 || completion_stats.api_usage.completion_tokens == 0) {
+        return 1.0;
+    }
+    return static_cast<double>(completion_stats.api_usage.completion_tokens) /
+           static_cast<double>(chunks);
+}
+
+// Disjoint, sorted intervals covering [abort, abort + window] of every abort
+std::vector<std::pair<Clock::time_point, Clock::time_point>> abort_windows(
+    const std::vector<Clock::time_point>& abort_times, Clock::duration window) {
+    std::vector<std::pair<Clock::time_point, Clock::time_point>> windows;
+    for (auto time : abort_times) {
+        if (!windows.empty() && time <= windows.back().second) {
+            windows.back().second = std::max(windows.back().second, time + window);
+        } else {
+            windows.emplace_back(time, time + window);
+        }
+    }
+    return windows;
+}
+
+// Seconds of [begin, end] covered by the windows
+double seconds_in_windows(
+    const std::vector<std::pair<Clock::time_point, Clock::time_point>>& windows,
+    Clock::time_point begin, Clock::time_point end) {
+    double seconds = 0.0;
+    for (const auto& [window_begin, window_end] : windows) {
+        if (window_begin >= end) {
+            break;
+        }
+        auto overlap_begin = std::max(begin, window_begin);
+        auto overlap_end = std::min(end, window_end);
+        if (overlap_end > overlap_begin) {
+            seconds += std::chrono::duration<double>(overlap_end - overlap_begin).count();
+        }
+    }
+    return seconds;
+}
+
+// Decode throughput of the surviving streams over part of the run
+struct Throughput {
+    double seconds = 0.0;
+    double stream_seconds = 0.0;
+    double completion_tokens = 0.0;
+
+    double per_stream() const {
+        return stream_seconds > 0 ? completion_tokens / stream_seconds : 0.0;
+    }
+
+    nlohmann::json to_json() const {
+        return {{"seconds", seconds},
+                {"completion_tokens", completion_tokens},
+                {"tokens_per_second", seconds > 0 ? completion_tokens / seconds : 0.0},
+                {"tokens_per_stream_second", per_stream()}};
+    }
+};
+
+}  // namespace
+
+AbortPlan plan_abort(const AbortConfig& config, const nlohmann::json& request, size_t index,
+                     unsigned int seed) {
+    AbortPlan plan;
+    if (!config.enabled() || !request.value("stream", true)) {
+        return plan;
+    }
+
+    std::mt19937_64 rng(seed ^ (static_cast<uint64_t>(index) * 0x9E3779B97F4A7C15ULL));
+    if (std::uniform_real_distribution<double>(0.0, 1.0)(rng) >= config.fraction) {
+        return plan;
+    }
+
+    plan.enabled = true;
+    plan.after_seconds = config.after_seconds;
+    if (config.after_tokens.has_value()) {
+        plan.after_chunks = std::max<size_t>(1, config.after_tokens.value());
+    } else if (!config.after_seconds.has_value()) {
+        size_t horizon = request.value(
+            "max_tokens", request.value("max_completion_tokens", kDefaultAbortHorizonTokens));
+        size_t latest = horizon > 1 ? horizon - 1 : 1;
+        plan.after_chunks = std::uniform_int_distribution<size_t>(1, latest)(rng);
+    }
+    return plan;
+}
+
+nlohmann::json summarize_aborts(const std::vector<CompletionStats>& all_completion_stats,
+                                double impact_window_seconds) {
+    size_t number_aborted = 0;
+    size_t wasted_chunks = 0;
+    double wasted_prompt_tokens = 0.0;
+    std::vector<std::chrono::steady_clock::time_point> abort_times;
+    for (const auto& completion_stats : all_completion_stats) {
+        if (!completion_stats.aborted) {
+            continue;
+        }
+        number_aborted++;
+        wasted_chunks += completion_stats.content_chunks();
+        wasted_prompt_tokens += RateLimiter::estimate_cost(completion_stats.input).prompt_tokens;
+        abort_times.push_back(completion_stats.end_time);
+    }
+    std::sort(abort_times.begin(), abort_times.end());
+
+    // A chunk is "after an abort" if an abort happened within the window before it
+    auto window = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(impact_window_seconds));
+    auto follows_abort = [&abort_times, window](std::chrono::steady_clock::time_point time) {
+        auto it = std::upper_bound(abort_times.begin(), abort_times.end(), time);
+        return it != abort_times.begin() && time - *std::prev(it) <= window;
+    };
+
+    // Surviving streams' decode phases, from their first to their last chunk,
+    // split by whether they overlap the windows after aborts. Aborted streams
+    // rarely report usage, so their chunks are scaled by the survivors'
+    // tokens per chunk.
+    auto windows = abort_windows(abort_times, window);
+    std::vector<double> survivor_ttft;
+    std::vector<double> itl_after_abort;
+    std::vector<double> itl_otherwise;
+    Throughput inside;
+    Throughput outside;
+    std::optional<Clock::time_point> span_begin;
+    std::optional<Clock::time_point> span_end;
+    size_t survivor_chunks = 0;
+    double survivor_tokens = 0.0;
+    for (const auto& completion_stats : all_completion_stats) {
+        if (completion_stats.aborted || !completion_stats.success) {
+            continue;
+        }
+        auto ttft = completion_stats.get_ttft_duration();
+        if (ttft.has_value()) {
+            survivor_ttft.push_back(ttft.value());
+        }
+        double tokens_per_chunk = request_tokens_per_chunk(completion_stats);
+        survivor_chunks += completion_stats.content_chunks();
+        survivor_tokens +=
+            tokens_per_chunk * static_cast<double>(completion_stats.content_chunks());
+        for (const auto& choice_stats : completion_stats.choices) {
+            const auto& times = choice_stats.chunk_times;
+            if (times.size() < 2) {
+                continue;
+            }
+            for (size_t i = 1; i < times.size(); ++i) {
+                double itl = seconds_between(times[i - 1], times[i]).value_or(0.0);
+                bool after_abort = follows_abort(times[i]);
+                (after_abort ? itl_after_abort : itl_otherwise).push_back(itl);
+                (after_abort ? inside : outside).completion_tokens += tokens_per_chunk;
+            }
+            double decode_seconds = seconds_between(times.front(), times.back()).value_or(0.0);
+            double windowed = seconds_in_windows(windows, times.front(), times.back());
+            inside.stream_seconds += windowed;
+            outside.stream_seconds += decode_seconds - windowed;
+            span_begin = std::min(span_begin.value_or(times.front()), times.front());
+            span_end = std::max(span_end.value_or(times.back()), times.back());
+        }
+    }
+    if (span_begin.has_value()) {
+        double span_seconds = seconds_between(*span_begin, *span_end).value_or(0.0);
+        inside.seconds = seconds_in_windows(windows, *span_begin, *span_end);
+        outside.seconds = span_seconds - inside.seconds;
+    }
+    double tokens_per_chunk =
+        survivor_chunks > 0 ? survivor_tokens / static_cast<double>(survivor_chunks) : 1.0;
+
+    return {{"number_aborted", number_aborted},
+            {"abort_rate", all_completion_stats.empty()
+                               ? 0.0
+                               : static_cast<double>(number_aborted) /
+                                     static_cast<double>(all_completion_stats.size())},
+            {"wasted_chunks", wasted_chunks},
+            {"survivor_tokens_per_chunk", tokens_per_chunk},
+            {"wasted_completion_tokens", static_cast<double>(wasted_chunks) * tokens_per_chunk},
+            {"wasted_prompt_tokens", wasted_prompt_tokens},
+            {"survivor_throughput",
+             {{"after_abort", inside.to_json()},
+              {"otherwise", outside.to_json()},
+              {"recovered_tokens_per_stream_second", inside.per_stream() - outside.per_stream()},
+              {"recovered_fraction", outside.per_stream() > 0
+                                         ? inside.per_stream() / outside.per_stream() - 1.0
+                                         : 0.0}}},
+            {"survivors",
+             {{"ttft_p50_seconds", percentile(survivor_ttft, 50)},
+              {"ttft_p99_seconds", percentile(survivor_ttft, 99)},
+              {"itl_after_abort_samples", itl_after_abort.size()},
+              {"itl_after_abort_p50_seconds", percentile(itl_after_abort, 50)},
+              {"itl_after_abort_p99_seconds", percentile(itl_after_abort, 99)},
+              {"itl_otherwise_samples", itl_otherwise.size()},
+              {"itl_otherwise_p50_seconds", percentile(itl_otherwise, 50)},
+              {"itl_otherwise_p99_seconds", percentile(itl_otherwise, 99)}}}};
+}
+
+}  // namespace bench_core
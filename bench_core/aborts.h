@@ -0,0 +1,49 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <vector>
+
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// Client-abort simulation: a fraction of streams is cancelled mid-generation,
+// like users closing a tab. A stream is cancelled by returning false from the
+// stream callback, which makes the HTTP client drop the connection. Limits are
+// checked as data arrives, so a time limit fires on the first chunk after it.
+struct AbortConfig {
+    double fraction = 0.0;
+    // Cancel after this many content chunks (about one token each)...
+    std::optional<size_t> after_tokens;
+    // ...or this many seconds after the request was sent. With neither set, each
+    // cancelled stream stops after a random number of tokens below max_tokens.
+    std::optional<double> after_seconds;
+    // Surviving streams' ITL within this long after an abort is reported
+    // separately, to show how quickly the server frees the capacity
+    double impact_window_seconds = 1.0;
+
+    bool enabled() const { return fraction > 0; }
+};
+
+// Decision for one request
+struct AbortPlan {
+    bool enabled = false;
+    size_t after_chunks = 0;  // 0 = no chunk limit
+    std::optional<double> after_seconds;
+};
+
+// Pick whether and when request `index` is cancelled. Deterministic for a
+// given seed and index, so a run can be repeated with the same cancellations.
+AbortPlan plan_abort(const AbortConfig& config, const nlohmann::json& request, size_t index,
+                     unsigned int seed);
+
+// Cancelled streams, the chunks they wasted (and the tokens, at the surviving
+// streams' tokens per chunk), and TTFT / ITL and decode throughput of the
+// streams that ran to completion, split by whether the chunk arrived shortly
+// after an abort. Throughput per stream-second inside versus outside those
+// windows is the capacity the aborts gave back to the survivors.
+nlohmann::json summarize_aborts(const std::vector<CompletionStats>& all_completion_stats,
+                                double impact_window_seconds);
+
+}  // namespace bench_core
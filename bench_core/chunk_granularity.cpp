@@ -0,0 +1,239 @@
+#include "bench_core/chunk_granularity.h"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+namespace bench_core {
+
+namespace {
+
+// Coalescing is reported when a signal exceeds its threshold
+constexpr double kCoalescedEventsPerRead = 1.5;
+constexpr double kMultiTokenChunks = 1.5;
+constexpr double kBurstyGapFraction = 0.5;
+
+struct ChoiceChunks {
+    std::vector<double> gaps;
+    size_t bursts = 0;
+    std::optional<double> smoothness;
+};
+
+ChoiceChunks analyze_choice(const ChoiceStats& choice_stats, double burst_gap_seconds) {
+    ChoiceChunks result;
+    const auto& times = choice_stats.chunk_times;
+    const auto& bytes = choice_stats.chunk_bytes;
+    if (times.empty()) {
+        return result;
+    }
+    result.bursts = 1;
+    for (size_t i = 1; i < times.size(); ++i) {
+        double gap = seconds_between(times[i - 1], times[i]).value_or(0.0);
+        result.gaps.push_back(gap);
+        if (gap >= burst_gap_seconds) {
+            result.bursts++;
+        }
+    }
+
+    // The first chunk ends the TTFT wait, so the decode phase starts with it
+    double span = seconds_between(times.front(), times.back()).value_or(0.0);
+    uint64_t decode_bytes = 0;
+    for (size_t i = 1; i < bytes.size(); ++i) {
+        decode_bytes += bytes[i];
+    }
+    if (span <= 0 || decode_bytes == 0 || bytes.size() != times.size()) {
+        return result;
+    }
+    uint64_t delivered = 0;
+    double deviation = 0.0;
+    for (size_t i = 1; i < times.size(); ++i) {
+        delivered += bytes[i];
+        double elapsed = seconds_between(times.front(), times[i]).value_or(0.0) / span;
+        deviation = std::max(deviation, std::abs(static_cast<double>(delivered) /
+                                                     static_cast<double>(decode_bytes) -
+                                                 elapsed));
+    }
+    result.smoothness = 1.0 - deviation;
+    return result;
+}
+
+nlohmann::json distribution_json(const std::vector<double>& values) {
+    if (values.empty()) {
+        return nullptr;
+    }
+    double sum = 0.0;
+    for (double value : values) {
+        sum += value;
+    }
+    return {{"mean", sum / static_cast<double>(values.size())},
+            {"p50", percentile(values, 50)},
+            {"p90", percentile(values, 90)},
+            {"p99", percentile(values, 99)},
+            {"max", *std::max_element(values.begin(), values.end())}};
+}
+
+double ratio(double numerator, double denominator) {
+    return denominator > 0 ? numerator / denominator : 0.0;
+}
+
+}  // namespace
+
+nlohmann::json summarize_request_chunks(const CompletionStats& stats,
+                                        const ChunkGranularityConfig& config) {
+    size_t chunks = stats.content_chunks();
+    if (chunks == 0) {
+        return nullptr;
+    }
+    std::vector<double> gaps;
+    size_t bursts = 0;
+    uint64_t total_bytes = 0;
+    uint32_t max_bytes = 0;
+    double smoothness_sum = 0.0;
+    size_t smoothness_count = 0;
+    for (const auto& choice_stats : stats.choices) {
+        auto choice_chunks = analyze_choice(choice_stats, config.burst_gap_seconds);
+        gaps.insert(gaps.end(), choice_chunks.gaps.begin(), choice_chunks.gaps.end());
+        bursts += choice_chunks.bursts;
+        if (choice_chunks.smoothness.has_value()) {
+            smoothness_sum += choice_chunks.smoothness.value();
+            smoothness_count++;
+        }
+        for (uint32_t size : choice_stats.chunk_bytes) {
+            total_bytes += size;
+            max_bytes = std::max(max_bytes, size);
+        }
+    }
+
+    nlohmann::json request_json = {
+        {"content_chunks", chunks},
+        {"mean_chunk_bytes", ratio(static_cast<double>(total_bytes), static_cast<double>(chunks))},
+        {"max_chunk_bytes", max_bytes},
+        {"bursts", bursts},
+        {"chunks_per_burst", ratio(static_cast<double>(chunks), static_cast<double>(bursts))},
+        {"sse_events", stats.sse_events},
+        {"stream_reads", stats.stream_reads},
+        {"events_per_read", ratio(static_cast<double>(stats.sse_events),
+                                  static_cast<double>(stats.stream_reads))}};
+    if (stats.api_usage.completion_tokens > 0) {
+        request_json["tokens_per_chunk"] = ratio(
+            static_cast<double>(stats.api_usage.completion_tokens), static_cast<double>(chunks));
+    }
+    if (!gaps.empty()) {
+        request_json["gap_p50_seconds"] = percentile(gaps, 50);
+        request_json["gap_p99_seconds"] = percentile(gaps, 99);
+        request_json["max_gap_seconds"] = *std::max_element(gaps.begin(), gaps.end());
+    }
+    if (smoothness_count > 0) {
+        request_json["smoothness"] = smoothness_sum / static_cast<double>(smoothness_count);
+    }
+    return request_json;
+}
+
+nlohmann::json summarize_chunk_granularity(const std::vector<CompletionStats>& all,
+                                           const ChunkGranularityConfig& config) {
+    size_t requests = 0;
+    size_t chunks = 0;
+    size_t bursts = 0;
+    size_t completion_tokens = 0;
+    size_t chunks_with_usage = 0;
+    size_t sse_events = 0;
+    size_t stream_reads = 0;
+    size_t coalesced_reads = 0;
+    size_t burst_gaps = 0;
+    std::vector<double> tokens_per_chunk;
+    std::vector<double> chunk_bytes;
+    std::vector<double> gaps;
+    std::vector<double> smoothness;
+    for (const auto& stats : all) {
+        size_t request_chunks = stats.content_chunks();
+        // Slow readers are throttled on purpose, which coalesces their events
+        if (!stats.success || stats.slow_reader || request_chunks == 0) {
+            continue;
+        }
+        requests++;
+        chunks += request_chunks;
+        sse_events += stats.sse_events;
+        stream_reads += stats.stream_reads;
+        coalesced_reads += stats.coalesced_reads;
+        if (stats.api_usage.completion_tokens > 0) {
+            completion_tokens += stats.api_usage.completion_tokens;
+            chunks_with_usage += request_chunks;
+            tokens_per_chunk.push_back(static_cast<double>(stats.api_usage.completion_tokens) /
+                                       static_cast<double>(request_chunks));
+        }
+        for (const auto& choice_stats : stats.choices) {
+            auto choice_chunks = analyze_choice(choice_stats, config.burst_gap_seconds);
+            bursts += choice_chunks.bursts;
+            for (double gap : choice_chunks.gaps) {
+                gaps.push_back(gap);
+                if (gap < config.burst_gap_seconds) {
+                    burst_gaps++;
+                }
+            }
+            if (choice_chunks.smoothness.has_value()) {
+                smoothness.push_back(choice_chunks.smoothness.value());
+            }
+            for (uint32_t size : choice_stats.chunk_bytes) {
+                chunk_bytes.push_back(static_cast<double>(size));
+            }
+        }
+    }
+    if (requests == 0) {
+        return nullptr;
+    }
+
+    double events_per_read =
+        ratio(static_cast<double>(sse_events), static_cast<double>(stream_reads));
+    double median_tokens_per_chunk = percentile(tokens_per_chunk, 50);
+    double burst_gap_fraction =
+        ratio(static_cast<double>(burst_gaps), static_cast<double>(gaps.size()));
+
+    nlohmann::json signals = nlohmann::json::array();
+    if (events_per_read > kCoalescedEventsPerRead) {
+        signals.push_back({{"signal", "coalesced_reads"},
+                           {"value", events_per_read},
+                           {"threshold", kCoalescedEventsPerRead},
+                           {"meaning",
+                            "SSE events arrive several per transport delivery: the stream was "
+                            "buffered and re-chunked before reaching the client"}});
+    }
+    if (median_tokens_per_chunk > kMultiTokenChunks) {
+        signals.push_back({{"signal", "multi_token_chunks"},
+                           {"value", median_tokens_per_chunk},
+                           {"threshold", kMultiTokenChunks},
+                           {"meaning",
+                            "the server packs several tokens per event: output batching or "
+                            "speculative decoding"}});
+    }
+    if (burst_gap_fraction > kBurstyGapFraction) {
+        signals.push_back({{"signal", "bursty_gaps"},
+                           {"value", burst_gap_fraction},
+                           {"threshold", kBurstyGapFraction},
+                           {"meaning", "most chunks arrive right behind the previous one"}});
+    }
+
+    nlohmann::json smoothness_json = nullptr;
+    if (!smoothness.empty()) {
+        smoothness_json = distribution_json(smoothness);
+        smoothness_json["p10"] = percentile(smoothness, 10);
+    }
+    return {{"requests", requests},
+            {"burst_gap_seconds", config.burst_gap_seconds},
+            {"content_chunks", chunks},
+            {"tokens_per_chunk",
+             {{"overall", ratio(static_cast<double>(completion_tokens),
+                                static_cast<double>(chunks_with_usage))},
+              {"p50", median_tokens_per_chunk},
+              {"p90", percentile(tokens_per_chunk, 90)}}},
+            {"chunk_bytes", distribution_json(chunk_bytes)},
+            {"gap_seconds", distribution_json(gaps)},
+            {"burst_gap_fraction", burst_gap_fraction},
+            {"chunks_per_burst", ratio(static_cast<double>(chunks), static_cast<double>(bursts))},
+            {"events_per_read", events_per_read},
+            {"coalesced_read_fraction",
+             ratio(static_cast<double>(coalesced_reads), static_cast<double>(stream_reads))},
+            {"smoothness", smoothness_json},
+            {"coalescing", {{"detected", !signals.empty()}, {"signals", signals}}}};
+}
+
+}  // namespace bench_core
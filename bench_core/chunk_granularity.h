@@ -0,0 +1,35 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// How generated text is cut into SSE events and how evenly the events reach
+// the client. Servers may pack several tokens into one event (output batching,
+// speculative decoding), and intermediaries may buffer events and deliver
+// them together; either way users see bursts instead of a steady stream.
+struct ChunkGranularityConfig {
+    bool enabled = false;
+    // Chunks arriving closer than this after the previous one belong to the
+    // same burst, i.e. the same visible update
+    double burst_gap_seconds = 0.001;
+};
+
+// Per-request tokens per chunk, chunk sizes, inter-chunk gaps, bursts, SSE
+// events per network read and smoothness. Null for requests without streamed
+// content.
+nlohmann::json summarize_request_chunks(const CompletionStats& stats,
+                                        const ChunkGranularityConfig& config);
+
+// The same over all successful streams (slow readers excluded), with the
+// coalescing signals that fired. Smoothness is 1 minus the largest gap
+// between the share of decode-phase text delivered and the share of the
+// decode time elapsed, measured at every chunk: 1 for text arriving at an
+// even rate, lower for stalls followed by bursts.
+nlohmann::json summarize_chunk_granularity(const std::vector<CompletionStats>& all,
+                                           const ChunkGranularityConfig& config);
+
+}  // namespace bench_core
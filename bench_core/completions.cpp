@@ -0,0 +1,495 @@
+#include "bench_core/completions.h"
+
+#include <chrono>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "bench_core/http_client.h"
+#include "bench_core/log.h"
+#include "bench_core/structured_output.h"
+
+namespace bench_core {
+
+namespace {
+
+// Apply one decoded tool call (a streamed delta or a complete message entry)
+// at default_index unless the entry carries its own index; returns the
+// argument bytes added
+size_t apply_tool_call(ChoiceStats& choice_stats, const nlohmann::json& call,
+                       size_t default_index, TextPolicy policy) {
+    auto& tool_call = choice_stats.tool_call(call.value("index", default_index));
+    tool_call.number_of_deltas++;
+    if (tool_call.id.empty() && call.contains("id") && call["id"].is_string()) {
+        tool_call.id = call["id"].get<std::string>();
+    }
+    if (!call.contains("function") || !call["function"].is_object()) {
+        return 0;
+    }
+    const auto& function = call["function"];
+    if (tool_call.name.empty() && function.contains("name") && function["name"].is_string()) {
+        tool_call.name = function["name"].get<std::string>();
+    }
+    if (!function.contains("arguments") || !function["arguments"].is_string()) {
+        return 0;
+    }
+    const auto& arguments = function["arguments"].get_ref<const std::string&>();
+    tool_call.append_arguments(arguments, policy);
+    return arguments.size();
+}
+
+// Incremental SSE parser feeding one CompletionStats, shared by both transports
+class CompletionStreamParser {
+public:
+    CompletionStreamParser(CompletionStats& stats, const AbortPlan& abort)
+        : stats_(stats), abort_(abort) {}
+
+    // Consume the next piece of the stream; returns false to stop streaming.
+    // Every call is one delivery from the transport (an HTTP chunk or DATA
+    // frame), so events completed per call show whether they were coalesced
+    // before being written to the wire.
+    bool feed(std::string_view data) {
+        size_t events_before = stats_.sse_events;
+        bool keep_streaming = feed_lines(data);
+        size_t events = stats_.sse_events - events_before;
+        if (events > 0) {
+            stats_.stream_reads++;
+        }
+        if (events > 1) {
+            stats_.coalesced_reads++;
+        }
+        return keep_streaming;
+    }
+
+private:
+    bool feed_lines(std::string_view data) {
+        buffer_ += data;
+
+        // Process complete lines from the buffer
+        size_t pos = 0;
+        while ((pos = buffer_.find('\n')) != std::string::npos) {
+            if (should_abort()) {
+                return false;
+            }
+            std::string line = buffer_.substr(0, pos);
+            buffer_.erase(0, pos + 1);
+
+            // Trim whitespace
+            line.erase(0, line.find_first_not_of(" \r\n"));
+            line.erase(line.find_last_not_of(" \r\n") + 1);
+
+            // Skip empty lines
+            if (line.empty()) {
+                continue;
+            }
+
+            // Handle SSE format - check for data: prefix
+            if (line.starts_with("data:")) {
+                std::string json_data = line.substr(5);
+                // Trim whitespace after data: prefix
+                json_data.erase(0, json_data.find_first_not_of(' '));
+                json_data.erase(json_data.find_last_not_of(' ') + 1);
+
+                stats_.sse_events++;
+
+                // Handle [DONE] message
+                if (json_data == "[DONE]") {
+                    stats_.end_time = std::chrono::steady_clock::now();
+                    continue;
+                }
+
+                // Skip empty JSON data
+                if (json_data.empty()) {
+                    continue;
+                }
+
+                // Fast path: decode content straight from the raw chunk. The small
+                // usage / time_info objects of the final chunk still use nlohmann.
+                if (scan_stream_chunk(json_data, chunk_view_)) {
+                    for (const auto& choice : chunk_view_.choices) {
+                        if (choice.content.has_value()) {
+                            stats_.add_choice_escaped(choice.index, choice.content.value());
+                        }
+                        if (!choice.tool_calls.empty()) {
+                            apply_tool_call_deltas(choice);
+                        }
+                        if (choice.finish_reason.has_value()) {
+                            auto& choice_stats = stats_.choice(choice.index);
+                            choice_stats.finish_reason.clear();
+                            JsonStringDecoder().decode(choice.finish_reason.value(),
+                                                       choice_stats.finish_reason);
+                            choice_stats.end_time = std::chrono::steady_clock::now();
+                        }
+                    }
+                    stats_.number_of_chunks++;
+
+                    try {
+                        if (!chunk_view_.usage.empty() && chunk_view_.usage != "null") {
+                            stats_.api_usage = CompletionStats::UsageDetails::from_json(
+                                nlohmann::json::parse(chunk_view_.usage));
+                        }
+                        if (!chunk_view_.time_info.empty() && chunk_view_.time_info != "null") {
+                            stats_.api_time_info = CompletionStats::TimeInfo::from_json(
+                                nlohmann::json::parse(chunk_view_.time_info));
+                        }
+                    } catch (const nlohmann::json::exception& e) {
+                        log_message(LogLevel::kError, "stream_parse",
+                                    "JSON parse error: " + std::string(e.what()));
+                        stats_.success = false;
+                        stats_.error_message = e.what();
+                        return false;
+                    }
+                    continue;
+                }
+
+                // Try to parse JSON and log any errors
+                nlohmann::json chunk;
+                try {
+                    chunk = nlohmann::json::parse(json_data);
+                } catch (const nlohmann::json::parse_error& e) {
+                    log_message(LogLevel::kError, "stream_parse",
+                                "JSON parse error: " + std::string(e.what()) + ", failed data: '" +
+                                    json_data + "'");
+                    stats_.success = false;
+                    stats_.error_message = e.what();
+                    return false;  // Stop streaming on parse error
+                }
+
+                // Extract content from delta or direct text, demultiplexed by choice index.
+                // TTFT is recorded on the first chunk that carries actual content.
+                if (chunk.contains("choices")) {
+                    for (const auto& choice : chunk["choices"]) {
+                        size_t index = choice.value("index", 0);
+
+                        // Handle streaming format with delta.content
+                        if (choice.contains("delta")) {
+                            const auto& delta = choice["delta"];
+                            if (delta.contains("content") && !delta["content"].is_null()) {
+                                stats_.add_choice_text(
+                                    index, delta["content"].get_ref<const std::string&>());
+                            }
+                            if (delta.contains("tool_calls") && delta["tool_calls"].is_array() &&
+                                !delta["tool_calls"].empty()) {
+                                auto& choice_stats = stats_.record_choice_chunk(index);
+                                for (const auto& call : delta["tool_calls"]) {
+                                    stats_.add_chunk_bytes(
+                                        choice_stats,
+                                        apply_tool_call(choice_stats, call, 0, stats_.text_policy));
+                                }
+                            }
+                        }
+                        // Handle non-streaming format with direct text
+                        else if (choice.contains("text") && !choice["text"].is_null()) {
+                            stats_.add_choice_text(index,
+                                                  choice["text"].get_ref<const std::string&>());
+                        }
+
+                        if (choice.contains("finish_reason") &&
+                            !choice["finish_reason"].is_null()) {
+                            auto& choice_stats = stats_.choice(index);
+                            choice_stats.finish_reason = choice["finish_reason"];
+                            choice_stats.end_time = std::chrono::steady_clock::now();
+                        }
+                    }
+                }
+                stats_.number_of_chunks++;
+
+                // Extract usage information from final chunk
+                if (chunk.contains("usage") && !chunk["usage"].is_null()) {
+                    stats_.api_usage = CompletionStats::UsageDetails::from_json(chunk["usage"]);
+                }
+
+                // Extract time information from final chunk
+                if (chunk.contains("time_info") && !chunk["time_info"].is_null()) {
+                    stats_.api_time_info = CompletionStats::TimeInfo::from_json(chunk["time_info"]);
+                }
+            }
+            // Ignore other SSE event types (like event:, id:, retry:, etc.)
+        }
+
+        return !should_abort();
+    }
+
+    // Tool-call deltas count as output chunks, so TTFT and inter-token gaps
+    // cover requests that answer with a tool call rather than text
+    void apply_tool_call_deltas(const StreamChunkView::Choice& choice) {
+        auto& choice_stats = stats_.record_choice_chunk(choice.index);
+        for (const auto& delta : choice.tool_calls) {
+            auto& tool_call = choice_stats.tool_call(delta.index);
+            tool_call.number_of_deltas++;
+            if (delta.id.has_value() && tool_call.id.empty()) {
+                JsonStringDecoder().decode(delta.id.value(), tool_call.id);
+            }
+            if (delta.name.has_value() && tool_call.name.empty()) {
+                JsonStringDecoder().decode(delta.name.value(), tool_call.name);
+            }
+            if (delta.arguments.has_value()) {
+                size_t before = tool_call.arguments_length;
+                tool_call.append_arguments_escaped(delta.arguments.value(), stats_.text_policy);
+                stats_.add_chunk_bytes(choice_stats, tool_call.arguments_length - before);
+            }
+        }
+    }
+
+    // Check the abort plan, marking the request as cancelled once it fires
+    bool should_abort() {
+        if (!abort_.enabled) {
+            return false;
+        }
+        if (!stats_.aborted) {
+            auto now = std::chrono::steady_clock::now();
+            bool chunk_limit = abort_.after_chunks > 0 &&
+                               stats_.content_chunks() >= abort_.after_chunks;
+            bool time_limit =
+                abort_.after_seconds.has_value() &&
+                seconds_between(stats_.start_time, now).value_or(0.0) >= abort_.after_seconds;
+            if (!chunk_limit && !time_limit) {
+                return false;
+            }
+            stats_.aborted = true;
+            stats_.end_time = now;
+        }
+        return true;
+    }
+
+    CompletionStats& stats_;
+    const AbortPlan& abort_;
+    // Buffer to accumulate streaming data chunks
+    std::string buffer_;
+    StreamChunkView chunk_view_;
+};
+
+// Fill stats from a non-streaming response body
+void apply_response(const nlohmann::json& raw_json, const std::string& content,
+                    CompletionStats& stats) {
+    // Extract content from choices[].text for non-streaming responses
+    if (raw_json.contains("choices") && !raw_json["choices"].empty()) {
+        for (const auto& choice : raw_json["choices"]) {
+            auto& choice_stats = stats.choice(choice.value("index", 0));
+            if (choice.contains("text") && !choice["text"].is_null()) {
+                choice_stats.append_text(choice["text"].get_ref<const std::string&>(),
+                                         stats.text_policy);
+                choice_stats.number_of_chunks = 1;
+            }
+            // Chat responses carry a message instead
+            if (choice.contains("message") && choice["message"].is_object()) {
+                const auto& message = choice["message"];
+                if (message.contains("content") && message["content"].is_string()) {
+                    choice_stats.append_text(message["content"].get_ref<const std::string&>(),
+                                             stats.text_policy);
+                    choice_stats.number_of_chunks = 1;
+                }
+                if (message.contains("tool_calls") && message["tool_calls"].is_array()) {
+                    for (const auto& call : message["tool_calls"]) {
+                        apply_tool_call(choice_stats, call, choice_stats.tool_calls.size(),
+                                        stats.text_policy);
+                    }
+                    choice_stats.number_of_chunks = 1;
+                }
+            }
+            if (choice.contains("finish_reason") && !choice["finish_reason"].is_null()) {
+                choice_stats.finish_reason = choice["finish_reason"];
+            }
+            choice_stats.end_time = stats.end_time;
+        }
+    } else {
+        // Fallback to content if no choices structure
+        auto& choice_stats = stats.choice(0);
+        choice_stats.append_text(content, stats.text_policy);
+        choice_stats.end_time = stats.end_time;
+    }
+
+    // Record TTFT only if we have actual content
+    for (auto& choice_stats : stats.choices) {
+        if (choice_stats.output_length > 0 || !choice_stats.tool_calls.empty()) {
+            choice_stats.ttft_time = stats.end_time;
+            stats.ttft_time = stats.end_time;
+        }
+    }
+
+    if (raw_json.contains("usage")) {
+        stats.api_usage = CompletionStats::UsageDetails::from_json(raw_json["usage"]);
+    }
+    if (raw_json.contains("time_info")) {
+        stats.api_time_info = CompletionStats::TimeInfo::from_json(raw_json["time_info"]);
+    }
+}
+
+// Request body for the libcurl transport: the request as given, minus the
+// fields that only label it for this tool
+std::string completion_request_body(const nlohmann::json& request, const std::string& model) {
+    nlohmann::json body = request;
+    body.erase("tag");
+    body.erase("tags");
+    body.erase(kStructuredBaselineField);
+    body["model"] = model;
+    body["stream"] = request.value("stream", true);
+    return body.dump();
+}
+
+// Feeds a streamed completion into the SSE parser, or buffers error and
+// non-streaming bodies, recording the selected response headers on the way
+class CompletionHttpHandler : public HttpStreamHandler {
+public:
+    CompletionHttpHandler(CompletionStats& stats, const HeaderCapture& capture,
+                          const AbortPlan& abort, bool is_streaming)
+        : stats_(stats), capture_(capture), abort_(abort), is_streaming_(is_streaming) {}
+
+    void on_status(long status_code) override {
+        status_code_ = status_code;
+        body_.clear();
+        stats_.response_headers.clear();
+        stats_.headers_time = std::chrono::steady_clock::now();
+    }
+
+    void on_header(std::string_view name, std::string_view value) override {
+        capture_.capture(name, value, stats_.response_headers);
+    }
+
+    bool on_data(std::string_view data) override {
+        if (is_streaming_ && status_code_ < 300) {
+            if (!parser_.has_value()) {
+                parser_.emplace(stats_, abort_);
+            }
+            return parser_->feed(data);
+        }
+        body_.append(data);
+        return true;
+    }
+
+    const std::string& body() const { return body_; }
+
+private:
+    CompletionStats& stats_;
+    const HeaderCapture& capture_;
+    const AbortPlan& abort_;
+    bool is_streaming_;
+    long status_code_ = 0;
+    std::string body_;
+    std::optional<CompletionStreamParser> parser_;
+};
+
+}  // namespace
+
+bool is_chat_request(const nlohmann::json& request) { return request.contains("messages"); }
+
+CompletionStats do_completion(const nlohmann::json& request, const liboai::OpenAI& oai,
+                              const std::string& model, TextPolicy text_policy,
+                              bool record_chunk_bytes, const AbortPlan& abort) {
+    CompletionStats stats;
+    stats.start_time = std::chrono::steady_clock::now();
+    stats.input = request;
+    stats.text_policy = text_policy;
+    stats.record_chunk_bytes = record_chunk_bytes;
+
+    CompletionStreamParser parser(stats, abort);
+    liboai::Completions::StreamCallback stream_callback =
+        [&parser](std::string data, intptr_t /*userdata*/) -> bool { return parser.feed(data); };
+
+    try {
+        bool is_streaming = request.value("stream", true);
+
+        liboai::Response response = oai.Completion->create(
+            model,
+            request.contains("prompt") ? std::make_optional(request["prompt"].get<std::string>())
+                                       : std::nullopt,
+            request.contains("suffix") ? std::make_optional(request["suffix"].get<std::string>())
+                                       : std::nullopt,
+            request.contains("max_tokens")
+                ? std::make_optional(request["max_tokens"].get<uint16_t>())
+                : std::nullopt,
+            request.contains("temperature")
+                ? std::make_optional(request["temperature"].get<float>())
+                : std::nullopt,
+            request.contains("top_p") ? std::make_optional(request["top_p"].get<float>())
+                                      : std::nullopt,
+            request.contains("n") ? std::make_optional(request["n"].get<uint16_t>()) : std::nullopt,
+            is_streaming ? std::make_optional(stream_callback) : std::nullopt,
+            request.contains("logprobs") ? std::make_optional(request["logprobs"].get<uint8_t>())
+                                         : std::nullopt,
+            request.contains("echo") ? std::make_optional(request["echo"].get<bool>())
+                                     : std::nullopt,
+            request.contains("stop")
+                ? std::make_optional(request["stop"].get<std::vector<std::string>>())
+                : std::nullopt,
+            request.contains("presence_penalty")
+                ? std::make_optional(request["presence_penalty"].get<float>())
+                : std::nullopt,
+            request.contains("frequency_penalty")
+                ? std::make_optional(request["frequency_penalty"].get<float>())
+                : std::nullopt,
+            request.contains("best_of") ? std::make_optional(request["best_of"].get<uint16_t>())
+                                        : std::nullopt,
+            request.contains("logit_bias")
+                ? std::make_optional(
+                      request["logit_bias"].get<std::unordered_map<std::string, int8_t>>())
+                : std::nullopt,
+            request.contains("user") ? std::make_optional(request["user"].get<std::string>())
+                                     : std::nullopt);
+        if (!stats.aborted) {
+            stats.end_time = std::chrono::steady_clock::now();
+        }
+
+        if (!is_streaming) {
+            apply_response(response.raw_json, response.content, stats);
+        }
+    } catch (const std::exception& e) {
+        // liboai reports a stream cancelled by the callback as an error
+        if (!stats.aborted) {
+            stats.success = false;
+            stats.error_message = e.what();
+            stats.end_time = std::chrono::steady_clock::now();
+        }
+    }
+    stats.finish_choices();
+    return stats;
+}
+
+CompletionStats do_completion_http(const nlohmann::json& request,
+                                   const std::string& api_endpoint, const std::string& api_key,
+                                   const std::string& model, TextPolicy text_policy,
+                                   bool record_chunk_bytes, const HeaderCapture& capture,
+                                   const AbortPlan& abort, const HttpOptions& http) {
+    CompletionStats stats;
+    stats.start_time = std::chrono::steady_clock::now();
+    stats.input = request;
+    stats.text_policy = text_policy;
+    stats.record_chunk_bytes = record_chunk_bytes;
+    stats.validate_json_output = expects_json_output(request);
+
+    try {
+        bool is_streaming = request.value("stream", true);
+        CompletionHttpHandler handler(stats, capture, abort, is_streaming);
+        std::string path = is_chat_request(request) ? "/chat/completions" : "/completions";
+        HttpTransfer transfer = http_post_stream(api_endpoint + path, api_key,
+                                                 completion_request_body(request, model),
+                                                 handler, http);
+        long status_code = transfer.status_code;
+        stats.new_connection = transfer.new_connection;
+        stats.tcp_info = transfer.tcp_info;
+        stats.remote_address = std::move(transfer.remote_address);
+        stats.wire = std::move(transfer.wire);
+        if (!stats.aborted) {
+            stats.end_time = std::chrono::steady_clock::now();
+        }
+
+        if (status_code >= 300) {
+            stats.success = false;
+            stats.error_message =
+                "HTTP " + std::to_string(status_code) + ": " + handler.body().substr(0, 512);
+        } else if (!is_streaming) {
+            apply_response(nlohmann::json::parse(handler.body()), handler.body(), stats);
+        }
+    } catch (const std::exception& e) {
+        stats.success = false;
+        stats.error_message = e.what();
+        stats.end_time = std::chrono::steady_clock::now();
+        if (const auto* transport_error = dynamic_cast<const HttpTransportError*>(&e)) {
+            stats.remote_address = transport_error->remote_address();
+        }
+    }
+    stats.finish_choices();
+    return stats;
+}
+
+}  // namespace bench_core
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <string>
+
+#include "bench_core/aborts.h"
+#include "bench_core/headers.h"
+#include "bench_core/http_client.h"
+#include "bench_core/stats.h"
+#include "liboai.h"
+
+namespace bench_core {
+
+// Chat requests carry "messages" and go to /chat/completions. liboai only
+// wraps /completions, so they always use the libcurl transport.
+bool is_chat_request(const nlohmann::json& request);
+
+// Issue one /completions request (streaming unless the request sets
+// "stream": false) and collect its timing, usage and per-choice output. The
+// stream is cancelled early if the abort plan says so. Per-chunk byte counts
+// are kept only with record_chunk_bytes, for chunk granularity analytics.
+CompletionStats do_completion(const nlohmann::json& request, const liboai::OpenAI& oai,
+                              const std::string& model, TextPolicy text_policy,
+                              bool record_chunk_bytes, const AbortPlan& abort = {});
+
+// Same request over the libcurl transport, which also exposes the response
+// headers selected by capture. Request fields are passed through unchanged, so
+// chat requests may use response_format and tools: streamed tool-call
+// arguments are reassembled, and JSON outputs validated as they arrive.
+CompletionStats do_completion_http(const nlohmann::json& request,
+                                   const std::string& api_endpoint, const std::string& api_key,
+                                   const std::string& model, TextPolicy text_policy,
+                                   bool record_chunk_bytes, const HeaderCapture& capture,
+                                   const AbortPlan& abort = {},
+                                   const HttpOptions& http = {});
+
+}  // namespace bench_core
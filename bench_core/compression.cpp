@@ -0,0 +1,188 @@
+#include "bench_core/compression.h"
+
+#include <curl/curl.h>
+
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace bench_core {
+
+namespace {
+
+// Bytes and latency of the requests sharing one Accept-Encoding value
+struct EncodingGroup {
+    size_t requests = 0;
+    std::map<std::string, size_t> content_encodings;
+    size_t request_bytes = 0;
+    size_t response_bytes = 0;
+    size_t response_body_bytes = 0;
+    size_t decoded_body_bytes = 0;
+    size_t content_bytes = 0;
+    size_t completion_tokens = 0;
+    std::vector<double> ttfts;
+    std::vector<double> itls;
+
+    void add(const CompletionStats& stats) {
+        const auto& wire = stats.wire;
+        requests++;
+        content_encodings[wire.content_encoding.empty() ? "identity" : wire.content_encoding]++;
+        request_bytes += wire.request_bytes();
+        response_bytes += wire.response_bytes();
+        response_body_bytes += wire.response_body_bytes;
+        decoded_body_bytes += wire.decoded_body_bytes;
+        content_bytes += stats.content_bytes();
+        completion_tokens += stats.api_usage.completion_tokens;
+        if (!stats.success) {
+            return;
+        }
+        if (auto ttft = stats.get_ttft_duration(); ttft.has_value()) {
+            ttfts.push_back(ttft.value());
+        }
+        for (const auto& choice_stats : stats.choices) {
+            const auto& times = choice_stats.chunk_times;
+            for (size_t i = 1; i < times.size(); ++i) {
+                itls.push_back(seconds_between(times[i - 1], times[i]).value_or(0.0));
+            }
+        }
+    }
+
+    double bytes_per_token(size_t bytes) const {
+        return completion_tokens > 0
+                   ? static_cast<double>(bytes) / static_cast<double>(completion_tokens)
+                   : 0.0;
+    }
+
+    nlohmann::json to_json() const {
+        return {{"requests", requests},
+                {"content_encodings", content_encodings},
+                {"request_bytes", request_bytes},
+                {"response_bytes", response_bytes},
+                {"decoded_body_bytes", decoded_body_bytes},
+                {"compression_ratio", response_body_bytes > 0
+                                          ? static_cast<double>(decoded_body_bytes) /
+                                                static_cast<double>(response_body_bytes)
+                                          : 0.0},
+                {"sse_framing_fraction",
+                 decoded_body_bytes > content_bytes
+                     ? static_cast<double>(decoded_body_bytes - content_bytes) /
+                           static_cast<double>(decoded_body_bytes)
+                     : 0.0},
+                {"response_bytes_per_output_token", bytes_per_token(response_bytes)},
+                {"decoded_bytes_per_output_token", bytes_per_token(decoded_body_bytes)},
+                {"ttft_p50_seconds", percentile(ttfts, 50)},
+                {"ttft_p99_seconds", percentile(ttfts, 99)},
+                {"itl_p50_seconds", percentile(itls, 50)},
+                {"itl_p99_seconds", percentile(itls, 99)}};
+    }
+};
+
+}  // namespace
+
+void check_accept_encoding(const std::string& value) {
+    const curl_version_info_data* info = curl_version_info(CURLVERSION_NOW);
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        // Drop whitespace and a quality value such as ";q=0.5"
+        item = item.substr(0, item.find(';'));
+        size_t begin = item.find_first_not_of(' ');
+        if (begin == std::string::npos) {
+            continue;
+        }
+        std::string encoding = item.substr(begin, item.find_last_not_of(' ') + 1 - begin);
+        bool supported = false;
+        if (encoding == "identity") {
+            supported = true;
+        } else if (encoding == "gzip" || encoding == "deflate") {
+            supported = (info->features & CURL_VERSION_LIBZ) != 0;
+        } else if (encoding == "br") {
+            supported = (info->features & CURL_VERSION_BROTLI) != 0;
+        } else if (encoding == "zstd") {
+            supported = (info->features & CURL_VERSION_ZSTD) != 0;
+        } else {
+            throw std::invalid_argument("Unknown content encoding: " + encoding);
+        }
+        if (!supported) {
+            throw std::invalid_argument("libcurl was built without support for " + encoding);
+        }
+    }
+}
+
+bool select_compressed(const CompressionConfig& config, size_t index, unsigned int seed) {
+    if (!config.enabled()) {
+        return false;
+    }
+    if (config.fraction >= 1.0) {
+        return true;
+    }
+    // Independent of the abort and slow-reader selections
+    std::mt19937_64 rng((seed + 0xC0u) ^ (static_cast<uint64_t>(index) * 0x94D049BB133111EBULL));
+    return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < config.fraction;
+}
+
+nlohmann::json summarize_wire_bytes(const std::vector<CompletionStats>& all,
+                                    std::chrono::steady_clock::time_point start_time,
+                                    std::chrono::steady_clock::time_point end_time) {
+    std::map<std::string, EncodingGroup> groups;
+    size_t requests = 0;
+    size_t request_bytes = 0;
+    size_t response_bytes = 0;
+    for (const auto& stats : all) {
+        if (!stats.wire.recorded()) {
+            continue;
+        }
+        requests++;
+        request_bytes += stats.wire.request_bytes();
+        response_bytes += stats.wire.response_bytes();
+        groups[stats.wire.accept_encoding.empty() ? "identity" : stats.wire.accept_encoding].add(
+            stats);
+    }
+    if (requests == 0) {
+        return nullptr;
+    }
+
+    double duration = seconds_between(start_time, end_time).value_or(0.0);
+    nlohmann::json by_encoding = nlohmann::json::object();
+    for (const auto& [encoding, group] : groups) {
+        by_encoding[encoding] = group.to_json();
+    }
+    nlohmann::json report = {
+        {"duration_seconds", duration},
+        {"requests", requests},
+        {"request_bytes", request_bytes},
+        {"response_bytes", response_bytes},
+        {"request_bytes_per_second", duration > 0 ? request_bytes / duration : 0.0},
+        {"response_bytes_per_second", duration > 0 ? response_bytes / duration : 0.0},
+        {"by_accept_encoding", by_encoding}};
+
+    // What each encoding buys in bytes and costs in latency, against the
+    // requests that did not ask for compression
+    auto identity = groups.find("identity");
+    if (identity != groups.end() && groups.size() > 1) {
+        const auto& baseline = identity->second;
+        double baseline_bytes = baseline.bytes_per_token(baseline.response_bytes);
+        nlohmann::json comparison = nlohmann::json::object();
+        for (const auto& [encoding, group] : groups) {
+            if (encoding == "identity") {
+                continue;
+            }
+            double bytes = group.bytes_per_token(group.response_bytes);
+            comparison[encoding] = {
+                {"response_bytes_per_output_token_ratio",
+                 baseline_bytes > 0 ? bytes / baseline_bytes : 0.0},
+                {"bytes_saved_fraction", baseline_bytes > 0 ? 1.0 - bytes / baseline_bytes : 0.0},
+                {"ttft_p50_delta_seconds",
+                 percentile(group.ttfts, 50) - percentile(baseline.ttfts, 50)},
+                {"itl_p50_delta_seconds",
+                 percentile(group.itls, 50) - percentile(baseline.itls, 50)},
+                {"itl_p99_delta_seconds",
+                 percentile(group.itls, 99) - percentile(baseline.itls, 99)}};
+        }
+        report["compression"] = comparison;
+    }
+    return report;
+}
+
+}  // namespace bench_core
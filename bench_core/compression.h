@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// Compressed responses trade egress bandwidth for encoder work on the server
+// and decoder work (and possible buffering) on the client. A fraction of the
+// requests can ask for compression, so one run measures both sides of the
+// trade under the same load.
+struct CompressionConfig {
+    // Accept-Encoding value, e.g. "gzip" or "zstd, br"; empty = no header
+    std::string accept_encoding;
+    // Fraction of requests sending it, chosen with the run's seed
+    double fraction = 1.0;
+
+    bool enabled() const { return !accept_encoding.empty(); }
+};
+
+// Check that every encoding in an Accept-Encoding value is one libcurl was
+// built to decode (gzip/deflate need zlib, br brotli, zstd zstd); throws
+// std::invalid_argument otherwise
+void check_accept_encoding(const std::string& value);
+
+// Whether the request at index asks for a compressed response
+bool select_compressed(const CompressionConfig& config, size_t index, unsigned int seed);
+
+// Wire bytes of the run and egress rates, and per requested encoding: bytes
+// per output token before and after decoding, compression ratio, SSE framing
+// share, and TTFT/ITL, compared against the uncompressed requests. Null when
+// no request recorded wire bytes.
+nlohmann::json summarize_wire_bytes(const std::vector<CompletionStats>& all,
+                                    std::chrono::steady_clock::time_point start_time,
+                                    std::chrono::steady_clock::time_point end_time);
+
+}  // namespace bench_core
@@ -0,0 +1,317 @@
+#include "bench_core/convergence.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "bench_core/trials.h"
+
+namespace bench_core {
+
+namespace {
+
+struct Interval {
+    double estimate = 0.0;
+    double low = 0.0;
+    double high = 0.0;
+    bool sufficient = false;
+};
+
+// Student's t interval from Welford's running mean and sum of squared deviations
+Interval mean_interval(size_t n, double mean, double squared_deviations, double confidence) {
+    Interval interval;
+    if (n < 2) {
+        return interval;
+    }
+    double stddev = std::sqrt(squared_deviations / static_cast<double>(n - 1));
+    double half_width = t_critical(confidence, n - 1) * stddev / std::sqrt(static_cast<double>(n));
+    return {mean, mean - half_width, mean + half_width, true};
+}
+
+// Order statistics bracketing the percentile of sorted values: the rank of the
+// sample p-quantile is Binomial(n, q), approximated as normal
+Interval percentile_interval(const std::vector<double>& values, double p, double confidence) {
+    Interval interval;
+    size_t n = values.size();
+    if (n < 2) {
+        return interval;
+    }
+    // Same interpolation as percentile(), without copying and sorting again
+    double q = p / 100.0;
+    double rank = q * static_cast<double>(n - 1);
+    auto lower = static_cast<size_t>(std::floor(rank));
+    auto upper = static_cast<size_t>(std::ceil(rank));
+    interval.estimate = values[lower] + (values[upper] - values[lower]) *
+                                            (rank - static_cast<double>(lower));
+    double spread =
+        z_critical(confidence) * std::sqrt(static_cast<double>(n) * q * (1.0 - q));
+    double low_rank = std::floor(static_cast<double>(n) * q - spread);
+    double high_rank = std::ceil(static_cast<double>(n) * q + spread);
+    // Too few samples beyond the percentile to bound it yet
+    interval.sufficient = low_rank >= 0 && high_rank <= static_cast<double>(n - 1);
+    interval.low = values[static_cast<size_t>(std::max(0.0, low_rank))];
+    interval.high =
+        values[static_cast<size_t>(std::min(high_rank, static_cast<double>(n - 1)))];
+    return interval;
+}
+
+}  // namespace
+
+std::string ConvergenceMetric::name() const {
+    std::string source_name;
+    switch (source) {
+        case Source::kTtft:
+            source_name = "ttft";
+            break;
+        case Source::kItl:
+            source_name = "itl";
+            break;
+        case Source::kLatency:
+            source_name = "latency";
+            break;
+        case Source::kTokensPerSecond:
+            source_name = "tokens_per_second";
+            break;
+    }
+    if (is_mean()) {
+        return source_name + ":mean";
+    }
+    std::ostringstream statistic;
+    statistic << source_name << ":p" << percentile;
+    return statistic.str();
+}
+
+std::vector<ConvergenceMetric> parse_convergence_metrics(const std::string& value) {
+    std::vector<ConvergenceMetric> metrics;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        size_t colon = item.find(':');
+        if (colon == std::string::npos) {
+            throw std::invalid_argument("Convergence metric must be SOURCE:STATISTIC: " + item);
+        }
+        std::string source = item.substr(0, colon);
+        std::string statistic = item.substr(colon + 1);
+
+        ConvergenceMetric metric;
+        if (source == "ttft") {
+            metric.source = ConvergenceMetric::Source::kTtft;
+        } else if (source == "itl") {
+            metric.source = ConvergenceMetric::Source::kItl;
+        } else if (source == "latency") {
+            metric.source = ConvergenceMetric::Source::kLatency;
+        } else if (source == "tokens_per_second") {
+            metric.source = ConvergenceMetric::Source::kTokensPerSecond;
+        } else {
+            throw std::invalid_argument("Unknown convergence metric source: " + source);
+        }
+        if (statistic != "mean") {
+            try {
+                if (!statistic.starts_with('p')) {
+                    throw std::invalid_argument(statistic);
+                }
+                metric.percentile = std::stod(statistic.substr(1));
+            } catch (const std::exception&) {
+                throw std::invalid_argument("Convergence statistic must be mean or pNN: " +
+                                            statistic);
+            }
+            if (metric.percentile <= 0 || metric.percentile >= 100) {
+                throw std::invalid_argument("Convergence percentile must be in (0, 100): " +
+                                            statistic);
+            }
+        }
+        metrics.push_back(metric);
+    }
+    return metrics;
+}
+
+ConvergenceMonitor::ConvergenceMonitor(const ConvergenceConfig& config) : config_(config) {
+    for (const auto& metric : config_.metrics) {
+        trackers_.emplace_back().metric = metric;
+    }
+}
+
+void ConvergenceMonitor::on_result(size_t /*index*/, const CompletionStats& stats) {
+    if (!stats.success) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        completed_++;
+        return;
+    }
+    std::vector<double> itls;
+    for (const auto& choice_stats : stats.choices) {
+        const auto& times = choice_stats.chunk_times;
+        for (size_t i = 1; i < times.size(); ++i) {
+            itls.push_back(seconds_between(times[i - 1], times[i]).value_or(0.0));
+        }
+    }
+    auto ttft = stats.get_ttft_duration();
+    auto latency = stats.get_total_duration();
+    auto decode_duration = seconds_between(stats.ttft_time, stats.end_time);
+    std::optional<double> tokens_per_second;
+    if (decode_duration.has_value() && decode_duration.value() > 0) {
+        tokens_per_second = stats.api_usage.completion_tokens / decode_duration.value();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    completed_++;
+    for (auto& tracker : trackers_) {
+        switch (tracker.metric.source) {
+            case ConvergenceMetric::Source::kTtft:
+                if (ttft.has_value()) {
+                    tracker.pending.push_back(ttft.value());
+                }
+                break;
+            case ConvergenceMetric::Source::kItl:
+                tracker.pending.insert(tracker.pending.end(), itls.begin(), itls.end());
+                break;
+            case ConvergenceMetric::Source::kLatency:
+                if (latency.has_value()) {
+                    tracker.pending.push_back(latency.value());
+                }
+                break;
+            case ConvergenceMetric::Source::kTokensPerSecond:
+                if (tokens_per_second.has_value()) {
+                    tracker.pending.push_back(tokens_per_second.value());
+                }
+                break;
+        }
+    }
+}
+
+nlohmann::json ConvergenceMonitor::check(bool& converged) {
+    std::lock_guard<std::mutex> check_lock(check_mutex_);
+    size_t completed = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        completed = completed_;
+        // The emptied buffers go back to the workers with their capacity
+        for (auto& tracker : trackers_) {
+            tracker.pending.swap(tracker.draining);
+        }
+    }
+
+    converged = completed >= config_.min_requests;
+    nlohmann::json metrics = nlohmann::json::object();
+    for (auto& tracker : trackers_) {
+        const auto& metric = tracker.metric;
+        if (metric.is_mean()) {
+            for (double value : tracker.draining) {
+                tracker.count++;
+                double delta = value - tracker.mean;
+                tracker.mean += delta / static_cast<double>(tracker.count);
+                tracker.squared_deviations += delta * (value - tracker.mean);
+            }
+        } else {
+            auto& sorted = tracker.sorted;
+            size_t merged = sorted.size();
+            std::sort(tracker.draining.begin(), tracker.draining.end());
+            sorted.insert(sorted.end(), tracker.draining.begin(), tracker.draining.end());
+            std::inplace_merge(sorted.begin(), sorted.begin() + static_cast<ptrdiff_t>(merged),
+                               sorted.end());
+            tracker.count = sorted.size();
+        }
+        tracker.draining.clear();
+
+        size_t sample_count = tracker.count;
+        auto interval = metric.is_mean()
+                            ? mean_interval(tracker.count, tracker.mean,
+                                            tracker.squared_deviations, config_.confidence)
+                            : percentile_interval(tracker.sorted, metric.percentile,
+                                                  config_.confidence);
+        double relative_width = interval.estimate != 0.0
+                                    ? (interval.high - interval.low) / std::abs(interval.estimate)
+                                    : 0.0;
+        bool metric_converged =
+            interval.sufficient && relative_width <= config_.target_relative_width;
+        converged = converged && metric_converged;
+        metrics[metric.name()] = {{"samples", sample_count},
+                                  {"estimate", interval.estimate},
+                                  {"ci_low", interval.low},
+                                  {"ci_high", interval.high},
+                                  {"relative_width", relative_width},
+                                  {"converged", metric_converged}};
+    }
+    return {{"completed_requests", completed}, {"metrics", metrics}};
+}
+
+ConvergenceResult run_until_converged(Engine& engine, const std::vector<nlohmann::json>& requests,
+                                      const ConvergenceConfig& config) {
+    z_critical(config.confidence);
+    if (requests.empty() || config.max_requests == 0) {
+        throw std::invalid_argument("Convergence mode needs requests and a request budget");
+    }
+
+    // Budget of requests, cycling through the input
+    std::vector<nlohmann::json> workload;
+    workload.reserve(config.max_requests);
+    for (size_t i = 0; i < config.max_requests; ++i) {
+        workload.push_back(requests[i % requests.size()]);
+    }
+
+    auto monitor = std::make_shared<ConvergenceMonitor>(config);
+    engine.add_sink(monitor);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool finished = false;
+    std::string reason = "max_requests";
+    nlohmann::json checks = nlohmann::json::array();
+    auto start = std::chrono::steady_clock::now();
+    auto interval = std::chrono::duration<double>(config.check_interval_seconds);
+
+    // Checks run next to the workers, which keep dispatching in the meantime
+    std::thread checker([&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!cv.wait_for(lock, interval, [&] { return finished; })) {
+            double elapsed =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            bool converged = false;
+            auto status = monitor->check(converged);
+            status["elapsed_seconds"] = elapsed;
+            checks.push_back(status);
+            if (converged) {
+                reason = "converged";
+                engine.request_stop();
+                break;
+            }
+            if (config.max_seconds > 0 && elapsed >= config.max_seconds) {
+                reason = "max_seconds";
+                engine.request_stop();
+                break;
+            }
+        }
+    });
+
+    ConvergenceResult result;
+    result.stats = engine.run(workload);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+    }
+    cv.notify_all();
+    checker.join();
+
+    bool converged = false;
+    auto final_status = monitor->check(converged);
+    result.report = {
+        {"stop_reason", reason},
+        {"converged", converged},
+        {"requests", result.stats.second.size()},
+        {"elapsed_seconds",
+         std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()},
+        {"target_relative_width", config.target_relative_width},
+        {"confidence", config.confidence},
+        {"metrics", final_status["metrics"]},
+        {"checks", checks}};
+    return result;
+}
+
+}  // namespace bench_core
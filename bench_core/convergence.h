@@ -0,0 +1,94 @@
+#pragma once
+
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "bench_core/engine.h"
+#include "bench_core/sink.h"
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// Sequential stopping: keep issuing requests until the confidence intervals of
+// the chosen metrics are narrow enough, instead of guessing a workload size
+struct ConvergenceMetric {
+    enum class Source { kTtft, kItl, kLatency, kTokensPerSecond };
+    Source source = Source::kTtft;
+    // Percentile in (0, 100), or a negative value for the mean
+    double percentile = -1.0;
+
+    bool is_mean() const { return percentile < 0; }
+    std::string name() const;
+};
+
+// Parse a comma separated list of SOURCE:STATISTIC, where SOURCE is ttft, itl,
+// latency or tokens_per_second and STATISTIC is mean or pNN (e.g.
+// "ttft:p99,tokens_per_second:mean"); throws std::invalid_argument otherwise
+std::vector<ConvergenceMetric> parse_convergence_metrics(const std::string& value);
+
+struct ConvergenceConfig {
+    std::vector<ConvergenceMetric> metrics;
+    // Stop once every interval's width relative to its estimate is below this
+    double target_relative_width = 0.05;
+    // 0.9, 0.95 or 0.99
+    double confidence = 0.95;
+    // Requests completed before convergence is first checked
+    size_t min_requests = 100;
+    // Budget: the input is cycled up to max_requests; max_seconds 0 = no limit
+    size_t max_requests = 10000;
+    double max_seconds = 0.0;
+    double check_interval_seconds = 1.0;
+
+    bool enabled() const { return !metrics.empty(); }
+};
+
+// Collects the samples of the tracked metrics as results arrive and computes
+// their confidence intervals: Student's t for means, and the distribution-free
+// order-statistic interval for percentiles. Workers only append to a pending
+// buffer per metric; a check swaps the buffers out and folds them into running
+// sums (means) or a sorted sample (percentiles) without holding the workers'
+// lock, so checks cost the new samples rather than the whole history.
+class ConvergenceMonitor : public ResultsSink {
+public:
+    explicit ConvergenceMonitor(const ConvergenceConfig& config);
+
+    void on_result(size_t index, const CompletionStats& stats) override;
+
+    // Interval of every metric and whether all of them have converged
+    nlohmann::json check(bool& converged);
+
+private:
+    struct Tracker {
+        ConvergenceMetric metric;
+        // Appended by on_result under mutex_
+        std::vector<double> pending;
+        // Owned by check() under check_mutex_: the swapped-out buffer, Welford
+        // running mean and sum of squared deviations, and the sorted sample
+        std::vector<double> draining;
+        size_t count = 0;
+        double mean = 0.0;
+        double squared_deviations = 0.0;
+        std::vector<double> sorted;
+    };
+
+    ConvergenceConfig config_;
+    std::mutex mutex_;
+    std::mutex check_mutex_;
+    size_t completed_ = 0;
+    std::vector<Tracker> trackers_;
+};
+
+struct ConvergenceResult {
+    Stats stats;
+    nlohmann::json report;
+};
+
+// Run the input cyclically on engine until the metrics converge or the budget
+// is spent. The report gives the reason for stopping, the final intervals and
+// the history of periodic checks.
+ConvergenceResult run_until_converged(Engine& engine, const std::vector<nlohmann::json>& requests,
+                                      const ConvergenceConfig& config);
+
+}  // namespace bench_core
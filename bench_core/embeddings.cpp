@@ -0,0 +1,307 @@
+#include "bench_core/embeddings.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include "bench_core/http_client.h"
+
+namespace bench_core {
+
+namespace {
+
+size_t skip_whitespace(std::string_view text, size_t pos) {
+    while (pos < text.size() &&
+           (text[pos] == ' ' || text[pos] == '\n' || text[pos] == '\r' || text[pos] == '\t')) {
+        pos++;
+    }
+    return pos;
+}
+
+// Find the value following a "key": pair at or after pos, returning its offset
+std::optional<size_t> find_key_value(std::string_view text, std::string_view quoted_key,
+                                     size_t pos) {
+    while ((pos = text.find(quoted_key, pos)) != std::string_view::npos) {
+        size_t after_key = skip_whitespace(text, pos + quoted_key.size());
+        if (after_key < text.size() && text[after_key] == ':') {
+            return skip_whitespace(text, after_key + 1);
+        }
+        pos += quoted_key.size();
+    }
+    return std::nullopt;
+}
+
+// Return the end of the balanced {...} object starting at pos, honouring strings
+std::optional<size_t> find_object_end(std::string_view text, size_t pos) {
+    int depth = 0;
+    bool in_string = false;
+    for (; pos < text.size(); ++pos) {
+        char c = text[pos];
+        if (in_string) {
+            if (c == '\\') {
+                pos++;
+            } else if (c == '"') {
+                in_string = false;
+            }
+        } else if (c == '"') {
+            in_string = true;
+        } else if (c == '{') {
+            depth++;
+        } else if (c == '}' && --depth == 0) {
+            return pos + 1;
+        }
+    }
+    return std::nullopt;
+}
+
+// Sample a target input length (in words) from a distribution spec such as
+// "fixed:128", "uniform:32:512" or "normal:256:64"
+class TextLengthDistribution {
+public:
+    explicit TextLengthDistribution(const std::string& spec) {
+        std::vector<std::string> parts;
+        std::stringstream stream(spec);
+        std::string part;
+        while (std::getline(stream, part, ':')) {
+            parts.push_back(part);
+        }
+        if (parts.empty()) {
+            throw std::invalid_argument("Empty text length distribution");
+        }
+        kind_ = parts[0];
+        if ((kind_ == "fixed" && parts.size() != 2) ||
+            ((kind_ == "uniform" || kind_ == "normal") && parts.size() != 3)) {
+            throw std::invalid_argument("Invalid text length distribution: " + spec);
+        }
+        if (kind_ != "fixed" && kind_ != "uniform" && kind_ != "normal") {
+            throw std::invalid_argument("Unknown text length distribution: " + spec);
+        }
+        first_ = parse_parameter(parts[1], spec);
+        second_ = parts.size() > 2 ? parse_parameter(parts[2], spec) : 0.0;
+        if (kind_ == "uniform" && first_ > second_) {
+            throw std::invalid_argument("Uniform text length minimum exceeds maximum: " + spec);
+        }
+        if (kind_ == "normal" && second_ < 0.0) {
+            throw std::invalid_argument("Negative normal text length stddev: " + spec);
+        }
+    }
+
+    size_t sample(std::mt19937& rng) const {
+        double length = first_;
+        if (kind_ == "uniform") {
+            length = std::uniform_real_distribution<double>(first_, second_)(rng);
+        } else if (kind_ == "normal") {
+            length = std::normal_distribution<double>(first_, second_)(rng);
+        }
+        return static_cast<size_t>(std::max(1.0, std::round(length)));
+    }
+
+private:
+    static double parse_parameter(const std::string& text, const std::string& spec) {
+        double value = 0.0;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (text.empty() || error != std::errc() || end != text.data() + text.size() ||
+            !std::isfinite(value)) {
+            throw std::invalid_argument("Invalid text length distribution parameter '" + text +
+                                        "' in: " + spec);
+        }
+        return value;
+    }
+
+    std::string kind_;
+    double first_ = 0.0;
+    double second_ = 0.0;
+};
+
+}  // namespace
+
+EmbeddingResponseSummary parse_embedding_response(std::string_view body) {
+    EmbeddingResponseSummary summary;
+    size_t pos = 0;
+    while (true) {
+        auto value_pos = find_key_value(body, "\"embedding\"", pos);
+        if (!value_pos.has_value()) {
+            break;
+        }
+        pos = value_pos.value();
+        if (pos >= body.size() || body[pos] != '[') {
+            // Non-array encodings (e.g. base64) are counted but not decoded
+            summary.number_of_embeddings++;
+            continue;
+        }
+
+        size_t dimensions = 0;
+        pos = skip_whitespace(body, pos + 1);
+        while (pos < body.size() && body[pos] != ']') {
+            double value = 0.0;
+            auto [end, error] =
+                std::from_chars(body.data() + pos, body.data() + body.size(), value);
+            if (error != std::errc() || !std::isfinite(value)) {
+                throw std::runtime_error("Malformed embedding array at offset " +
+                                         std::to_string(pos));
+            }
+            dimensions++;
+            pos = skip_whitespace(body, static_cast<size_t>(end - body.data()));
+            // Elements are separated by exactly one comma, with none before the ']'
+            if (pos < body.size() && body[pos] == ',') {
+                pos = skip_whitespace(body, pos + 1);
+                if (pos < body.size() && body[pos] == ']') {
+                    throw std::runtime_error("Trailing comma in embedding array at offset " +
+                                             std::to_string(pos));
+                }
+            } else if (pos < body.size() && body[pos] != ']') {
+                throw std::runtime_error("Missing comma in embedding array at offset " +
+                                         std::to_string(pos));
+            }
+        }
+        if (pos >= body.size()) {
+            throw std::runtime_error("Malformed embedding array: unterminated at end of body");
+        }
+        if (summary.number_of_embeddings > 0 && dimensions != summary.dimensions) {
+            throw std::runtime_error("Inconsistent embedding dimensions in response");
+        }
+        summary.dimensions = dimensions;
+        summary.number_of_embeddings++;
+    }
+
+    // Servers may send usage before or after the data array
+    auto usage_pos = find_key_value(body, "\"usage\"", 0);
+    if (usage_pos.has_value() && usage_pos.value() < body.size() &&
+        body[usage_pos.value()] == '{') {
+        auto usage_end = find_object_end(body, usage_pos.value());
+        if (usage_end.has_value()) {
+            summary.usage = nlohmann::json::parse(
+                body.substr(usage_pos.value(), usage_end.value() - usage_pos.value()));
+        }
+    }
+    return summary;
+}
+
+std::vector<nlohmann::json> build_embedding_requests(const std::vector<nlohmann::json>& records,
+                                                     const std::vector<size_t>& batch_sizes,
+                                                     const std::string& text_length,
+                                                     unsigned int seed) {
+    std::vector<std::string> texts;
+    for (const auto& record : records) {
+        const auto* field = record.contains("input")    ? &record["input"]
+                            : record.contains("prompt") ? &record["prompt"]
+                                                        : nullptr;
+        if (field == nullptr) {
+            continue;
+        }
+        if (field->is_array()) {
+            for (const auto& text : *field) {
+                texts.push_back(text.get<std::string>());
+            }
+        } else {
+            texts.push_back(field->get<std::string>());
+        }
+    }
+    if (texts.empty()) {
+        throw std::runtime_error("No \"input\" or \"prompt\" texts found for embeddings mode");
+    }
+
+    if (!text_length.empty()) {
+        TextLengthDistribution distribution(text_length);
+        std::mt19937 rng(seed);
+        for (auto& text : texts) {
+            std::vector<std::string> words;
+            std::stringstream stream(text);
+            std::string word;
+            while (stream >> word) {
+                words.push_back(word);
+            }
+            if (words.empty()) {
+                continue;
+            }
+            size_t length = distribution.sample(rng);
+            std::string resized;
+            for (size_t i = 0; i < length; ++i) {
+                if (i > 0) {
+                    resized += ' ';
+                }
+                resized += words[i % words.size()];
+            }
+            text = std::move(resized);
+        }
+    }
+
+    std::vector<nlohmann::json> requests;
+    for (size_t batch_size : batch_sizes) {
+        for (size_t begin = 0; begin < texts.size(); begin += batch_size) {
+            size_t end = std::min(begin + batch_size, texts.size());
+            nlohmann::json inputs = nlohmann::json::array();
+            for (size_t i = begin; i < end; ++i) {
+                inputs.push_back(texts[i]);
+            }
+            requests.push_back({{"input", inputs}, {"batch_size", batch_size}});
+        }
+    }
+    std::cout << "[INFO] Built " + std::to_string(requests.size()) + " embeddings requests from " +
+                     std::to_string(texts.size()) + " texts"
+              << '\n';
+    return requests;
+}
+
+CompletionStats do_embedding(const nlohmann::json& request, const std::string& api_endpoint,
+                             const std::string& api_key, const std::string& model,
+                             const HeaderCapture& capture, const HttpOptions& http) {
+    CompletionStats stats;
+    stats.start_time = std::chrono::steady_clock::now();
+    stats.input = request;
+    stats.text_policy = TextPolicy::kNone;
+    auto& embedding = stats.embedding.emplace();
+    embedding.number_of_inputs = request["input"].size();
+    embedding.batch_size = request.value("batch_size", embedding.number_of_inputs);
+
+    try {
+        nlohmann::json body = {{"model", model}, {"input", request["input"]}};
+        HttpResponse response =
+            http_post_json(api_endpoint + "/embeddings", api_key, body.dump(), capture, http);
+        stats.end_time = std::chrono::steady_clock::now();
+        stats.new_connection = response.new_connection;
+        stats.tcp_info = response.tcp_info;
+        stats.remote_address = std::move(response.remote_address);
+        stats.wire = std::move(response.wire);
+        stats.ttft_time = stats.end_time;
+        stats.response_headers = std::move(response.headers);
+        stats.headers_time = stats.end_time;
+
+        if (response.status_code != 200) {
+            stats.success = false;
+            stats.error_message = "HTTP " + std::to_string(response.status_code) + ": " +
+                                  response.body.substr(0, 512);
+            return stats;
+        }
+
+        auto summary = parse_embedding_response(response.body);
+        stats.embedding->number_of_embeddings = summary.number_of_embeddings;
+        stats.embedding->dimensions = summary.dimensions;
+        if (summary.usage.has_value()) {
+            stats.api_usage.prompt_tokens = summary.usage->value("prompt_tokens", 0);
+            stats.api_usage.total_tokens = summary.usage->value("total_tokens", 0);
+            stats.api_usage.reported = true;
+        }
+        if (summary.number_of_embeddings != stats.embedding->number_of_inputs) {
+            stats.success = false;
+            stats.error_message = "Expected " + std::to_string(stats.embedding->number_of_inputs) +
+                                  " embeddings, got " +
+                                  std::to_string(summary.number_of_embeddings);
+        }
+    } catch (const std::exception& e) {
+        stats.success = false;
+        stats.error_message = e.what();
+        stats.end_time = std::chrono::steady_clock::now();
+        if (const auto* transport_error = dynamic_cast<const HttpTransportError*>(&e)) {
+            stats.remote_address = transport_error->remote_address();
+        }
+    }
+    return stats;
+}
+
+}  // namespace bench_core
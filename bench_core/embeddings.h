@@ -0,0 +1,43 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench_core/http_client.h"
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// Summary of an embeddings response, extracted without building a JSON DOM for
+// the (potentially multi-megabyte) float arrays
+struct EmbeddingResponseSummary {
+    size_t number_of_embeddings = 0;
+    size_t dimensions = 0;
+    std::optional<nlohmann::json> usage;
+};
+
+// Scan an embeddings response: each "embedding" float array is validated and
+// its dimension counted with std::from_chars, and only the small "usage" object
+// is handed to nlohmann::json
+EmbeddingResponseSummary parse_embedding_response(std::string_view body);
+
+// Build embeddings requests from the texts in the input records. Every batch
+// size processes the whole text pool, so the groups are directly comparable.
+// text_length is an optional distribution in words ("fixed:N",
+// "uniform:MIN:MAX" or "normal:MEAN:STDDEV"); each input is then resized by
+// repeating or truncating the words of its source text.
+std::vector<nlohmann::json> build_embedding_requests(const std::vector<nlohmann::json>& records,
+                                                     const std::vector<size_t>& batch_sizes,
+                                                     const std::string& text_length,
+                                                     unsigned int seed);
+
+// Issue one batched /embeddings request, keeping the response headers selected
+// by capture
+CompletionStats do_embedding(const nlohmann::json& request, const std::string& api_endpoint,
+                             const std::string& api_key, const std::string& model,
+                             const HeaderCapture& capture = {}, const HttpOptions& http = {});
+
+}  // namespace bench_core
@@ -0,0 +1,234 @@
+#include "bench_core/endpoint_resolver.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace bench_core {
+
+namespace {
+
+bool is_ipv6(const std::string& address) {
+    in6_addr parsed{};
+    return inet_pton(AF_INET6, address.c_str(), &parsed) == 1;
+}
+
+bool is_numeric_address(const std::string& address) {
+    in_addr parsed{};
+    return inet_pton(AF_INET, address.c_str(), &parsed) == 1 || is_ipv6(address);
+}
+
+// Host and port of "scheme://[user@]host[:port]/path"
+std::pair<std::string, int> split_host_port(const std::string& url) {
+    size_t scheme_end = url.find("://");
+    std::string scheme = scheme_end == std::string::npos ? "http" : url.substr(0, scheme_end);
+    size_t begin = scheme_end == std::string::npos ? 0 : scheme_end + 3;
+    size_t end = url.find_first_of("/?#", begin);
+    std::string authority = url.substr(begin, end == std::string::npos ? end : end - begin);
+    if (size_t at = authority.rfind('@'); at != std::string::npos) {
+        authority = authority.substr(at + 1);
+    }
+
+    std::string host = authority;
+    std::string port;
+    if (authority.starts_with('[')) {
+        size_t close = authority.find(']');
+        if (close == std::string::npos) {
+            throw std::invalid_argument("Malformed endpoint URL: " + url);
+        }
+        host = authority.substr(1, close - 1);
+        if (close + 1 < authority.size() && authority[close + 1] == ':') {
+            port = authority.substr(close + 2);
+        }
+    } else if (size_t colon = authority.rfind(':'); colon != std::string::npos) {
+        host = authority.substr(0, colon);
+        port = authority.substr(colon + 1);
+    }
+    if (host.empty()) {
+        throw std::invalid_argument("Endpoint URL has no host: " + url);
+    }
+    if (port.empty()) {
+        return {host, scheme == "https" ? 443 : 80};
+    }
+    return {host, std::stoi(port)};
+}
+
+std::vector<std::string> resolve_host(const std::string& host, int port) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* results = nullptr;
+    int status = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &results);
+    if (status != 0) {
+        throw std::runtime_error("Failed to resolve " + host + ": " + gai_strerror(status));
+    }
+
+    std::vector<std::string> addresses;
+    for (addrinfo* entry = results; entry != nullptr; entry = entry->ai_next) {
+        char buffer[INET6_ADDRSTRLEN] = {};
+        const void* address = nullptr;
+        if (entry->ai_family == AF_INET) {
+            address = &reinterpret_cast<sockaddr_in*>(entry->ai_addr)->sin_addr;
+        } else if (entry->ai_family == AF_INET6) {
+            address = &reinterpret_cast<sockaddr_in6*>(entry->ai_addr)->sin6_addr;
+        }
+        if (address != nullptr &&
+            inet_ntop(entry->ai_family, address, buffer, sizeof(buffer)) != nullptr &&
+            std::find(addresses.begin(), addresses.end(), buffer) == addresses.end()) {
+            addresses.emplace_back(buffer);
+        }
+    }
+    freeaddrinfo(results);
+    return addresses;
+}
+
+}  // namespace
+
+std::vector<std::string> parse_address_list(const std::string& value) {
+    std::vector<std::string> addresses;
+    std::stringstream stream(value);
+    std::string address;
+    while (std::getline(stream, address, ',')) {
+        address.erase(0, address.find_first_not_of(" \t"));
+        address.erase(address.find_last_not_of(" \t") + 1);
+        if (address.starts_with('[') && address.ends_with(']')) {
+            address = address.substr(1, address.size() - 2);
+        }
+        if (address.empty()) {
+            continue;
+        }
+        if (!is_numeric_address(address)) {
+            throw std::invalid_argument("Not an IP address: " + address);
+        }
+        addresses.push_back(address);
+    }
+    return addresses;
+}
+
+EndpointResolver::EndpointResolver(const std::string& url, const AddressConfig& config)
+    : config_(config) {
+    if (!config_.enabled()) {
+        return;
+    }
+    std::tie(host_, port_) = split_host_port(url);
+    if (!config_.pinned.empty()) {
+        addresses_ = config_.pinned;
+    } else {
+        auto start = std::chrono::steady_clock::now();
+        addresses_ = resolve_host(host_, port_);
+        resolve_seconds_ =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    if (addresses_.empty()) {
+        throw std::runtime_error("No address for " + host_);
+    }
+}
+
+std::string EndpointResolver::resolve_entry() const {
+    if (!enabled()) {
+        return {};
+    }
+    auto format = [](const std::string& address) {
+        return is_ipv6(address) ? "[" + address + "]" : address;
+    };
+
+    std::string entry = host_ + ":" + std::to_string(port_) + ":";
+    if (config_.spread) {
+        return entry + format(connection_address());
+    }
+    // libcurl tries the addresses in order, like a resolver answer
+    for (size_t i = 0; i < addresses_.size(); ++i) {
+        entry += (i == 0 ? "" : ",") + format(addresses_[i]);
+    }
+    return entry;
+}
+
+std::string EndpointResolver::connection_address() const {
+    if (!config_.spread) {
+        return {};
+    }
+    return addresses_[thread_slot() % addresses_.size()];
+}
+
+size_t EndpointResolver::thread_slot() const {
+    // Workers keep their connection, so the slot is drawn once per thread
+    thread_local const EndpointResolver* owner = nullptr;
+    thread_local size_t slot = 0;
+    if (owner != this) {
+        owner = this;
+        slot = next_slot_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return slot;
+}
+
+nlohmann::json EndpointResolver::to_json() const {
+    nlohmann::json json = {{"host", host_},
+                           {"port", port_},
+                           {"addresses", addresses_},
+                           {"pinned", !config_.pinned.empty()},
+                           {"spread", config_.spread}};
+    if (config_.pinned.empty()) {
+        json["resolve_seconds"] = resolve_seconds_;
+    }
+    return json;
+}
+
+nlohmann::json summarize_by_remote_address(
+    const std::vector<CompletionStats>& all_completion_stats) {
+    struct AddressGroup {
+        size_t requests = 0;
+        size_t failures = 0;
+        size_t new_connections = 0;
+        std::vector<double> ttfts;
+        std::vector<double> durations;
+        std::vector<double> itls;
+    };
+    std::map<std::string, AddressGroup> groups;
+    for (const auto& completion_stats : all_completion_stats) {
+        if (completion_stats.remote_address.empty()) {
+            continue;
+        }
+        auto& group = groups[completion_stats.remote_address];
+        group.requests++;
+        if (completion_stats.new_connection) {
+            group.new_connections++;
+        }
+        if (!completion_stats.success) {
+            group.failures++;
+            continue;
+        }
+        if (auto ttft = completion_stats.get_ttft_duration(); ttft.has_value()) {
+            group.ttfts.push_back(ttft.value());
+        }
+        if (auto duration = completion_stats.get_total_duration(); duration.has_value()) {
+            group.durations.push_back(duration.value());
+        }
+        for (const auto& choice_stats : completion_stats.choices) {
+            const auto& times = choice_stats.chunk_times;
+            for (size_t i = 1; i < times.size(); ++i) {
+                group.itls.push_back(seconds_between(times[i - 1], times[i]).value_or(0.0));
+            }
+        }
+    }
+
+    nlohmann::json json = nlohmann::json::object();
+    for (const auto& [address, group] : groups) {
+        json[address] = {{"number_requests", group.requests},
+                         {"number_failures", group.failures},
+                         {"new_connections", group.new_connections},
+                         {"ttft_p50_seconds", percentile(group.ttfts, 50)},
+                         {"ttft_p99_seconds", percentile(group.ttfts, 99)},
+                         {"total_duration_p50_seconds", percentile(group.durations, 50)},
+                         {"itl_p50_seconds", percentile(group.itls, 50)},
+                         {"itl_p99_seconds", percentile(group.itls, 99)}};
+    }
+    return json;
+}
+
+}  // namespace bench_core
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// How connections pick a backend address when the endpoint hostname resolves
+// to several. Pinning goes through CURLOPT_RESOLVE, so the URL keeps its
+// hostname and TLS SNI and the Host header are unchanged.
+struct AddressConfig {
+    // Resolve the hostname once at startup instead of on each new connection
+    bool resolve_once = false;
+    // Give each connection one address, round-robin over all of them
+    bool spread = false;
+    // Use these addresses instead of resolving the hostname
+    std::vector<std::string> pinned;
+
+    bool enabled() const { return resolve_once || spread || !pinned.empty(); }
+};
+
+// Parse a comma-separated list of IPv4/IPv6 addresses; throws
+// std::invalid_argument on anything that is not a numeric address
+std::vector<std::string> parse_address_list(const std::string& value);
+
+// Addresses of the endpoint host, fixed at construction
+class EndpointResolver {
+public:
+    // Resolves the host of url unless addresses are pinned; throws
+    // std::runtime_error if it has no address
+    EndpointResolver(const std::string& url, const AddressConfig& config);
+
+    bool enabled() const { return config_.enabled(); }
+
+    // CURLOPT_RESOLVE entry ("host:port:address[,address]") for connections
+    // opened by the calling thread, empty when disabled. Each worker thread
+    // keeps its own connection, so spreading assigns addresses per thread.
+    std::string resolve_entry() const;
+
+    // Address assigned to the calling thread when spreading, otherwise empty.
+    // Attributes failures that happen before libcurl reports the peer.
+    std::string connection_address() const;
+
+    // Host, port, addresses and startup resolution time
+    nlohmann::json to_json() const;
+
+private:
+    size_t thread_slot() const;
+
+    AddressConfig config_;
+    std::string host_;
+    int port_ = 0;
+    std::vector<std::string> addresses_;
+    double resolve_seconds_ = 0.0;
+    mutable std::atomic<size_t> next_slot_{0};
+};
+
+// Request count, failures and latency percentiles per remote address
+nlohmann::json summarize_by_remote_address(
+    const std::vector<CompletionStats>& all_completion_stats);
+
+}  // namespace bench_core
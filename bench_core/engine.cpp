@@ -0,0 +1,509 @@
+#include "bench_core/engine.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#include "bench_core/completions.h"
+#include "bench_core/embeddings.h"
+#include "bench_core/http_client.h"
+#include "bench_core/log.h"
+#include "bench_core/structured_output.h"
+#include "liboai.h"
+
+namespace bench_core {
+
+namespace {
+
+std::chrono::steady_clock::duration seconds_to_duration(double seconds) {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(seconds));
+}
+
+}  // namespace
+
+Mode parse_mode(const std::string& value) {
+    if (value == "completions") {
+        return Mode::kCompletions;
+    }
+    if (value == "embeddings") {
+        return Mode::kEmbeddings;
+    }
+    throw std::invalid_argument("Unknown mode: " + value);
+}
+
+Transport parse_transport(const std::string& value) {
+    if (value == "liboai") {
+        return Transport::kLiboai;
+    }
+    if (value == "curl") {
+        return Transport::kCurl;
+    }
+    throw std::invalid_argument("Unknown transport: " + value);
+}
+
+nlohmann::json MetricsSnapshot::to_json() const {
+    nlohmann::json snapshot_json = {
+        {"elapsed_seconds", elapsed_seconds},
+        {"requests_total", requests_total},
+        {"requests_started", requests_started},
+        {"requests_completed", requests_completed},
+        {"requests_failed", requests_failed},
+        {"requests_in_flight", requests_in_flight()},
+        {"prompt_tokens", prompt_tokens},
+        {"completion_tokens", completion_tokens},
+        {"requests_per_second", elapsed_seconds > 0 ? requests_completed / elapsed_seconds : 0.0},
+        {"completion_tokens_per_second",
+         elapsed_seconds > 0 ? completion_tokens / elapsed_seconds : 0.0}};
+    if (!queue_depths.is_null()) {
+        snapshot_json["queue_depths"] = queue_depths;
+    }
+    return snapshot_json;
+}
+
+Engine::Engine(EngineConfig config)
+    : config_(std::move(config))
+    , header_capture_(config_.capture_headers)
+    , endpoint_resolver_(config_.api_endpoint, config_.addresses)
+    , ordering_seed_(config_.seed)
+    , rate_limiter_(config_.max_requests_per_minute, config_.max_prompt_tokens_per_minute,
+                    config_.max_completion_tokens_per_minute, config_.rate_limit_burst_seconds) {
+    if (header_capture_.enabled() && config_.mode == Mode::kCompletions &&
+        config_.transport != Transport::kCurl) {
+        throw std::invalid_argument("Header capture requires the curl transport");
+    }
+    if (config_.slow_readers.enabled() &&
+        (config_.mode != Mode::kCompletions || config_.transport != Transport::kCurl)) {
+        throw std::invalid_argument("Slow readers require completions over the curl transport");
+    }
+    if (config_.socket_options.configured() && config_.mode == Mode::kCompletions &&
+        config_.transport != Transport::kCurl) {
+        throw std::invalid_argument("Socket options require the curl transport");
+    }
+    if (config_.addresses.enabled() && config_.mode == Mode::kCompletions &&
+        config_.transport != Transport::kCurl) {
+        throw std::invalid_argument("Address pinning requires the curl transport");
+    }
+    if (config_.compression.enabled()) {
+        if (config_.mode == Mode::kCompletions && config_.transport != Transport::kCurl) {
+            throw std::invalid_argument("Accept-Encoding requires the curl transport");
+        }
+        check_accept_encoding(config_.compression.accept_encoding);
+    }
+    http_global_init();
+
+    // Initialize liboai with the provided API key and endpoint
+    oai_ = std::make_unique<liboai::OpenAI>(config_.api_endpoint);
+    if (!oai_->auth.SetKey(config_.api_key)) {
+        throw std::runtime_error("Failed to set API key.");
+    }
+}
+
+Engine::~Engine() = default;
+
+void Engine::set_ordering(OrderingPolicy policy, unsigned int seed) {
+    config_.ordering = policy;
+    ordering_seed_ = seed;
+}
+
+void Engine::add_sink(std::shared_ptr<ResultsSink> sink) { sinks_.push_back(std::move(sink)); }
+
+RequestPlan Engine::plan_request(const nlohmann::json& request, size_t index) const {
+    RequestPlan plan;
+    plan.abort = plan_abort(config_.aborts, request, index, config_.seed);
+    plan.slow_reader = select_slow_reader(config_.slow_readers, index, config_.seed);
+    if (plan.slow_reader) {
+        plan.http = config_.slow_readers.http;
+    }
+    if (select_compressed(config_.compression, index, config_.seed)) {
+        plan.http.accept_encoding = config_.compression.accept_encoding;
+    }
+    return plan;
+}
+
+CompletionStats Engine::execute(const nlohmann::json& request, const RequestPlan& plan) {
+    // Connection-level settings apply to every request, planned or not
+    HttpOptions http = plan.http;
+    http.socket = config_.socket_options;
+    http.resolve = endpoint_resolver_.resolve_entry();
+    CompletionStats completion_stats;
+    if (config_.mode == Mode::kEmbeddings) {
+        completion_stats = do_embedding(request, config_.api_endpoint, config_.api_key,
+                                        config_.model, header_capture_, http);
+    } else if (config_.transport == Transport::kCurl || is_chat_request(request)) {
+        completion_stats =
+            do_completion_http(request, config_.api_endpoint, config_.api_key, config_.model,
+                               config_.text_policy, config_.chunk_granularity.enabled,
+                               header_capture_, plan.abort, http);
+        completion_stats.slow_reader = plan.slow_reader;
+    } else {
+        return do_completion(request, *oai_, config_.model, config_.text_policy,
+                             config_.chunk_granularity.enabled, plan.abort);
+    }
+    // Failed connects never report a peer
+    if (completion_stats.remote_address.empty()) {
+        completion_stats.remote_address = endpoint_resolver_.connection_address();
+    }
+    return completion_stats;
+}
+
+void Engine::send_request(const nlohmann::json& request, const RequestPlan& plan,
+                          const RateLimiter::Cost& cost, double rate_limit_wait_seconds,
+                          CompletionStats& completion_stats) {
+    requests_started_.fetch_add(1, std::memory_order_relaxed);
+    completion_stats = execute(request, plan);
+    if (config_.chunk_granularity.enabled) {
+        completion_stats.chunk_granularity =
+            summarize_request_chunks(completion_stats, config_.chunk_granularity);
+    }
+    if (rate_limiter_.enabled()) {
+        completion_stats.rate_limit_wait_seconds = rate_limit_wait_seconds;
+        // Without a usage block the server may still have charged the whole
+        // request, so the estimate stands. An aborted stream was charged at
+        // least one completion token per content chunk it delivered.
+        const auto& usage = completion_stats.api_usage;
+        if (usage.reported) {
+            rate_limiter_.reconcile(cost, usage.prompt_tokens, usage.completion_tokens);
+        } else if (completion_stats.aborted) {
+            rate_limiter_.reconcile(
+                cost, {cost.prompt_tokens, static_cast<double>(completion_stats.content_chunks())});
+        }
+    }
+}
+
+void Engine::finish_request(size_t index, const CompletionStats& completion_stats) {
+    prompt_tokens_.fetch_add(completion_stats.api_usage.prompt_tokens,
+                             std::memory_order_relaxed);
+    completion_tokens_.fetch_add(completion_stats.api_usage.completion_tokens,
+                                 std::memory_order_relaxed);
+    if (!completion_stats.success) {
+        requests_failed_.fetch_add(1, std::memory_order_relaxed);
+        log_message(LogLevel::kWarning, "request_failed",
+                    "Request " + std::to_string(index) +
+                        " failed: " + completion_stats.error_message);
+    }
+    requests_completed_.fetch_add(1, std::memory_order_relaxed);
+
+    for (const auto& sink : sinks_) {
+        sink->on_result(index, completion_stats);
+    }
+}
+
+nlohmann::json Engine::run_pipeline(const std::vector<nlohmann::json>& requests,
+                                    const std::vector<size_t>& order,
+                                    std::atomic<size_t>& next_position,
+                                    std::vector<CompletionStats>& all_completion_stats,
+                                    std::vector<char>& executed,
+                                    std::chrono::steady_clock::time_point start_time) {
+    struct Job {
+        size_t index = 0;
+        size_t position = 0;
+        RequestPlan plan;
+        RateLimiter::Cost cost;
+        double rate_limit_wait_seconds = 0.0;
+    };
+
+    auto transports = static_cast<size_t>(std::max(0, config_.concurrent_requests));
+    if (transports == 0) {
+        // Nothing could drain the queues; like the fused workers, send nothing
+        return nullptr;
+    }
+    size_t schedulers = std::max<size_t>(1, config_.pipeline.scheduler_threads);
+    size_t aggregators = std::max<size_t>(1, config_.pipeline.aggregator_threads);
+    size_t capacity = config_.pipeline.queue_capacity > 0 ? config_.pipeline.queue_capacity
+                                                          : std::max<size_t>(2, 2 * transports);
+    StageQueue<Job> scheduled("scheduled", capacity);
+    StageQueue<size_t> finished("finished", capacity);
+    StageMetrics scheduler_metrics("scheduler", schedulers);
+    StageMetrics transport_metrics("transport", transports);
+    StageMetrics aggregator_metrics("aggregator", aggregators);
+    {
+        std::lock_guard<std::mutex> lock(pipeline_mutex_);
+        pipeline_queues_ = {&scheduled.metrics(), &finished.metrics()};
+    }
+
+    // Scheduler: dispatch order, request plan and cost estimate
+    auto scheduler = [&]() -> void {
+        while (!stop_requested_.load(std::memory_order_relaxed)) {
+            size_t position = next_position.fetch_add(1);
+            if (position >= order.size()) {
+                break;
+            }
+            auto busy_start = std::chrono::steady_clock::now();
+            Job job;
+            job.index = order[position];
+            job.position = position;
+            job.plan = plan_request(requests[job.index], job.index);
+            if (rate_limiter_.enabled()) {
+                job.cost = RateLimiter::estimate_cost(requests[job.index]);
+            }
+            scheduler_metrics.record(std::chrono::steady_clock::now() - busy_start);
+            scheduled.push(std::move(job));
+        }
+    };
+
+    // Transport: client-side rate limit, then send and decode, one connection
+    // per thread. Quota is taken right before sending, so queued jobs hold none
+    // and the wait is the one the request saw. Jobs still queued after a stop
+    // are dropped.
+    auto transport = [&](size_t worker_index) -> void {
+        std::this_thread::sleep_until(
+            start_time + seconds_to_duration(config_.ramp.start_offset(worker_index, transports)));
+        Job job;
+        while (scheduled.pop(job)) {
+            if (stop_requested_.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            if (rate_limiter_.enabled()) {
+                job.rate_limit_wait_seconds = rate_limiter_.acquire(job.cost);
+            }
+            auto busy_start = std::chrono::steady_clock::now();
+            auto& completion_stats = all_completion_stats[job.index];
+            send_request(requests[job.index], job.plan, job.cost, job.rate_limit_wait_seconds,
+                         completion_stats);
+            completion_stats.dispatch_position = job.position;
+            completion_stats.worker_id = worker_index;
+            executed[job.index] = 1;
+            transport_metrics.record(std::chrono::steady_clock::now() - busy_start);
+            finished.push(job.index);
+        }
+    };
+
+    // Aggregator: live counters, failure log and sinks
+    auto aggregator = [&]() -> void {
+        size_t index = 0;
+        while (finished.pop(index)) {
+            auto busy_start = std::chrono::steady_clock::now();
+            finish_request(index, all_completion_stats[index]);
+            aggregator_metrics.record(std::chrono::steady_clock::now() - busy_start);
+        }
+    };
+
+    std::vector<std::thread> aggregator_threads;
+    for (size_t i = 0; i < aggregators; ++i) {
+        aggregator_threads.emplace_back(aggregator);
+    }
+    std::vector<std::thread> transport_threads;
+    for (size_t i = 0; i < transports; ++i) {
+        transport_threads.emplace_back(transport, i);
+    }
+    std::vector<std::thread> scheduler_threads;
+    for (size_t i = 0; i < schedulers; ++i) {
+        scheduler_threads.emplace_back(scheduler);
+    }
+
+    // Each stage drains once every thread of the stage before it has exited
+    for (auto& thread : scheduler_threads) {
+        thread.join();
+    }
+    scheduled.close();
+    for (auto& thread : transport_threads) {
+        thread.join();
+    }
+    finished.close();
+    for (auto& thread : aggregator_threads) {
+        thread.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(pipeline_mutex_);
+        pipeline_queues_.clear();
+    }
+
+    double run_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    nlohmann::json stages = {scheduler_metrics.to_json(run_seconds),
+                             transport_metrics.to_json(run_seconds),
+                             aggregator_metrics.to_json(run_seconds)};
+    std::string bottleneck;
+    double highest_utilization = -1.0;
+    for (const auto& stage : stages) {
+        if (stage["utilization"].get<double>() > highest_utilization) {
+            highest_utilization = stage["utilization"].get<double>();
+            bottleneck = stage["stage"].get<std::string>();
+        }
+    }
+    return {{"stages", stages},
+            {"queues", {scheduled.metrics().to_json(), finished.metrics().to_json()}},
+            {"bottleneck", bottleneck}};
+}
+
+MetricsSnapshot Engine::snapshot() const {
+    MetricsSnapshot snapshot;
+    auto run_start = run_start_.load(std::memory_order_relaxed);
+    if (run_start != 0) {
+        auto start =
+            std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(run_start));
+        snapshot.elapsed_seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    snapshot.requests_total = requests_total_.load(std::memory_order_relaxed);
+    snapshot.requests_started = requests_started_.load(std::memory_order_relaxed);
+    snapshot.requests_completed = requests_completed_.load(std::memory_order_relaxed);
+    snapshot.requests_failed = requests_failed_.load(std::memory_order_relaxed);
+    snapshot.prompt_tokens = prompt_tokens_.load(std::memory_order_relaxed);
+    snapshot.completion_tokens = completion_tokens_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    if (!pipeline_queues_.empty()) {
+        snapshot.queue_depths = nlohmann::json::object();
+        for (const auto* queue : pipeline_queues_) {
+            snapshot.queue_depths[queue->name()] = queue->depth();
+        }
+    }
+    return snapshot;
+}
+
+void Engine::begin_run(size_t requests_total) {
+    for (auto* counter : {&requests_started_, &requests_completed_, &requests_failed_,
+                          &prompt_tokens_, &completion_tokens_}) {
+        counter->store(0, std::memory_order_relaxed);
+    }
+    requests_total_.store(requests_total, std::memory_order_relaxed);
+    stop_requested_.store(false, std::memory_order_relaxed);
+    run_start_.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                     std::memory_order_relaxed);
+}
+
+CompletionStats Engine::dispatch(const nlohmann::json& request, size_t index) {
+    auto plan = plan_request(request, index);
+    RateLimiter::Cost cost;
+    double wait_seconds = 0.0;
+    if (rate_limiter_.enabled()) {
+        cost = RateLimiter::estimate_cost(request);
+        wait_seconds = rate_limiter_.acquire(cost);
+    }
+    CompletionStats completion_stats;
+    send_request(request, plan, cost, wait_seconds, completion_stats);
+    finish_request(index, completion_stats);
+    return completion_stats;
+}
+
+void Engine::finish_run(const Stats& stats) {
+    for (const auto& sink : sinks_) {
+        sink->on_finish(stats);
+    }
+}
+
+Stats Engine::run(RequestSource& source) { return run(source.load()); }
+
+Stats Engine::run(const std::vector<nlohmann::json>& requests) {
+    std::vector<CompletionStats> all_completion_stats(requests.size());
+    RateLimiter* rate_limiter = rate_limiter_.enabled() ? &rate_limiter_ : nullptr;
+
+    begin_run(requests.size());
+    auto start_time = std::chrono::steady_clock::now();
+
+    // Workers pull the next position in dispatch order until the workload is exhausted
+    const auto order =
+        dispatch_order(requests, config_.ordering, config_.ordering_key, ordering_seed_);
+    std::atomic<size_t> next_position{0};
+    // Requests actually sent; a stop leaves the rest out of the results
+    std::vector<char> executed(requests.size(), 0);
+
+    auto workers = static_cast<size_t>(std::max(0, config_.concurrent_requests));
+    nlohmann::json pipeline_report;
+    if (config_.pipeline.enabled) {
+        pipeline_report = run_pipeline(requests, order, next_position, all_completion_stats,
+                                       executed, start_time);
+    } else {
+        auto worker = [&](size_t worker_index) -> void {
+            // Each worker opens its own connection on its first request
+            std::this_thread::sleep_until(
+                start_time +
+                seconds_to_duration(config_.ramp.start_offset(worker_index, workers)));
+            while (!stop_requested_.load(std::memory_order_relaxed)) {
+                size_t position = next_position.fetch_add(1);
+                if (position >= order.size()) {
+                    break;
+                }
+                size_t index = order[position];
+                auto plan = plan_request(requests[index], index);
+                RateLimiter::Cost cost;
+                double wait_seconds = 0.0;
+                if (rate_limiter != nullptr) {
+                    cost = RateLimiter::estimate_cost(requests[index]);
+                    wait_seconds = rate_limiter->acquire(cost);
+                }
+                send_request(requests[index], plan, cost, wait_seconds,
+                             all_completion_stats[index]);
+                all_completion_stats[index].dispatch_position = position;
+                all_completion_stats[index].worker_id = worker_index;
+                executed[index] = 1;
+                finish_request(index, all_completion_stats[index]);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(workers);
+        for (size_t i = 0; i < workers; ++i) {
+            threads.emplace_back(worker, i);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Drop the requests a stop left unsent, keeping input order
+    if (stop_requested_.exchange(false, std::memory_order_relaxed)) {
+        std::vector<CompletionStats> executed_stats;
+        for (size_t index = 0; index < all_completion_stats.size(); ++index) {
+            if (executed[index] != 0) {
+                executed_stats.push_back(std::move(all_completion_stats[index]));
+            }
+        }
+        all_completion_stats = std::move(executed_stats);
+    }
+
+    auto end_time = std::chrono::steady_clock::now();
+    Stats stats = std::make_pair(aggregate_stats(all_completion_stats),
+                                 std::move(all_completion_stats));
+    stats.first.start_time = start_time;
+    stats.first.end_time = end_time;
+    stats.first.pipeline = std::move(pipeline_report);
+    if (config_.ramp.enabled()) {
+        auto ramp_end = start_time + seconds_to_duration(config_.ramp.duration(workers));
+        stats.first.phases = summarize_phases(stats.second, start_time, ramp_end, end_time);
+    }
+    if (config_.steady_state.enabled) {
+        stats.first.steady_state =
+            summarize_steady_state(stats.second, start_time, end_time, config_.steady_state);
+    }
+    if (config_.tail_attribution.enabled()) {
+        stats.first.tail_attribution =
+            summarize_tail_attribution(stats.second, start_time, config_.tail_attribution);
+    }
+    if (config_.mode == Mode::kCompletions) {
+        stats.first.structured_output = summarize_structured_output(stats.second);
+    }
+    if (config_.chunk_granularity.enabled) {
+        stats.first.chunk_granularity =
+            summarize_chunk_granularity(stats.second, config_.chunk_granularity);
+    }
+    stats.first.wire_bytes = summarize_wire_bytes(stats.second, start_time, end_time);
+    if (config_.slow_readers.enabled()) {
+        stats.first.slow_readers = summarize_slow_readers(stats.second);
+    }
+    if (config_.aborts.enabled()) {
+        stats.first.aborts =
+            summarize_aborts(stats.second, config_.aborts.impact_window_seconds);
+    }
+    if (config_.socket_options.configured()) {
+        std::vector<TcpInfo> tcp_samples;
+        for (const auto& completion_stats : stats.second) {
+            if (completion_stats.tcp_info.has_value()) {
+                tcp_samples.push_back(completion_stats.tcp_info.value());
+            }
+        }
+        stats.first.socket_options = {{"requested", config_.socket_options.to_json()},
+                                      {"effective", effective_socket_options()},
+                                      {"tcp_info", summarize_tcp_info(tcp_samples)}};
+    }
+    if (endpoint_resolver_.enabled()) {
+        stats.first.endpoint_addresses = endpoint_resolver_.to_json();
+        stats.first.by_remote_address = summarize_by_remote_address(stats.second);
+    }
+
+    finish_run(stats);
+    return stats;
+}
+
+}  // namespace bench_core
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "bench_core/aborts.h"
+#include "bench_core/chunk_granularity.h"
+#include "bench_core/compression.h"
+#include "bench_core/endpoint_resolver.h"
+#include "bench_core/headers.h"
+#include "bench_core/ordering.h"
+#include "bench_core/pipeline.h"
+#include "bench_core/ramp.h"
+#include "bench_core/rate_limiter.h"
+#include "bench_core/requests.h"
+#include "bench_core/sink.h"
+#include "bench_core/slow_reader.h"
+#include "bench_core/socket_options.h"
+#include "bench_core/stats.h"
+#include "bench_core/steady_state.h"
+#include "bench_core/tail_attribution.h"
+
+namespace liboai {
+class OpenAI;
+}
+
+namespace bench_core {
+
+// Endpoint driven by the engine
+enum class Mode { kCompletions, kEmbeddings };
+
+// Parse "completions" or "embeddings"; throws std::invalid_argument otherwise
+Mode parse_mode(const std::string& value);
+
+// HTTP client used for completions. liboai hides the response headers, so
+// anything that needs them runs over libcurl directly.
+enum class Transport { kLiboai, kCurl };
+
+// Parse "liboai" or "curl"; throws std::invalid_argument otherwise
+Transport parse_transport(const std::string& value);
+
+struct EngineConfig {
+    std::string api_endpoint = "https://api.cerebras.ai/v1";
+    std::string api_key;
+    std::string model = "llama-3.3-70b";
+    Mode mode = Mode::kCompletions;
+    int concurrent_requests = 10;
+    TextPolicy text_policy = TextPolicy::kFull;
+    Transport transport = Transport::kLiboai;
+
+    // Response headers to record per request, e.g. {"x-request-id",
+    // "x-ratelimit-*"}. Requires Transport::kCurl for completions.
+    std::vector<std::string> capture_headers;
+
+    // Order in which workers pick up requests; results keep file order
+    OrderingPolicy ordering = OrderingPolicy::kFifo;
+    OrderingKey ordering_key = OrderingKey::kPromptLength;
+    unsigned int seed = 42;
+
+    // Client-abort simulation, disabled by default
+    AbortConfig aborts;
+
+    // Staggered worker start-up; ramp and steady phases are reported separately
+    RampConfig ramp;
+
+    // Slow-reader simulation, disabled by default. Requires Transport::kCurl.
+    SlowReaderConfig slow_readers;
+
+    // MSER-5 warmup detection in the end-of-run summary, disabled by default
+    SteadyStateConfig steady_state;
+
+    // Tail-latency attribution in the end-of-run summary, disabled by default
+    TailAttributionConfig tail_attribution;
+
+    // Per-request and end-of-run chunk granularity analytics, disabled by default
+    ChunkGranularityConfig chunk_granularity;
+
+    // Accept-Encoding for a fraction of the requests, disabled by default.
+    // Requires Transport::kCurl for completions.
+    CompressionConfig compression;
+
+    // Staged execution with per-stage metrics instead of fused workers
+    PipelineConfig pipeline;
+
+    // Socket tuning for new connections, reported with its effective values.
+    // Requires Transport::kCurl for completions.
+    SocketOptions socket_options;
+
+    // Backend address selection for the endpoint hostname. Requires
+    // Transport::kCurl for completions.
+    AddressConfig addresses;
+
+    // Client-side rate limits, 0 = unlimited
+    double max_requests_per_minute = 0.0;
+    double max_prompt_tokens_per_minute = 0.0;
+    double max_completion_tokens_per_minute = 0.0;
+    double rate_limit_burst_seconds = 1.0;
+};
+
+// Per-request behaviour chosen by the engine's simulations
+struct RequestPlan {
+    AbortPlan abort;
+    bool slow_reader = false;
+    HttpOptions http;
+};
+
+// Point-in-time view of a running engine, safe to take from any thread
+struct MetricsSnapshot {
+    double elapsed_seconds = 0.0;
+    size_t requests_total = 0;
+    size_t requests_started = 0;
+    size_t requests_completed = 0;
+    size_t requests_failed = 0;
+    size_t prompt_tokens = 0;
+    size_t completion_tokens = 0;
+    // Depth of every queue between pipeline stages, null without a pipeline
+    nlohmann::json queue_depths;
+
+    size_t requests_in_flight() const { return requests_started - requests_completed; }
+
+    nlohmann::json to_json() const;
+};
+
+// Load generator: issues requests over concurrent_requests worker threads,
+// feeds every result to the registered sinks and returns the aggregated stats.
+// One engine can run several workloads in sequence, but not concurrently.
+class Engine {
+public:
+    explicit Engine(EngineConfig config);
+    ~Engine();
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    const EngineConfig& config() const { return config_; }
+
+    // Change the dispatch order of later runs, e.g. to shuffle each trial.
+    // The seed only affects ordering; abort and slow-reader selection keep
+    // config().seed.
+    void set_ordering(OrderingPolicy policy, unsigned int seed);
+    unsigned int ordering_seed() const { return ordering_seed_; }
+
+    void add_sink(std::shared_ptr<ResultsSink> sink);
+
+    Stats run(RequestSource& source);
+    Stats run(const std::vector<nlohmann::json>& requests);
+
+    // Stop dispatching new requests in the current run; requests in flight
+    // finish normally and run() returns the results of those dispatched.
+    // Safe to call from any thread.
+    void request_stop() { stop_requested_.store(true, std::memory_order_relaxed); }
+
+    MetricsSnapshot snapshot() const;
+
+    // Issue a single request on the calling thread. Bypasses the rate limiter,
+    // sinks and live counters, for callers that schedule requests themselves.
+    CompletionStats execute(const nlohmann::json& request, const RequestPlan& plan = {});
+
+    // Runs scheduled by the caller instead of run(): begin_run() resets the
+    // live counters for requests_total requests, dispatch() issues each one on
+    // the calling thread the way a worker does (planned by index, rate
+    // limited, counted and fed to the sinks) and finish_run() hands the
+    // aggregated results to the sinks.
+    void begin_run(size_t requests_total);
+    CompletionStats dispatch(const nlohmann::json& request, size_t index);
+    void finish_run(const Stats& stats);
+
+private:
+    RequestPlan plan_request(const nlohmann::json& request, size_t index) const;
+
+    // Send a planned request, then charge the rate limiter the difference
+    // between the estimated cost and the reported usage
+    void send_request(const nlohmann::json& request, const RequestPlan& plan,
+                      const RateLimiter::Cost& cost, double rate_limit_wait_seconds,
+                      CompletionStats& completion_stats);
+
+    // Live counters, failure log and sinks of a finished request
+    void finish_request(size_t index, const CompletionStats& completion_stats);
+
+    // Staged run over config_.pipeline; returns the stage and queue metrics
+    nlohmann::json run_pipeline(const std::vector<nlohmann::json>& requests,
+                                const std::vector<size_t>& order,
+                                std::atomic<size_t>& next_position,
+                                std::vector<CompletionStats>& all_completion_stats,
+                                std::vector<char>& executed,
+                                std::chrono::steady_clock::time_point start_time);
+
+    EngineConfig config_;
+    HeaderCapture header_capture_;
+    EndpointResolver endpoint_resolver_;
+    unsigned int ordering_seed_;
+    std::unique_ptr<liboai::OpenAI> oai_;
+    RateLimiter rate_limiter_;
+    std::vector<std::shared_ptr<ResultsSink>> sinks_;
+
+    // Live counters, updated by workers and read by snapshot()
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<std::chrono::steady_clock::rep> run_start_{0};
+    std::atomic<size_t> requests_total_{0};
+    std::atomic<size_t> requests_started_{0};
+    std::atomic<size_t> requests_completed_{0};
+    std::atomic<size_t> requests_failed_{0};
+    std::atomic<size_t> prompt_tokens_{0};
+    std::atomic<size_t> completion_tokens_{0};
+
+    // Queues of the running pipeline, read by snapshot()
+    mutable std::mutex pipeline_mutex_;
+    std::vector<const QueueMetrics*> pipeline_queues_;
+};
+
+}  // namespace bench_core
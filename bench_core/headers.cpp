@@ -0,0 +1,272 @@
+#include "bench_core/headers.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <unordered_map>
+
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+namespace {
+
+// Names live in a deque so references handed out stay valid as it grows
+struct HeaderNameTable {
+    std::shared_mutex mutex;
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+HeaderNameTable& header_name_table() {
+    static HeaderNameTable table;
+    return table;
+}
+
+std::string to_lower(std::string_view value) {
+    std::string lower(value);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return lower;
+}
+
+std::string_view trim(std::string_view value) {
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.front()))) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back()))) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+// Parse a leading plain decimal number, advancing value past it. Exponents, nan and
+// inf are refused, as are integers too long to survive a double, so ids such as
+// "1e10" or a 19-digit request id stay text.
+std::optional<double> consume_number(std::string_view& value) {
+    size_t digits_start = (!value.empty() && (value[0] == '-' || value[0] == '+')) ? 1 : 0;
+    size_t length = digits_start;
+    size_t digits = 0;
+    bool fraction = false;
+    while (length < value.size()) {
+        char c = value[length];
+        if (c >= '0' && c <= '9') {
+            digits++;
+        } else if (c == '.' && !fraction) {
+            fraction = true;
+        } else {
+            break;
+        }
+        length++;
+    }
+    if (digits == 0 || (!fraction && digits > 15)) {
+        return std::nullopt;
+    }
+
+    // from_chars rejects a leading '+'
+    double number = 0.0;
+    auto [end, error] = std::from_chars(value.data() + (value[0] == '+' ? 1 : 0),
+                                        value.data() + length, number, std::chars_format::fixed);
+    if (error != std::errc() || end != value.data() + length || !std::isfinite(number)) {
+        return std::nullopt;
+    }
+    value.remove_prefix(length);
+    return number;
+}
+
+// Go-style durations as used by x-ratelimit-reset-*: "1s", "6m0s", "1h2m3.5s", "20ms"
+std::optional<double> parse_duration(std::string_view value) {
+    double seconds = 0.0;
+    bool any = false;
+    while (!value.empty()) {
+        auto number = consume_number(value);
+        if (!number.has_value()) {
+            return std::nullopt;
+        }
+        double scale = 0.0;
+        if (value.starts_with("ms")) {
+            scale = 1e-3;
+            value.remove_prefix(2);
+        } else if (value.starts_with("us")) {
+            scale = 1e-6;
+            value.remove_prefix(2);
+        } else if (value.starts_with("h")) {
+            scale = 3600.0;
+            value.remove_prefix(1);
+        } else if (value.starts_with("m")) {
+            scale = 60.0;
+            value.remove_prefix(1);
+        } else if (value.starts_with("s")) {
+            scale = 1.0;
+            value.remove_prefix(1);
+        } else {
+            return std::nullopt;
+        }
+        seconds += number.value() * scale;
+        any = true;
+    }
+    return any ? std::make_optional(seconds) : std::nullopt;
+}
+
+}  // namespace
+
+uint32_t intern_header_name(std::string_view name) {
+    auto& table = header_name_table();
+    {
+        std::shared_lock<std::shared_mutex> lock(table.mutex);
+        auto it = table.ids.find(name);
+        if (it != table.ids.end()) {
+            return it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(table.mutex);
+    auto it = table.ids.find(name);
+    if (it != table.ids.end()) {
+        return it->second;
+    }
+    auto id = static_cast<uint32_t>(table.names.size());
+    const std::string& stored = table.names.emplace_back(name);
+    table.ids.emplace(stored, id);
+    return id;
+}
+
+const std::string& header_name(uint32_t id) {
+    auto& table = header_name_table();
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    return table.names.at(id);
+}
+
+std::optional<double> parse_header_number(std::string_view value) {
+    value = trim(value);
+    if (value.empty()) {
+        return std::nullopt;
+    }
+
+    std::string_view rest = value;
+    auto number = consume_number(rest);
+    if (number.has_value() && rest.empty()) {
+        return number;
+    }
+
+    auto duration = parse_duration(value);
+    if (duration.has_value()) {
+        return duration;
+    }
+
+    // Server-Timing: "total;dur=123.4, queue;dur=5" (milliseconds)
+    size_t dur = value.find("dur=");
+    if (dur != std::string_view::npos) {
+        rest = value.substr(dur + 4);
+        number = consume_number(rest);
+        if (number.has_value()) {
+            return number.value() / 1000.0;
+        }
+    }
+    return std::nullopt;
+}
+
+HeaderCapture::HeaderCapture(const std::vector<std::string>& patterns) {
+    for (const auto& pattern : patterns) {
+        std::string lower = to_lower(trim(pattern));
+        if (lower.empty()) {
+            continue;
+        }
+        if (lower.back() == '*') {
+            lower.pop_back();
+            prefixes_.push_back(std::move(lower));
+        } else {
+            exact_.push_back(std::move(lower));
+        }
+    }
+}
+
+void HeaderCapture::capture(std::string_view name, std::string_view value,
+                            std::vector<CapturedHeader>& out) const {
+    std::string lower = to_lower(trim(name));
+    bool matches = std::find(exact_.begin(), exact_.end(), lower) != exact_.end() ||
+                   std::any_of(prefixes_.begin(), prefixes_.end(), [&lower](const auto& prefix) {
+                       return lower.starts_with(prefix);
+                   });
+    if (!matches) {
+        return;
+    }
+
+    CapturedHeader header;
+    header.name_id = intern_header_name(lower);
+    value = trim(value);
+    auto number = parse_header_number(value);
+    if (number.has_value() && std::isfinite(number.value())) {
+        header.is_numeric = true;
+        header.number = number.value();
+    } else {
+        header.text = value;
+    }
+    out.push_back(std::move(header));
+}
+
+std::vector<std::string> parse_header_patterns(const std::string& value) {
+    std::vector<std::string> patterns;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!trim(item).empty()) {
+            patterns.emplace_back(trim(item));
+        }
+    }
+    return patterns;
+}
+
+nlohmann::json HeaderSeries::to_json(std::chrono::steady_clock::time_point run_start) const {
+    auto sorted = points;
+    std::sort(sorted.begin(), sorted.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::vector<double> values;
+    nlohmann::json time_series = nlohmann::json::array();
+    double sum = 0.0;
+    for (const auto& [time, value] : sorted) {
+        values.push_back(value);
+        sum += value;
+        time_series.push_back({seconds_between(run_start, time).value_or(0.0), value});
+    }
+
+    nlohmann::json series_json;
+    series_json["count"] = values.size();
+    if (values.empty()) {
+        return series_json;
+    }
+    auto [min_it, max_it] = std::minmax_element(values.begin(), values.end());
+    double min_value = *min_it;
+    double max_value = *max_it;
+    series_json["min"] = min_value;
+    series_json["max"] = max_value;
+    series_json["mean"] = sum / static_cast<double>(values.size());
+    series_json["p50"] = percentile(values, 50);
+    series_json["p90"] = percentile(values, 90);
+    series_json["p99"] = percentile(values, 99);
+
+    // Equal-width bins over [min, max]; a constant series gets a single bin
+    size_t bins = max_value > min_value ? kHistogramBins : 1;
+    double width = bins > 1 ? (max_value - min_value) / static_cast<double>(bins) : 0.0;
+    std::vector<size_t> counts(bins, 0);
+    for (double value : values) {
+        size_t bin = width > 0 ? static_cast<size_t>((value - min_value) / width) : 0;
+        counts[std::min(bin, bins - 1)]++;
+    }
+    nlohmann::json edges = nlohmann::json::array();
+    for (size_t i = 0; i <= bins; ++i) {
+        edges.push_back(bins > 1 ? min_value + width * static_cast<double>(i)
+                                 : (i == 0 ? min_value : max_value));
+    }
+    series_json["histogram"] = {{"bin_edges", edges}, {"counts", counts}};
+    series_json["time_series"] = time_series;
+    return series_json;
+}
+
+}  // namespace bench_core
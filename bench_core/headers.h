@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bench_core {
+
+// Response header capture. Header names are interned process-wide so each
+// captured value costs one id plus either a parsed number or the raw text.
+
+// Id of a lower-cased header name, assigning a new one on first sight
+uint32_t intern_header_name(std::string_view name);
+
+// Name for an id returned by intern_header_name
+const std::string& header_name(uint32_t id);
+
+// Numeric value of a header, if it has one: plain numbers ("59", "0.25"),
+// durations ("1s", "6m0s", "20ms"), or the first dur= of a Server-Timing entry
+std::optional<double> parse_header_number(std::string_view value);
+
+struct CapturedHeader {
+    uint32_t name_id = 0;
+    bool is_numeric = false;
+    double number = 0.0;
+    std::string text;  // Only kept for non-numeric values
+};
+
+// Which response headers to keep. Patterns are case-insensitive header names,
+// and a trailing '*' matches any suffix, e.g. "x-ratelimit-*".
+class HeaderCapture {
+public:
+    HeaderCapture() = default;
+    explicit HeaderCapture(const std::vector<std::string>& patterns);
+
+    bool enabled() const { return !exact_.empty() || !prefixes_.empty(); }
+
+    // Append the header to out if it matches one of the patterns
+    void capture(std::string_view name, std::string_view value,
+                 std::vector<CapturedHeader>& out) const;
+
+private:
+    std::vector<std::string> exact_;
+    std::vector<std::string> prefixes_;
+};
+
+// Parse a comma separated pattern list, e.g. "x-request-id,x-ratelimit-*"
+std::vector<std::string> parse_header_patterns(const std::string& value);
+
+// Values of one numeric header across a run, exported as a time series and a
+// fixed-width histogram
+struct HeaderSeries {
+    static constexpr size_t kHistogramBins = 20;
+
+    std::vector<std::pair<std::chrono::steady_clock::time_point, double>> points;
+
+    nlohmann::json to_json(std::chrono::steady_clock::time_point run_start) const;
+};
+
+using HeaderSeriesMap = std::map<std::string, HeaderSeries>;
+
+}  // namespace bench_core
@@ -0,0 +1,228 @@
+#include "bench_core/http_client.h"
+
+#include <strings.h>
+#include <sys/socket.h>
+
+#include <charconv>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace bench_core {
+
+void http_global_init() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+        std::atexit(curl_global_cleanup);
+    });
+}
+
+HttpTransfer http_post_stream(const std::string& url, const std::string& api_key,
+                              const std::string& body, HttpStreamHandler& handler,
+                              const HttpOptions& options) {
+    thread_local CurlHandle curl;
+    CURL* handle = curl.get();
+    if (handle == nullptr) {
+        throw std::runtime_error("Failed to initialize libcurl handle");
+    }
+    curl_easy_reset(handle);
+
+    std::unique_ptr<curl_slist, decltype(&curl_slist_free_all)> headers(nullptr,
+                                                                         &curl_slist_free_all);
+    curl_slist* header_list = curl_slist_append(nullptr, "Content-Type: application/json");
+    header_list = curl_slist_append(header_list, ("Authorization: Bearer " + api_key).c_str());
+    // Large bodies would otherwise wait up to a second for "100 Continue"
+    header_list = curl_slist_append(header_list, "Expect:");
+    headers.reset(header_list);
+    std::unique_ptr<curl_slist, decltype(&curl_slist_free_all)> resolve(nullptr,
+                                                                         &curl_slist_free_all);
+    if (!options.resolve.empty()) {
+        resolve.reset(curl_slist_append(nullptr, options.resolve.c_str()));
+    }
+
+    struct TransferState {
+        HttpStreamHandler* handler;
+        const HttpOptions* options;
+        CURL* handle;
+        bool aborted = false;
+        size_t bytes_since_pause = 0;
+        size_t decoded_body_bytes = 0;
+        std::string content_encoding{};
+    } state{&handler, &options, handle};
+
+    auto header_callback = +[](char* data, size_t size, size_t nmemb, void* userdata) -> size_t {
+        auto* state = static_cast<TransferState*>(userdata);
+        std::string_view line(data, size * nmemb);
+        if (line.starts_with("HTTP/")) {
+            // "HTTP/1.1 200 OK" or "HTTP/2 200"
+            size_t space = line.find(' ');
+            long status_code = 0;
+            if (space != std::string_view::npos) {
+                std::from_chars(line.data() + space + 1, line.data() + line.size(), status_code);
+            }
+            state->handler->on_status(status_code);
+            state->decoded_body_bytes = 0;
+            state->content_encoding.clear();
+        } else if (size_t colon = line.find(':'); colon != std::string_view::npos) {
+            std::string_view value = line.substr(colon + 1);
+            while (!value.empty() && (value.back() == '\r' || value.back() == '\n')) {
+                value.remove_suffix(1);
+            }
+            std::string_view name = line.substr(0, colon);
+            if (name.size() == 16 && strncasecmp(name.data(), "content-encoding", 16) == 0) {
+                size_t begin = value.find_first_not_of(' ');
+                state->content_encoding =
+                    begin == std::string_view::npos ? "" : std::string(value.substr(begin));
+            }
+            state->handler->on_header(name, value);
+        }
+        return size * nmemb;
+    };
+    auto write_callback = +[](char* data, size_t size, size_t nmemb, void* userdata) -> size_t {
+        auto* state = static_cast<TransferState*>(userdata);
+        state->decoded_body_bytes += size * nmemb;
+        if (!state->handler->on_data(std::string_view(data, size * nmemb))) {
+            state->aborted = true;
+            return 0;
+        }
+        const auto& options = *state->options;
+        if (options.socket.tcp_quickack) {
+            curl_socket_t socket = CURL_SOCKET_BAD;
+            if (curl_easy_getinfo(state->handle, CURLINFO_ACTIVESOCKET, &socket) == CURLE_OK &&
+                socket != CURL_SOCKET_BAD) {
+                rearm_quickack(socket);
+            }
+        }
+        // Not reading lets the socket buffers fill, so the server sees backpressure
+        state->bytes_since_pause += size * nmemb;
+        if (options.pause_every_bytes > 0 &&
+            state->bytes_since_pause >= options.pause_every_bytes) {
+            state->bytes_since_pause = 0;
+            std::this_thread::sleep_for(std::chrono::duration<double>(options.pause_seconds));
+        }
+        return size * nmemb;
+    };
+    auto sockopt_callback = +[](void* userdata, curl_socket_t socket, curlsocktype /*purpose*/) {
+        const auto* options = static_cast<const HttpOptions*>(userdata);
+        apply_socket_options(socket, options->socket);
+        if (options->receive_buffer_bytes > 0) {
+            int receive_buffer = static_cast<int>(options->receive_buffer_bytes);
+            setsockopt(socket, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer));
+        }
+        return static_cast<int>(CURL_SOCKOPT_OK);
+    };
+
+    curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers.get());
+    curl_easy_setopt(handle, CURLOPT_POSTFIELDS, body.c_str());
+    curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(body.size()));
+    curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, header_callback);
+    curl_easy_setopt(handle, CURLOPT_HEADERDATA, &state);
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &state);
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    if (options.max_receive_bytes_per_second > 0) {
+        curl_easy_setopt(handle, CURLOPT_MAX_RECV_SPEED_LARGE,
+                         static_cast<curl_off_t>(options.max_receive_bytes_per_second));
+    }
+    if (resolve != nullptr) {
+        curl_easy_setopt(handle, CURLOPT_RESOLVE, resolve.get());
+    }
+    if (!options.accept_encoding.empty()) {
+        curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, options.accept_encoding.c_str());
+    }
+    if (options.socket.tcp_nodelay.has_value()) {
+        curl_easy_setopt(handle, CURLOPT_TCP_NODELAY, options.socket.tcp_nodelay.value() ? 1L : 0L);
+    }
+    if (options.socket.configured() || options.receive_buffer_bytes > 0) {
+        curl_easy_setopt(handle, CURLOPT_SOCKOPTFUNCTION, sockopt_callback);
+        curl_easy_setopt(handle, CURLOPT_SOCKOPTDATA, &options);
+    }
+    if (options.receive_buffer_bytes > 0) {
+        // libcurl clamps its buffer to at least 1 KiB
+        curl_easy_setopt(handle, CURLOPT_BUFFERSIZE,
+                         static_cast<long>(options.receive_buffer_bytes));
+        // The buffer size only applies to new sockets, and the throttled socket
+        // must not be reused by the worker's next, normal request
+        curl_easy_setopt(handle, CURLOPT_FRESH_CONNECT, 1L);
+        curl_easy_setopt(handle, CURLOPT_FORBID_REUSE, 1L);
+    }
+
+    CURLcode code = curl_easy_perform(handle);
+    HttpTransfer transfer;
+    char* remote_address = nullptr;
+    if (curl_easy_getinfo(handle, CURLINFO_PRIMARY_IP, &remote_address) == CURLE_OK &&
+        remote_address != nullptr) {
+        transfer.remote_address = remote_address;
+    }
+    if (code != CURLE_OK && !(code == CURLE_WRITE_ERROR && state.aborted)) {
+        throw HttpTransportError(std::string("HTTP request failed: ") + curl_easy_strerror(code),
+                                 transfer.remote_address);
+    }
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &transfer.status_code);
+    long request_size = 0;
+    long header_size = 0;
+    curl_off_t upload_size = 0;
+    curl_off_t download_size = 0;
+    curl_easy_getinfo(handle, CURLINFO_REQUEST_SIZE, &request_size);
+    curl_easy_getinfo(handle, CURLINFO_HEADER_SIZE, &header_size);
+    curl_easy_getinfo(handle, CURLINFO_SIZE_UPLOAD_T, &upload_size);
+    curl_easy_getinfo(handle, CURLINFO_SIZE_DOWNLOAD_T, &download_size);
+    // libcurl sends small bodies in the same buffer as the headers and then
+    // counts them in the request size too; larger ones go out separately
+    if (request_size > upload_size) {
+        request_size -= static_cast<long>(upload_size);
+    }
+    transfer.wire.request_header_bytes = static_cast<size_t>(request_size);
+    transfer.wire.request_body_bytes = static_cast<size_t>(upload_size);
+    transfer.wire.response_header_bytes = static_cast<size_t>(header_size);
+    transfer.wire.response_body_bytes = static_cast<size_t>(download_size);
+    transfer.wire.decoded_body_bytes = state.decoded_body_bytes;
+    transfer.wire.accept_encoding = options.accept_encoding;
+    transfer.wire.content_encoding = std::move(state.content_encoding);
+    long connects = 0;
+    curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &connects);
+    transfer.new_connection = connects > 0;
+    curl_socket_t socket = CURL_SOCKET_BAD;
+    if (curl_easy_getinfo(handle, CURLINFO_ACTIVESOCKET, &socket) == CURLE_OK &&
+        socket != CURL_SOCKET_BAD) {
+        transfer.tcp_info = read_tcp_info(socket);
+    }
+    return transfer;
+}
+
+HttpResponse http_post_json(const std::string& url, const std::string& api_key,
+                            const std::string& body, const HeaderCapture& capture,
+                            const HttpOptions& options) {
+    // Buffers the whole body, keeping the headers selected by capture
+    class BufferingHandler : public HttpStreamHandler {
+    public:
+        BufferingHandler(HttpResponse& response, const HeaderCapture& capture)
+            : response_(response), capture_(capture) {}
+        void on_status(long /*status_code*/) override {
+            response_.body.clear();
+            response_.headers.clear();
+        }
+        void on_header(std::string_view name, std::string_view value) override {
+            capture_.capture(name, value, response_.headers);
+        }
+        bool on_data(std::string_view data) override {
+            response_.body.append(data);
+            return true;
+        }
+
+    private:
+        HttpResponse& response_;
+        const HeaderCapture& capture_;
+    };
+
+    HttpResponse response;
+    BufferingHandler handler(response, capture);
+    static_cast<HttpTransfer&>(response) = http_post_stream(url, api_key, body, handler, options);
+    return response;
+}
+
+}  // namespace bench_core
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <curl/curl.h>
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "bench_core/headers.h"
+#include "bench_core/socket_options.h"
+#include "bench_core/wire_bytes.h"
+
+namespace bench_core {
+
+// Owns one libcurl easy handle. Handles are kept per thread so that keep-alive
+// connections are reused across requests issued by the same worker.
+class CurlHandle {
+public:
+    CurlHandle() : handle_(curl_easy_init()) {}
+    ~CurlHandle() {
+        if (handle_ != nullptr) {
+            curl_easy_cleanup(handle_);
+        }
+    }
+    CurlHandle(const CurlHandle&) = delete;
+    CurlHandle& operator=(const CurlHandle&) = delete;
+
+    CURL* get() const { return handle_; }
+
+private:
+    CURL* handle_;
+};
+
+// Outcome of a transfer, with details of the connection it used
+struct HttpTransfer {
+    long status_code = 0;
+    bool new_connection = false;
+    std::optional<TcpInfo> tcp_info;
+    std::string remote_address;
+    WireBytes wire;
+};
+
+struct HttpResponse : HttpTransfer {
+    std::string body;
+    std::vector<CapturedHeader> headers;
+};
+
+// Receives a response as it arrives. Redirects and interim responses each
+// start with on_status, so handlers should reset per-response state there.
+class HttpStreamHandler {
+public:
+    virtual ~HttpStreamHandler() = default;
+    virtual void on_status(long /*status_code*/) {}
+    virtual void on_header(std::string_view /*name*/, std::string_view /*value*/) {}
+    // Body bytes; return false to abort the transfer
+    virtual bool on_data(std::string_view data) = 0;
+};
+
+// Transport failure, with the address of the connection that was attempted
+class HttpTransportError : public std::runtime_error {
+public:
+    HttpTransportError(const std::string& message, std::string remote_address)
+        : std::runtime_error(message), remote_address_(std::move(remote_address)) {}
+
+    const std::string& remote_address() const { return remote_address_; }
+
+private:
+    std::string remote_address_;
+};
+
+// Initialize libcurl once per process, before any worker threads start
+void http_global_init();
+
+// Per-request transfer tuning, e.g. to emulate a slow client
+struct HttpOptions {
+    // Throttle body reads to this many bytes per second (0 = unlimited)
+    size_t max_receive_bytes_per_second = 0;
+    // Stop reading for pause_seconds after every pause_every_bytes (0 = never)
+    size_t pause_every_bytes = 0;
+    double pause_seconds = 0.0;
+    // SO_RCVBUF and libcurl receive buffer size (0 = defaults)
+    size_t receive_buffer_bytes = 0;
+    // Applied to every new connection
+    SocketOptions socket;
+    // CURLOPT_RESOLVE entry pinning the host to addresses, empty = resolver
+    std::string resolve;
+    // Accept-Encoding for the response, decoded by libcurl as it arrives so the
+    // handler still sees plain bytes; empty = no header
+    std::string accept_encoding;
+};
+
+// JSON POST that streams the response into handler. Returns the final status
+// and connection details; throws on transport errors, but not when the handler
+// aborted.
+HttpTransfer http_post_stream(const std::string& url, const std::string& api_key,
+                              const std::string& body, HttpStreamHandler& handler,
+                              const HttpOptions& options = {});
+
+// Plain JSON POST for endpoints liboai does not cover, such as batched embeddings
+HttpResponse http_post_json(const std::string& url, const std::string& api_key,
+                            const std::string& body, const HeaderCapture& capture = {},
+                            const HttpOptions& options = {});
+
+}  // namespace bench_core
@@ -0,0 +1,236 @@
+#include "bench_core/interference.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+namespace bench_core {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct ItlSample {
+    Clock::time_point time;
+    double itl = 0.0;
+};
+
+// Gaps between consecutive content chunks of every background choice stream
+std::vector<ItlSample> collect_itl_samples(const std::vector<CompletionStats>& background) {
+    std::vector<ItlSample> samples;
+    for (const auto& completion_stats : background) {
+        for (const auto& choice_stats : completion_stats.choices) {
+            const auto& times = choice_stats.chunk_times;
+            for (size_t i = 1; i < times.size(); ++i) {
+                samples.push_back({times[i], seconds_between(times[i - 1], times[i]).value_or(0)});
+            }
+        }
+    }
+    std::sort(samples.begin(), samples.end(),
+              [](const ItlSample& a, const ItlSample& b) { return a.time < b.time; });
+    return samples;
+}
+
+// ITL values of the samples that arrived in [from, to)
+std::vector<double> itl_between(const std::vector<ItlSample>& samples, Clock::time_point from,
+                                Clock::time_point to) {
+    auto first = std::lower_bound(
+        samples.begin(), samples.end(), from,
+        [](const ItlSample& sample, Clock::time_point time) { return sample.time < time; });
+    std::vector<double> values;
+    for (auto it = first; it != samples.end() && it->time < to; ++it) {
+        values.push_back(it->itl);
+    }
+    return values;
+}
+
+Clock::duration to_duration(double seconds) {
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+double mean_of(const std::vector<double>& values) {
+    double sum = 0.0;
+    for (double value : values) {
+        sum += value;
+    }
+    return values.empty() ? 0.0 : sum / static_cast<double>(values.size());
+}
+
+}  // namespace
+
+InterferenceResult run_interference(Engine& engine,
+                                    const std::vector<nlohmann::json>& background_requests,
+                                    const std::vector<nlohmann::json>& injection_requests,
+                                    const InterferenceConfig& config) {
+    if (background_requests.empty() || injection_requests.empty()) {
+        throw std::invalid_argument("Interference runs need background and injection requests");
+    }
+
+    InterferenceResult result;
+    auto start_time = Clock::now();
+
+    // Background population: each worker keeps exactly one stream in flight
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> next_background{0};
+    std::mutex background_mutex;
+    std::vector<std::thread> background_threads;
+    for (size_t i = 0; i < config.background_streams; ++i) {
+        background_threads.emplace_back([&]() {
+            while (!stop.load()) {
+                size_t index = next_background.fetch_add(1) % background_requests.size();
+                auto completion_stats = engine.execute(background_requests[index]);
+                std::lock_guard<std::mutex> lock(background_mutex);
+                result.background.second.push_back(std::move(completion_stats));
+            }
+        });
+    }
+
+    // Injections run on their own threads so a slow prefill never delays the schedule
+    result.injections.second.resize(config.injections);
+    std::vector<std::thread> injection_threads;
+    for (size_t k = 0; k < config.injections; ++k) {
+        std::this_thread::sleep_until(
+            start_time + to_duration(config.warmup_seconds +
+                                     config.injection_interval_seconds * static_cast<double>(k)));
+        injection_threads.emplace_back([&, k]() {
+            result.injections.second[k] =
+                engine.execute(injection_requests[k % injection_requests.size()]);
+        });
+    }
+    for (auto& thread : injection_threads) {
+        thread.join();
+    }
+
+    // Keep the background running until the last analysis window has closed
+    Clock::time_point window_end = Clock::now();
+    for (const auto& injection : result.injections.second) {
+        window_end =
+            std::max(window_end, injection.start_time + to_duration(config.window_seconds));
+    }
+    std::this_thread::sleep_until(window_end);
+    stop.store(true);
+    for (auto& thread : background_threads) {
+        thread.join();
+    }
+    auto end_time = Clock::now();
+
+    for (auto* stats : {&result.background, &result.injections}) {
+        stats->first = aggregate_stats(stats->second);
+        stats->first.start_time = start_time;
+        stats->first.end_time = end_time;
+    }
+    result.report =
+        analyze_interference(result.background.second, result.injections.second, config);
+    return result;
+}
+
+nlohmann::json analyze_interference(const std::vector<CompletionStats>& background,
+                                    const std::vector<CompletionStats>& injections,
+                                    const InterferenceConfig& config) {
+    const auto samples = collect_itl_samples(background);
+    auto run_start = Clock::time_point::max();
+    for (const auto* records : {&background, &injections}) {
+        for (const auto& completion_stats : *records) {
+            run_start = std::min(run_start, completion_stats.start_time);
+        }
+    }
+    const auto window = to_duration(config.window_seconds);
+    const auto bin = to_duration(config.bin_seconds);
+    const auto bins_per_side =
+        static_cast<size_t>(std::ceil(config.window_seconds / config.bin_seconds));
+
+    // Injection-aligned profile over [-window, +window), averaged across injections
+    std::vector<std::vector<double>> profile_p50(2 * bins_per_side);
+    std::vector<std::vector<double>> profile_max(2 * bins_per_side);
+
+    nlohmann::json injections_json = nlohmann::json::array();
+    std::vector<double> magnitudes;
+    std::vector<double> durations;
+    std::vector<double> recoveries;
+    for (size_t k = 0; k < injections.size(); ++k) {
+        const auto& injection = injections[k];
+        auto injected_at = injection.start_time;
+
+        auto baseline = itl_between(samples, injected_at - window, injected_at);
+        double baseline_p50 = percentile(baseline, 50);
+        double baseline_p99 = percentile(baseline, 99);
+
+        double peak_itl = 0.0;
+        std::optional<double> onset;
+        std::optional<double> recovery;
+        for (size_t b = 0; b < 2 * bins_per_side; ++b) {
+            auto bin_start = injected_at - window + bin * static_cast<Clock::rep>(b);
+            auto values = itl_between(samples, bin_start, bin_start + bin);
+            if (values.empty()) {
+                continue;
+            }
+            double bin_max = *std::max_element(values.begin(), values.end());
+            profile_p50[b].push_back(percentile(values, 50));
+            profile_max[b].push_back(bin_max);
+            if (b < bins_per_side) {
+                continue;
+            }
+
+            peak_itl = std::max(peak_itl, bin_max);
+            double offset = config.bin_seconds * static_cast<double>(b - bins_per_side);
+            if (!baseline.empty() && percentile(values, 90) > baseline_p99) {
+                if (!onset.has_value()) {
+                    onset = offset;
+                }
+                recovery = offset + config.bin_seconds;
+            }
+        }
+
+        nlohmann::json injection_json = {
+            {"index", k},
+            {"injected_at_seconds", seconds_between(run_start, injected_at).value_or(0.0)},
+            {"prompt_tokens", injection.api_usage.prompt_tokens},
+            {"ttft_duration_seconds", injection.get_ttft_duration().value_or(0.0)},
+            {"success", injection.success},
+            {"baseline_samples", baseline.size()},
+            {"baseline_itl_p50_seconds", baseline_p50},
+            {"baseline_itl_p99_seconds", baseline_p99},
+            {"peak_itl_seconds", peak_itl}};
+        if (baseline_p50 > 0) {
+            injection_json["spike_magnitude"] = peak_itl / baseline_p50;
+            magnitudes.push_back(peak_itl / baseline_p50);
+        }
+        if (onset.has_value()) {
+            injection_json["spike_onset_seconds"] = onset.value();
+            injection_json["spike_duration_seconds"] = recovery.value() - onset.value();
+            injection_json["recovery_seconds"] = recovery.value();
+            durations.push_back(recovery.value() - onset.value());
+            recoveries.push_back(recovery.value());
+        } else {
+            injection_json["spike_duration_seconds"] = 0.0;
+            injection_json["recovery_seconds"] = 0.0;
+            durations.push_back(0.0);
+            recoveries.push_back(0.0);
+        }
+        injections_json.push_back(injection_json);
+    }
+
+    nlohmann::json profile_json = nlohmann::json::array();
+    for (size_t b = 0; b < 2 * bins_per_side; ++b) {
+        profile_json.push_back(
+            {{"offset_seconds",
+              config.bin_seconds * (static_cast<double>(b) - static_cast<double>(bins_per_side))},
+             {"itl_p50_seconds", mean_of(profile_p50[b])},
+             {"itl_max_seconds", mean_of(profile_max[b])},
+             {"injections", profile_p50[b].size()}});
+    }
+
+    return {{"background_streams", config.background_streams},
+            {"itl_samples", samples.size()},
+            {"mean_spike_magnitude", mean_of(magnitudes)},
+            {"mean_spike_duration_seconds", mean_of(durations)},
+            {"mean_recovery_seconds", mean_of(recoveries)},
+            {"injections", injections_json},
+            {"aligned_itl", profile_json}};
+}
+
+}  // namespace bench_core
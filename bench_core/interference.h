@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "bench_core/engine.h"
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// Prefill/decode interference experiment. A steady population of background
+// streams keeps decoding while long-prompt requests are injected on a fixed
+// schedule; background inter-token latency is then aligned to the injection
+// times to measure the spike each prefill causes.
+struct InterferenceConfig {
+    size_t background_streams = 8;
+    size_t injections = 5;
+    // Background-only time before the first injection, also the baseline window
+    double warmup_seconds = 10.0;
+    double injection_interval_seconds = 15.0;
+    // Inter-token latency is analysed from window_seconds before to
+    // window_seconds after each injection, in bins of bin_seconds
+    double window_seconds = 5.0;
+    double bin_seconds = 0.1;
+};
+
+struct InterferenceResult {
+    Stats background;
+    Stats injections;
+    nlohmann::json report;
+};
+
+// Run the experiment. Background requests are issued round-robin by
+// background_streams workers until the last injection has finished and its
+// analysis window has passed; injection requests are used round-robin too.
+InterferenceResult run_interference(Engine& engine,
+                                    const std::vector<nlohmann::json>& background_requests,
+                                    const std::vector<nlohmann::json>& injection_requests,
+                                    const InterferenceConfig& config);
+
+// Align background inter-token latency to the injection start times. For each
+// injection: baseline ITL from the preceding window, peak ITL and its ratio to
+// the baseline median, and when ITL first and last exceeded the baseline p99
+// (bins whose p90 is above it), giving the spike onset, duration and recovery.
+nlohmann::json analyze_interference(const std::vector<CompletionStats>& background,
+                                    const std::vector<CompletionStats>& injections,
+                                    const InterferenceConfig& config);
+
+}  // namespace bench_core
@@ -0,0 +1,311 @@
+#include "bench_core/log.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "bench_core/rate_limiter.h"
+
+namespace bench_core {
+
+namespace {
+
+struct LogEntry {
+    LogLevel level = LogLevel::kInfo;
+    const char* message_class = "";
+    std::chrono::system_clock::time_point time;
+    std::string text;
+};
+
+// Single-producer/single-consumer ring owned by one thread. Buffers form a
+// lock-free list: threads push themselves at the head on their first message,
+// and only the flusher unlinks buffers whose thread has exited.
+class ThreadLogBuffer {
+public:
+    static constexpr size_t kCapacity = 1024;
+
+    ThreadLogBuffer() : entries_(kCapacity) {}
+
+    bool push(LogEntry&& entry) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == kCapacity) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        entries_[tail % kCapacity] = std::move(entry);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename Consumer>
+    void drain(Consumer&& consume) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            consume(entries_[head % kCapacity]);
+        }
+        head_.store(head, std::memory_order_release);
+    }
+
+    size_t take_dropped() { return dropped_.exchange(0, std::memory_order_relaxed); }
+
+    ThreadLogBuffer* next = nullptr;
+    std::atomic<bool> orphaned{false};
+
+private:
+    std::vector<LogEntry> entries_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    std::atomic<size_t> dropped_{0};
+};
+
+const char* level_name(LogLevel level) {
+    switch (level) {
+        case LogLevel::kInfo:
+            return "info";
+        case LogLevel::kWarning:
+            return "warning";
+        case LogLevel::kError:
+            return "error";
+    }
+    return "info";
+}
+
+const char* level_tag(LogLevel level) {
+    switch (level) {
+        case LogLevel::kInfo:
+            return "[INFO] ";
+        case LogLevel::kWarning:
+            return "[WARNING] ";
+        case LogLevel::kError:
+            return "[ERROR] ";
+    }
+    return "";
+}
+
+class AsyncLogger {
+public:
+    static constexpr auto kFlushInterval = std::chrono::milliseconds(100);
+    static constexpr auto kSummaryInterval = std::chrono::seconds(1);
+
+    static AsyncLogger& instance() {
+        static AsyncLogger logger;
+        return logger;
+    }
+
+    AsyncLogger() : flusher_([this] { flush_loop(); }) {}
+
+    ~AsyncLogger() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        cv_.notify_all();
+        flusher_.join();
+        std::lock_guard<std::mutex> lock(mutex_);
+        flush_locked(true);
+        for (auto* buffer = buffers_.load(std::memory_order_acquire); buffer != nullptr;) {
+            auto* next = buffer->next;
+            delete buffer;
+            buffer = next;
+        }
+        close_output();
+    }
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    void configure(const LogConfig& config) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flush_locked(true);
+        close_output();
+        if (!config.file.empty()) {
+            output_ = std::fopen(config.file.c_str(), "a");
+            if (output_ == nullptr) {
+                output_ = stderr;
+                throw std::runtime_error("Failed to open log file: " + config.file);
+            }
+        }
+        config_ = config;
+        classes_.clear();
+    }
+
+    void log(LogLevel level, const char* message_class, std::string message) {
+        thread_buffer().push(
+            {level, message_class, std::chrono::system_clock::now(), std::move(message)});
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flush_locked(true);
+    }
+
+private:
+    struct ClassState {
+        TokenBucket bucket;
+        size_t suppressed = 0;
+    };
+
+    // Marks the calling thread's buffer for reclamation when the thread exits
+    struct BufferOwner {
+        ThreadLogBuffer* buffer = nullptr;
+        ~BufferOwner() {
+            if (buffer != nullptr) {
+                buffer->orphaned.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    ThreadLogBuffer& thread_buffer() {
+        thread_local BufferOwner owner;
+        if (owner.buffer == nullptr) {
+            auto* buffer = new ThreadLogBuffer();
+            buffer->next = buffers_.load(std::memory_order_relaxed);
+            while (!buffers_.compare_exchange_weak(buffer->next, buffer,
+                                                   std::memory_order_release,
+                                                   std::memory_order_relaxed)) {
+            }
+            owner.buffer = buffer;
+        }
+        return *owner.buffer;
+    }
+
+    void flush_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!cv_.wait_for(lock, kFlushInterval, [this] { return stopped_; })) {
+            flush_locked(false);
+        }
+    }
+
+    // Drain every buffer, unlinking those of exited threads. Only the head can
+    // change concurrently (new threads push there), so interior nodes are
+    // unlinked directly and the head only with a CAS.
+    void flush_locked(bool force_summary) {
+        auto now = std::chrono::steady_clock::now();
+        ThreadLogBuffer* previous = nullptr;
+        auto* buffer = buffers_.load(std::memory_order_acquire);
+        while (buffer != nullptr) {
+            bool orphaned = buffer->orphaned.load(std::memory_order_acquire);
+            buffer->drain([&](LogEntry& entry) { write_entry(entry, now); });
+            dropped_ += buffer->take_dropped();
+            auto* next = buffer->next;
+            if (orphaned) {
+                if (previous != nullptr) {
+                    previous->next = next;
+                    delete buffer;
+                    buffer = next;
+                    continue;
+                }
+                auto* expected = buffer;
+                if (buffers_.compare_exchange_strong(expected, next, std::memory_order_acq_rel)) {
+                    delete buffer;
+                    buffer = next;
+                    continue;
+                }
+            }
+            previous = buffer;
+            buffer = next;
+        }
+
+        if (force_summary || now - last_summary_ >= kSummaryInterval) {
+            write_summaries();
+            last_summary_ = now;
+        }
+        std::fflush(output_);
+    }
+
+    void write_entry(LogEntry& entry, std::chrono::steady_clock::time_point now) {
+        if (config_.max_messages_per_second > 0) {
+            auto [it, inserted] = classes_.try_emplace(
+                entry.message_class,
+                ClassState{TokenBucket(config_.max_messages_per_second * 60.0,
+                                       config_.burst_seconds)});
+            auto& state = it->second;
+            state.bucket.refill(now);
+            if (state.bucket.seconds_until_available(1.0) > 0) {
+                state.suppressed++;
+                return;
+            }
+            state.bucket.take(1.0);
+        }
+        write_line(entry.level, entry.message_class, entry.text, entry.time);
+        entry.text.clear();
+        entry.text.shrink_to_fit();
+    }
+
+    void write_summaries() {
+        auto time = std::chrono::system_clock::now();
+        for (auto& [message_class, state] : classes_) {
+            if (state.suppressed > 0) {
+                write_line(LogLevel::kWarning, "log",
+                           "Suppressed " + std::to_string(state.suppressed) + " '" +
+                               message_class + "' messages",
+                           time);
+                state.suppressed = 0;
+            }
+        }
+        if (dropped_ > 0) {
+            write_line(LogLevel::kWarning, "log",
+                       "Dropped " + std::to_string(dropped_) + " messages (log buffer full)",
+                       time);
+            dropped_ = 0;
+        }
+    }
+
+    void write_line(LogLevel level, const std::string& message_class, const std::string& text,
+                    std::chrono::system_clock::time_point time) {
+        std::string line;
+        if (config_.json_lines) {
+            nlohmann::json record = {
+                {"time", std::chrono::duration<double>(time.time_since_epoch()).count()},
+                {"level", level_name(level)},
+                {"class", message_class},
+                {"message", text}};
+            line = record.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+        } else {
+            line = level_tag(level) + text;
+        }
+        line += '\n';
+        std::fwrite(line.data(), 1, line.size(), output_);
+    }
+
+    void close_output() {
+        if (output_ != stderr) {
+            std::fclose(output_);
+            output_ = stderr;
+        }
+    }
+
+    std::atomic<ThreadLogBuffer*> buffers_{nullptr};
+
+    // Flusher state, guarded by mutex_
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopped_ = false;
+    LogConfig config_;
+    std::FILE* output_ = stderr;
+    std::map<std::string, ClassState> classes_;
+    size_t dropped_ = 0;
+    std::chrono::steady_clock::time_point last_summary_ = std::chrono::steady_clock::now();
+    std::thread flusher_;
+};
+
+}  // namespace
+
+void configure_logging(const LogConfig& config) { AsyncLogger::instance().configure(config); }
+
+void log_message(LogLevel level, const char* message_class, std::string message) {
+    AsyncLogger::instance().log(level, message_class, std::move(message));
+}
+
+void flush_logging() { AsyncLogger::instance().flush(); }
+
+}  // namespace bench_core
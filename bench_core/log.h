@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace bench_core {
+
+// Asynchronous logging for worker threads. Messages go into a per-thread
+// single-producer ring and are written by a background flusher, so logging
+// never takes a lock or waits on stderr; a full ring drops the message and
+// counts it. The flusher rate-limits each message class and periodically
+// reports how many messages of a class were suppressed.
+enum class LogLevel { kInfo, kWarning, kError };
+
+struct LogConfig {
+    // One JSON object per line instead of "[ERROR] message"
+    bool json_lines = false;
+    // Destination file, empty = stderr
+    std::string file;
+    // Messages written per class and second before suppression, 0 = unlimited
+    double max_messages_per_second = 10.0;
+    // Burst allowance, in seconds of the rate above
+    double burst_seconds = 5.0;
+};
+
+// Apply a configuration; call before the workers start. Throws
+// std::runtime_error if the log file cannot be opened.
+void configure_logging(const LogConfig& config);
+
+// Queue a message. message_class groups messages for rate limiting and must be
+// a string literal (it is stored by pointer).
+void log_message(LogLevel level, const char* message_class, std::string message);
+
+// Write out everything queued so far, including suppression summaries
+void flush_logging();
+
+}  // namespace bench_core
@@ -0,0 +1,87 @@
+#include "bench_core/ordering.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+#include "bench_core/rate_limiter.h"
+
+namespace bench_core {
+
+OrderingPolicy parse_ordering_policy(const std::string& value) {
+    if (value == "fifo") {
+        return OrderingPolicy::kFifo;
+    }
+    if (value == "shortest_first") {
+        return OrderingPolicy::kShortestFirst;
+    }
+    if (value == "longest_first") {
+        return OrderingPolicy::kLongestFirst;
+    }
+    if (value == "interleaved") {
+        return OrderingPolicy::kInterleaved;
+    }
+    if (value == "random") {
+        return OrderingPolicy::kRandom;
+    }
+    throw std::invalid_argument("Unknown request order: " + value);
+}
+
+OrderingKey parse_ordering_key(const std::string& value) {
+    if (value == "prompt_length") {
+        return OrderingKey::kPromptLength;
+    }
+    if (value == "output_length") {
+        return OrderingKey::kExpectedOutput;
+    }
+    throw std::invalid_argument("Unknown ordering key: " + value);
+}
+
+std::vector<size_t> dispatch_order(const std::vector<nlohmann::json>& requests,
+                                   OrderingPolicy policy, OrderingKey key, unsigned int seed) {
+    std::vector<size_t> order(requests.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    if (policy == OrderingPolicy::kFifo) {
+        return order;
+    }
+    if (policy == OrderingPolicy::kRandom) {
+        std::mt19937 rng(seed);
+        std::shuffle(order.begin(), order.end(), rng);
+        return order;
+    }
+
+    // Same estimates the rate limiter charges up front
+    std::vector<double> lengths;
+    lengths.reserve(requests.size());
+    for (const auto& request : requests) {
+        auto cost = RateLimiter::estimate_cost(request);
+        lengths.push_back(key == OrderingKey::kPromptLength ? cost.prompt_tokens
+                                                            : cost.completion_tokens);
+    }
+    if (policy == OrderingPolicy::kLongestFirst) {
+        std::stable_sort(order.begin(), order.end(),
+                         [&lengths](size_t a, size_t b) { return lengths[a] > lengths[b]; });
+        return order;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&lengths](size_t a, size_t b) { return lengths[a] < lengths[b]; });
+
+    if (policy == OrderingPolicy::kInterleaved) {
+        std::vector<size_t> interleaved;
+        interleaved.reserve(order.size());
+        size_t low = 0;
+        size_t high = order.size();
+        while (low < high) {
+            interleaved.push_back(order[--high]);
+            if (low < high) {
+                interleaved.push_back(order[low++]);
+            }
+        }
+        order = std::move(interleaved);
+    }
+    return order;
+}
+
+}  // namespace bench_core
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace bench_core {
+
+// Client-side order in which workers pick up requests, for experiments on how
+// request mix and arrival order affect server-side batching and tail TTFT
+enum class OrderingPolicy {
+    kFifo,           // File order
+    kShortestFirst,  // Ascending by the ordering key
+    kLongestFirst,   // Descending by the ordering key
+    kInterleaved,    // Alternating longest and shortest remaining
+    kRandom,         // Seeded shuffle
+};
+
+// Length each request is ranked by
+enum class OrderingKey {
+    kPromptLength,    // Estimated prompt tokens
+    kExpectedOutput,  // max_tokens times the number of sequences
+};
+
+// Parse "fifo", "shortest_first", "longest_first", "interleaved" or "random"
+OrderingPolicy parse_ordering_policy(const std::string& value);
+
+// Parse "prompt_length" or "output_length"
+OrderingKey parse_ordering_key(const std::string& value);
+
+// Permutation of request indices in dispatch order. Ties keep file order.
+std::vector<size_t> dispatch_order(const std::vector<nlohmann::json>& requests,
+                                   OrderingPolicy policy, OrderingKey key, unsigned int seed);
+
+}  // namespace bench_core
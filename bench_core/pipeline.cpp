@@ -0,0 +1,69 @@
+#include "bench_core/pipeline.h"
+
+#include <algorithm>
+
+namespace bench_core {
+
+namespace {
+
+double to_seconds(int64_t nanoseconds) { return static_cast<double>(nanoseconds) / 1e9; }
+
+int64_t to_nanoseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+template <typename Value>
+void update_max(std::atomic<Value>& maximum, Value value) {
+    Value current = maximum.load(std::memory_order_relaxed);
+    while (value > current &&
+           !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+}  // namespace
+
+nlohmann::json StageMetrics::to_json(double run_seconds) const {
+    size_t items = items_.load(std::memory_order_relaxed);
+    double busy_seconds = to_seconds(busy_ns_.load(std::memory_order_relaxed));
+    double capacity_seconds = run_seconds * static_cast<double>(threads_);
+    return {{"stage", name_},
+            {"threads", threads_},
+            {"items", items},
+            {"items_per_second", run_seconds > 0 ? items / run_seconds : 0.0},
+            {"busy_seconds", busy_seconds},
+            {"utilization", capacity_seconds > 0 ? busy_seconds / capacity_seconds : 0.0}};
+}
+
+void QueueMetrics::record_push(size_t depth, std::chrono::steady_clock::duration blocked) {
+    pushed_.fetch_add(1, std::memory_order_relaxed);
+    depth_sum_.fetch_add(depth, std::memory_order_relaxed);
+    update_max(max_depth_, depth);
+    blocked_ns_.fetch_add(to_nanoseconds(blocked), std::memory_order_relaxed);
+}
+
+void QueueMetrics::record_pop(std::chrono::steady_clock::duration wait,
+                              std::chrono::steady_clock::duration idle) {
+    popped_.fetch_add(1, std::memory_order_relaxed);
+    wait_ns_.fetch_add(to_nanoseconds(wait), std::memory_order_relaxed);
+    update_max(max_wait_ns_, to_nanoseconds(wait));
+    idle_ns_.fetch_add(to_nanoseconds(idle), std::memory_order_relaxed);
+}
+
+nlohmann::json QueueMetrics::to_json() const {
+    size_t pushed = pushed_.load(std::memory_order_relaxed);
+    size_t popped = popped_.load(std::memory_order_relaxed);
+    double items = static_cast<double>(std::max<size_t>(1, pushed));
+    return {{"queue", name_},
+            {"capacity", capacity_},
+            {"items", pushed},
+            {"mean_depth", depth_sum_.load(std::memory_order_relaxed) / items},
+            {"max_depth", max_depth_.load(std::memory_order_relaxed)},
+            {"mean_wait_seconds",
+             to_seconds(wait_ns_.load(std::memory_order_relaxed)) /
+                 static_cast<double>(std::max<size_t>(1, popped))},
+            {"max_wait_seconds", to_seconds(max_wait_ns_.load(std::memory_order_relaxed))},
+            {"producer_blocked_seconds", to_seconds(blocked_ns_.load(std::memory_order_relaxed))},
+            {"consumer_idle_seconds", to_seconds(idle_ns_.load(std::memory_order_relaxed))}};
+}
+
+}  // namespace bench_core
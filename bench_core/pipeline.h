@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "bench_core/bounded_queue.h"
+
+namespace bench_core {
+
+// Staged execution of a run: scheduler threads pick and plan the next request,
+// transport threads (one per concurrent request) wait for the client-side rate
+// limit, send it and decode the stream, and aggregator threads update the live counters and feed
+// the sinks. Stages hand requests over through bounded lock-free queues.
+struct PipelineConfig {
+    bool enabled = false;
+    size_t scheduler_threads = 1;
+    size_t aggregator_threads = 1;
+    // Capacity of each queue between stages; 0 = twice the transport threads
+    size_t queue_capacity = 0;
+};
+
+// Busy time and item count of one stage, updated by its threads
+class StageMetrics {
+public:
+    StageMetrics(std::string name, size_t threads) : name_(std::move(name)), threads_(threads) {}
+
+    void record(std::chrono::steady_clock::duration busy) {
+        items_.fetch_add(1, std::memory_order_relaxed);
+        busy_ns_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(busy).count(),
+                           std::memory_order_relaxed);
+    }
+
+    // Items, items per second, busy seconds and utilization (busy time over
+    // threads times run time)
+    nlohmann::json to_json(double run_seconds) const;
+
+private:
+    std::string name_;
+    size_t threads_;
+    std::atomic<size_t> items_{0};
+    std::atomic<int64_t> busy_ns_{0};
+};
+
+// Metrics of a queue between stages: depth seen by arriving items, time items
+// wait in the queue, and time producers spend blocked on a full queue and
+// consumers idle on an empty one
+class QueueMetrics {
+public:
+    QueueMetrics(std::string name, size_t capacity)
+        : name_(std::move(name)), capacity_(capacity) {}
+
+    const std::string& name() const { return name_; }
+
+    size_t depth() const {
+        size_t pushed = pushed_.load(std::memory_order_relaxed);
+        size_t popped = popped_.load(std::memory_order_relaxed);
+        return pushed > popped ? pushed - popped : 0;
+    }
+
+    void record_push(size_t depth, std::chrono::steady_clock::duration blocked);
+    void record_pop(std::chrono::steady_clock::duration wait,
+                    std::chrono::steady_clock::duration idle);
+
+    nlohmann::json to_json() const;
+
+private:
+    std::string name_;
+    size_t capacity_;
+    std::atomic<size_t> pushed_{0};
+    std::atomic<size_t> popped_{0};
+    std::atomic<size_t> depth_sum_{0};
+    std::atomic<size_t> max_depth_{0};
+    std::atomic<int64_t> wait_ns_{0};
+    std::atomic<int64_t> max_wait_ns_{0};
+    std::atomic<int64_t> blocked_ns_{0};
+    std::atomic<int64_t> idle_ns_{0};
+};
+
+// Wait step of a thread blocked on a queue: a few yields, then short sleeps
+class Backoff {
+public:
+    void wait() {
+        if (attempts_++ < kYields) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(kSleep);
+        }
+    }
+
+private:
+    static constexpr size_t kYields = 64;
+    static constexpr auto kSleep = std::chrono::microseconds(20);
+    size_t attempts_ = 0;
+};
+
+// Blocking queue between two stages over a BoundedQueue. Producers spin with
+// backoff while it is full; consumers while it is empty, until it is closed
+// and drained.
+template <typename T>
+class StageQueue {
+public:
+    StageQueue(std::string name, size_t capacity)
+        : queue_(capacity), metrics_(std::move(name), queue_.capacity()) {}
+
+    void push(T value) {
+        auto start = std::chrono::steady_clock::now();
+        Entry entry{std::move(value), start};
+        Backoff backoff;
+        while (!queue_.try_push(entry)) {
+            backoff.wait();
+            // Queue wait starts when the item gets in, not while blocked
+            entry.enqueued = std::chrono::steady_clock::now();
+        }
+        metrics_.record_push(metrics_.depth() + 1, entry.enqueued - start);
+    }
+
+    // False once the queue is closed and empty
+    bool pop(T& value) {
+        auto start = std::chrono::steady_clock::now();
+        Entry entry;
+        Backoff backoff;
+        while (!queue_.try_pop(entry)) {
+            if (closed_.load(std::memory_order_acquire) && metrics_.depth() == 0) {
+                return false;
+            }
+            backoff.wait();
+        }
+        auto now = std::chrono::steady_clock::now();
+        metrics_.record_pop(now - entry.enqueued, now - start);
+        value = std::move(entry.value);
+        return true;
+    }
+
+    // Called once every producer has finished
+    void close() { closed_.store(true, std::memory_order_release); }
+
+    const QueueMetrics& metrics() const { return metrics_; }
+
+private:
+    struct Entry {
+        T value{};
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    BoundedQueue<Entry> queue_;
+    QueueMetrics metrics_;
+    std::atomic<bool> closed_{false};
+};
+
+}  // namespace bench_core
@@ -0,0 +1,95 @@
+#include "bench_core/ramp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace bench_core {
+
+namespace {
+
+nlohmann::json summarize_phase(const std::vector<const CompletionStats*>& phase,
+                               double duration_seconds) {
+    size_t failures = 0;
+    size_t completion_tokens = 0;
+    std::vector<double> ttfts;
+    std::vector<double> latencies;
+    for (const auto* completion_stats : phase) {
+        completion_tokens += completion_stats->api_usage.completion_tokens;
+        if (!completion_stats->success) {
+            failures++;
+            continue;
+        }
+        auto ttft = completion_stats->get_ttft_duration();
+        if (ttft.has_value()) {
+            ttfts.push_back(ttft.value());
+        }
+        auto latency = completion_stats->get_total_duration();
+        if (latency.has_value()) {
+            latencies.push_back(latency.value());
+        }
+    }
+    return {{"duration_seconds", duration_seconds},
+            {"number_requests", phase.size()},
+            {"number_failures", failures},
+            {"ttft_p50_seconds", percentile(ttfts, 50)},
+            {"ttft_p99_seconds", percentile(ttfts, 99)},
+            {"latency_p50_seconds", percentile(latencies, 50)},
+            {"latency_p99_seconds", percentile(latencies, 99)},
+            {"completion_tokens_per_second",
+             duration_seconds > 0 ? completion_tokens / duration_seconds : 0.0}};
+}
+
+}  // namespace
+
+RampPolicy parse_ramp_policy(const std::string& value) {
+    if (value == "none") {
+        return RampPolicy::kNone;
+    }
+    if (value == "linear") {
+        return RampPolicy::kLinear;
+    }
+    if (value == "step") {
+        return RampPolicy::kStep;
+    }
+    if (value == "rate") {
+        return RampPolicy::kRate;
+    }
+    throw std::invalid_argument("Unknown ramp policy: " + value);
+}
+
+double RampConfig::start_offset(size_t worker, size_t workers) const {
+    switch (policy) {
+        case RampPolicy::kNone:
+            return 0.0;
+        case RampPolicy::kLinear:
+            return workers > 1 ? duration_seconds * static_cast<double>(worker) /
+                                     static_cast<double>(workers - 1)
+                               : 0.0;
+        case RampPolicy::kStep:
+            return step_seconds *
+                   std::floor(static_cast<double>(worker) /
+                              static_cast<double>(std::max<size_t>(1, step_workers)));
+        case RampPolicy::kRate:
+            return rate_per_second > 0 ? static_cast<double>(worker) / rate_per_second : 0.0;
+    }
+    return 0.0;
+}
+
+nlohmann::json summarize_phases(const std::vector<CompletionStats>& all_completion_stats,
+                                std::chrono::steady_clock::time_point start_time,
+                                std::chrono::steady_clock::time_point ramp_end,
+                                std::chrono::steady_clock::time_point end_time) {
+    std::vector<const CompletionStats*> ramp;
+    std::vector<const CompletionStats*> steady;
+    for (const auto& completion_stats : all_completion_stats) {
+        (completion_stats.start_time < ramp_end ? ramp : steady).push_back(&completion_stats);
+    }
+    // A ramp that outlasts the workload has no steady phase
+    ramp_end = std::min(ramp_end, end_time);
+    return {{"ramp", summarize_phase(ramp, seconds_between(start_time, ramp_end).value_or(0.0))},
+            {"steady",
+             summarize_phase(steady, seconds_between(ramp_end, end_time).value_or(0.0))}};
+}
+
+}  // namespace bench_core
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// How workers (and with them their connections) are brought up at the start of
+// a run. Starting every worker at once is a thundering herd of TLS handshakes
+// and simultaneous prefills; a ramp spreads them out.
+enum class RampPolicy {
+    kNone,    // All workers at once
+    kLinear,  // Evenly over duration_seconds
+    kStep,    // step_workers more every step_seconds
+    kRate,    // rate_per_second new workers (connections) per second
+};
+
+// Parse "none", "linear", "step" or "rate"; throws std::invalid_argument otherwise
+RampPolicy parse_ramp_policy(const std::string& value);
+
+struct RampConfig {
+    RampPolicy policy = RampPolicy::kNone;
+    double duration_seconds = 10.0;
+    size_t step_workers = 1;
+    double step_seconds = 1.0;
+    double rate_per_second = 1.0;
+
+    bool enabled() const { return policy != RampPolicy::kNone; }
+
+    // Seconds after the run start at which worker `worker` of `workers` starts
+    double start_offset(size_t worker, size_t workers) const;
+
+    // Seconds until the last worker has started
+    double duration(size_t workers) const {
+        return workers > 0 ? start_offset(workers - 1, workers) : 0.0;
+    }
+};
+
+// Ramp and steady phase metrics, split by request start time: requests,
+// failures, TTFT and latency percentiles and completion tokens per second
+nlohmann::json summarize_phases(const std::vector<CompletionStats>& all_completion_stats,
+                                std::chrono::steady_clock::time_point start_time,
+                                std::chrono::steady_clock::time_point ramp_end,
+                                std::chrono::steady_clock::time_point end_time);
+
+}  // namespace bench_core
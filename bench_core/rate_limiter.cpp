@@ -0,0 +1,108 @@
+#include "bench_core/rate_limiter.h"
+
+#include <cmath>
+#include <thread>
+
+namespace bench_core {
+
+namespace {
+
+// Characters of a chat message's content: a string, or an array of parts of
+// which the text parts count
+size_t message_characters(const nlohmann::json& message) {
+    if (!message.is_object() || !message.contains("content")) {
+        return 0;
+    }
+    const auto& content = message["content"];
+    if (content.is_string()) {
+        return content.get_ref<const std::string&>().size();
+    }
+    size_t characters = 0;
+    if (content.is_array()) {
+        for (const auto& part : content) {
+            if (part.is_object() && part.contains("text") && part["text"].is_string()) {
+                characters += part["text"].get_ref<const std::string&>().size();
+            }
+        }
+    }
+    return characters;
+}
+
+}  // namespace
+
+RateLimiter::Cost RateLimiter::estimate_cost(const nlohmann::json& request) {
+    Cost cost;
+    size_t characters = 0;
+    for (const char* field : {"prompt", "input"}) {
+        if (!request.contains(field)) {
+            continue;
+        }
+        const auto& value = request[field];
+        if (value.is_string()) {
+            characters += value.get_ref<const std::string&>().size();
+        } else if (value.is_array()) {
+            for (const auto& item : value) {
+                characters += item.is_string() ? item.get_ref<const std::string&>().size() : 0;
+            }
+        }
+    }
+    if (request.contains("messages") && request["messages"].is_array()) {
+        for (const auto& message : request["messages"]) {
+            characters += message_characters(message);
+        }
+    }
+    cost.prompt_tokens = std::ceil(static_cast<double>(characters) / kCharsPerToken);
+
+    int sequences = std::max(request.value("n", 1), request.value("best_of", 1));
+    // Chat requests may give the newer max_completion_tokens instead
+    int max_tokens = request.value("max_tokens", request.value("max_completion_tokens", 0));
+    cost.completion_tokens = static_cast<double>(max_tokens * sequences);
+    return cost;
+}
+
+double RateLimiter::acquire(const Cost& cost) {
+    auto wait_start = std::chrono::steady_clock::now();
+    while (true) {
+        double wait_seconds = 0.0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto now = std::chrono::steady_clock::now();
+            for (auto* bucket : {&requests_, &prompt_tokens_, &completion_tokens_}) {
+                bucket->refill(now);
+            }
+            if (requests_.enabled()) {
+                wait_seconds = std::max(wait_seconds, requests_.seconds_until_available(1.0));
+            }
+            if (prompt_tokens_.enabled()) {
+                wait_seconds = std::max(
+                    wait_seconds, prompt_tokens_.seconds_until_available(cost.prompt_tokens));
+            }
+            if (completion_tokens_.enabled()) {
+                wait_seconds =
+                    std::max(wait_seconds,
+                             completion_tokens_.seconds_until_available(cost.completion_tokens));
+            }
+            if (wait_seconds <= 0) {
+                requests_.take(1.0);
+                prompt_tokens_.take(cost.prompt_tokens);
+                completion_tokens_.take(cost.completion_tokens);
+                return std::chrono::duration<double>(now - wait_start).count();
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(wait_seconds));
+    }
+}
+
+void RateLimiter::reconcile(const Cost& estimated, size_t prompt_tokens,
+                            size_t completion_tokens) {
+    reconcile(estimated,
+              {static_cast<double>(prompt_tokens), static_cast<double>(completion_tokens)});
+}
+
+void RateLimiter::reconcile(const Cost& estimated, const Cost& actual) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    prompt_tokens_.take(actual.prompt_tokens - estimated.prompt_tokens);
+    completion_tokens_.take(actual.completion_tokens - estimated.completion_tokens);
+}
+
+}  // namespace bench_core
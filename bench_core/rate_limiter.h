@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <nlohmann/json.hpp>
+
+namespace bench_core {
+
+// Classic token bucket refilled continuously at a per-minute rate. The bucket
+// holds at most burst_seconds worth of quota so a run cannot front-load a whole
+// minute of traffic. A rate of 0 disables the bucket.
+class TokenBucket {
+public:
+    TokenBucket(double per_minute, double burst_seconds)
+        : rate_per_second_(per_minute / 60.0)
+        , capacity_(std::max(1.0, rate_per_second_ * burst_seconds))
+        , tokens_(capacity_)
+        , last_refill_(std::chrono::steady_clock::now()) {}
+
+    bool enabled() const { return rate_per_second_ > 0; }
+
+    void refill(std::chrono::steady_clock::time_point now) {
+        double elapsed = std::chrono::duration<double>(now - last_refill_).count();
+        tokens_ = std::min(capacity_, tokens_ + elapsed * rate_per_second_);
+        last_refill_ = now;
+    }
+
+    // Seconds until `amount` can be taken. Amounts above the capacity are
+    // granted once the bucket is full, leaving it in debt.
+    double seconds_until_available(double amount) const {
+        double needed = std::min(amount, capacity_) - tokens_;
+        return needed > 0 ? needed / rate_per_second_ : 0.0;
+    }
+
+    // Take (positive) or return (negative) quota
+    void take(double amount) { tokens_ = std::min(capacity_, tokens_ - amount); }
+
+private:
+    double rate_per_second_;
+    double capacity_;
+    double tokens_;
+    std::chrono::steady_clock::time_point last_refill_;
+};
+
+// Client-side RPM/TPM limiter shared by all workers. Prompt tokens are
+// estimated from the request text and completion tokens from max_tokens; both
+// are reconciled with the reported usage once a request finishes, so quota is
+// charged for what was actually used. Requests that report no usage keep their
+// estimate, since the server may still have charged them.
+class RateLimiter {
+public:
+    static constexpr double kCharsPerToken = 4.0;
+
+    struct Cost {
+        double prompt_tokens = 0.0;
+        double completion_tokens = 0.0;
+    };
+
+    RateLimiter(double requests_per_minute, double prompt_tokens_per_minute,
+                double completion_tokens_per_minute, double burst_seconds)
+        : requests_(requests_per_minute, burst_seconds)
+        , prompt_tokens_(prompt_tokens_per_minute, burst_seconds)
+        , completion_tokens_(completion_tokens_per_minute, burst_seconds) {}
+
+    bool enabled() const {
+        return requests_.enabled() || prompt_tokens_.enabled() || completion_tokens_.enabled();
+    }
+
+    // Estimate the cost of a request before it is issued, from the prompt,
+    // embedding input or chat message text and the completion token limit
+    static Cost estimate_cost(const nlohmann::json& request);
+
+    // Block until the request fits in every enabled bucket, then charge it.
+    // Returns the number of seconds spent waiting.
+    double acquire(const Cost& cost);
+
+    // Charge the difference between the estimated and the reported usage
+    void reconcile(const Cost& estimated, size_t prompt_tokens, size_t completion_tokens);
+    // Charge the difference between the estimated and another known cost
+    void reconcile(const Cost& estimated, const Cost& actual);
+
+private:
+    std::mutex mutex_;
+    TokenBucket requests_;
+    TokenBucket prompt_tokens_;
+    TokenBucket completion_tokens_;
+};
+
+}  // namespace bench_core
@@ -0,0 +1,41 @@
+#include "bench_core/requests.h"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace bench_core {
+
+std::vector<nlohmann::json> load_requests_from_jsonl(const std::string& filename) {
+    std::vector<nlohmann::json> requests;
+    std::ifstream file(filename);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open input file: " + filename);
+    }
+
+    std::string line;
+    int line_number = 0;
+
+    while (std::getline(file, line)) {
+        line_number++;
+        if (line.empty()) {
+            continue;
+        }
+
+        try {
+            nlohmann::json request = nlohmann::json::parse(line);
+            requests.push_back(request);
+        } catch (const nlohmann::json::parse_error& e) {
+            std::cerr << "Warning: Failed to parse JSON on line " << line_number << ": " << e.what()
+                      << '\n';
+        }
+    }
+
+    file.close();
+    std::cout << "[INFO] Loaded " + std::to_string(requests.size()) + " requests from " + filename
+              << '\n';
+    return requests;
+}
+
+}  // namespace bench_core
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace bench_core {
+
+// Load completion requests from JSONL file
+std::vector<nlohmann::json> load_requests_from_jsonl(const std::string& filename);
+
+// Where the engine gets its workload from. Each request is a JSON object in the
+// input file format ({"prompt": ..., "max_tokens": ...}).
+class RequestSource {
+public:
+    virtual ~RequestSource() = default;
+    virtual std::vector<nlohmann::json> load() = 0;
+};
+
+// Requests read from a JSONL file
+class JsonlRequestSource : public RequestSource {
+public:
+    explicit JsonlRequestSource(std::string filename) : filename_(std::move(filename)) {}
+    std::vector<nlohmann::json> load() override { return load_requests_from_jsonl(filename_); }
+
+private:
+    std::string filename_;
+};
+
+// Requests built in memory, e.g. by an embedding test harness
+class VectorRequestSource : public RequestSource {
+public:
+    explicit VectorRequestSource(std::vector<nlohmann::json> requests)
+        : requests_(std::move(requests)) {}
+    std::vector<nlohmann::json> load() override { return requests_; }
+
+private:
+    std::vector<nlohmann::json> requests_;
+};
+
+}  // namespace bench_core
@@ -0,0 +1,180 @@
+#include "bench_core/rerun.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace bench_core {
+
+PreviousResults load_previous_results(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open results file: " + filename);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string content = buffer.str();
+
+    PreviousResults previous;
+    size_t first = content.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos || content[first] != '{') {
+        throw std::runtime_error("Unsupported results format (expected JSON or NDJSON): " +
+                                 filename);
+    }
+
+    // A single JSON document with a completions array
+    auto document = nlohmann::json::parse(content, nullptr, false);
+    if (!document.is_discarded() && document.contains("completions")) {
+        previous.overall_stats = document.value("overall_stats", nlohmann::json::object());
+        for (auto& completion : document["completions"]) {
+            previous.completions.push_back(std::move(completion));
+        }
+        return previous;
+    }
+
+    // Otherwise NDJSON: completion records, optionally with an overall_stats line
+    std::stringstream lines(content);
+    std::string line;
+    int line_number = 0;
+    while (std::getline(lines, line)) {
+        line_number++;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        auto record = nlohmann::json::parse(line, nullptr, false);
+        if (record.is_discarded()) {
+            throw std::runtime_error("Invalid JSON on line " + std::to_string(line_number) +
+                                     " of " + filename);
+        }
+        if (record.contains("overall_stats")) {
+            previous.overall_stats = record["overall_stats"];
+        } else if (record.contains("input")) {
+            previous.completions.push_back(std::move(record));
+        }
+    }
+    return previous;
+}
+
+std::vector<size_t> select_rerun_indices(const std::vector<nlohmann::json>& completions,
+                                         const std::string& filter) {
+    std::vector<bool> selected(completions.size(), false);
+    std::stringstream stream(filter);
+    std::string term;
+    while (std::getline(stream, term, ',')) {
+        if (term == "failed") {
+            for (size_t i = 0; i < completions.size(); ++i) {
+                selected[i] = selected[i] || !completions[i].value("success", false);
+            }
+        } else if (term == "timed_out") {
+            for (size_t i = 0; i < completions.size(); ++i) {
+                std::string error = completions[i].value("error_message", "");
+                std::transform(error.begin(), error.end(), error.begin(),
+                               [](unsigned char c) { return std::tolower(c); });
+                selected[i] = selected[i] || error.find("timed out") != std::string::npos ||
+                              error.find("timeout") != std::string::npos;
+            }
+        } else if (term.starts_with("slowest:")) {
+            size_t count = 0;
+            const char* first = term.data() + 8;
+            const char* last = term.data() + term.size();
+            auto [end, error] = std::from_chars(first, last, count);
+            if (first == last || error != std::errc() || end != last) {
+                throw std::invalid_argument("Invalid rerun filter: " + term);
+            }
+            std::vector<size_t> order(completions.size());
+            for (size_t i = 0; i < order.size(); ++i) {
+                order[i] = i;
+            }
+            auto duration = [&completions](size_t i) {
+                return completions[i].value("total_duration_seconds", 0.0);
+            };
+            std::stable_sort(order.begin(), order.end(),
+                             [&](size_t a, size_t b) { return duration(a) > duration(b); });
+            for (size_t i = 0; i < std::min(count, order.size()); ++i) {
+                selected[order[i]] = true;
+            }
+        } else if (term.starts_with("tag:")) {
+            std::string tag = term.substr(4);
+            for (size_t i = 0; i < completions.size(); ++i) {
+                const auto& input = completions[i].value("input", nlohmann::json::object());
+                if (!input.is_object()) {
+                    continue;
+                }
+                bool matches = input.contains("tag") && input["tag"].is_string() &&
+                               input["tag"] == tag;
+                if (input.contains("tags") && input["tags"].is_array()) {
+                    for (const auto& item : input["tags"]) {
+                        matches = matches || (item.is_string() && item == tag);
+                    }
+                }
+                selected[i] = selected[i] || matches;
+            }
+        } else if (!term.empty()) {
+            throw std::invalid_argument("Unknown rerun filter: " + term);
+        }
+    }
+
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < selected.size(); ++i) {
+        if (selected[i]) {
+            indices.push_back(i);
+        }
+    }
+    return indices;
+}
+
+nlohmann::json merge_rerun_results(const PreviousResults& previous,
+                                   const std::vector<size_t>& indices, const Stats& rerun_stats,
+                                   const std::string& source, const std::string& filter) {
+    nlohmann::json completions_array = nlohmann::json::array();
+    for (const auto& completion : previous.completions) {
+        completions_array.push_back(completion);
+    }
+
+    size_t number_recovered = 0;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        const auto& completion_stats = rerun_stats.second[i];
+        if (completion_stats.success && !completions_array[indices[i]].value("success", false)) {
+            number_recovered++;
+        }
+        completions_array[indices[i]] = completion_stats.to_json();
+        completions_array[indices[i]]["rerun"] = true;
+    }
+
+    // Rates, durations and summary sections of the previous run do not describe
+    // the merged set, so only the totals are recomputed and the old summary is
+    // kept as original_overall_stats
+    nlohmann::json overall_json = nlohmann::json::object();
+    size_t prompt_tokens = 0;
+    size_t completion_tokens = 0;
+    size_t total_tokens = 0;
+    size_t failures = 0;
+    for (const auto& completion : completions_array) {
+        const auto& usage = completion.value("api_usage", nlohmann::json::object());
+        prompt_tokens += usage.value("prompt_tokens", size_t{0});
+        completion_tokens += usage.value("completion_tokens", size_t{0});
+        total_tokens += usage.value("total_tokens", size_t{0});
+        failures += completion.value("success", false) ? 0 : 1;
+    }
+    overall_json["total_prompt_tokens"] = prompt_tokens;
+    overall_json["total_completion_tokens"] = completion_tokens;
+    overall_json["total_tokens"] = total_tokens;
+    overall_json["total_number_requests"] = completions_array.size();
+    overall_json["total_number_failures"] = failures;
+
+    nlohmann::json output_json;
+    output_json["overall_stats"] = overall_json;
+    output_json["rerun"] = {{"source_file", source},
+                            {"filter", filter},
+                            {"number_rerun", indices.size()},
+                            {"number_recovered", number_recovered},
+                            {"original_overall_stats", previous.overall_stats},
+                            {"rerun_overall_stats", rerun_stats.first.to_json()}};
+    output_json["completions"] = completions_array;
+    return output_json;
+}
+
+}  // namespace bench_core
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// Results of an earlier run, as written by dump_stats_to_file (JSON) or as one
+// completion record per line (NDJSON)
+struct PreviousResults {
+    nlohmann::json overall_stats;
+    std::vector<nlohmann::json> completions;
+};
+
+PreviousResults load_previous_results(const std::string& filename);
+
+// Select the completions to re-issue. The filter is a comma separated union of
+// "failed", "timed_out", "slowest:N" and "tag:NAME" (matching input.tag or
+// an entry of input.tags).
+std::vector<size_t> select_rerun_indices(const std::vector<nlohmann::json>& completions,
+                                         const std::string& filter);
+
+// Overlay re-issued results on the previous ones. overall_stats only holds the
+// token, request and failure totals recomputed over the merged set; the
+// previous and the rerun's own summaries are kept in the rerun section.
+nlohmann::json merge_rerun_results(const PreviousResults& previous,
+                                   const std::vector<size_t>& indices, const Stats& rerun_stats,
+                                   const std::string& source, const std::string& filter);
+
+}  // namespace bench_core
@@ -0,0 +1,147 @@
+#include "bench_core/shm_ring.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace bench_core {
+
+namespace {
+
+static_assert(sizeof(ShmResultRecord) <= ShmRing::kSlotSize - ShmRing::kSlotHeaderSize);
+static_assert(sizeof(ShmSnapshotRecord) <= ShmRing::kSlotSize - ShmRing::kSlotHeaderSize);
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "The ring layout needs lock-free 64-bit atomics");
+
+constexpr char kMagic[8] = {'B', 'N', 'C', 'H', 'R', 'I', 'N', 'G'};
+constexpr size_t kHeadOffset = 64;
+
+ShmSnapshotRecord make_snapshot_record(const MetricsSnapshot& snapshot) {
+    double elapsed = snapshot.elapsed_seconds;
+    return {elapsed,
+            snapshot.requests_total,
+            snapshot.requests_started,
+            snapshot.requests_completed,
+            snapshot.requests_failed,
+            snapshot.prompt_tokens,
+            snapshot.completion_tokens,
+            elapsed > 0 ? snapshot.requests_completed / elapsed : 0.0,
+            elapsed > 0 ? snapshot.completion_tokens / elapsed : 0.0};
+}
+
+}  // namespace
+
+ShmRing::ShmRing(const std::string& name, size_t slot_count)
+    : name_(name.starts_with('/') ? name : "/" + name), slot_count_(slot_count) {
+    if (slot_count_ == 0) {
+        throw std::invalid_argument("Shared-memory ring needs at least one slot");
+    }
+    // Start from a fresh object so consumers never see a previous run's layout
+    shm_unlink(name_.c_str());
+    int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("shm_open(" + name_ + ") failed: " + std::strerror(errno));
+    }
+    mapping_size_ = kHeaderSize + slot_count_ * kSlotSize;
+    if (ftruncate(fd, static_cast<off_t>(mapping_size_)) != 0) {
+        int error = errno;
+        close(fd);
+        throw std::runtime_error("ftruncate(" + name_ + ") failed: " + std::strerror(error));
+    }
+    void* mapping = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("mmap(" + name_ + ") failed: " + std::strerror(errno));
+    }
+    mapping_ = static_cast<char*>(mapping);
+
+    // ftruncate zero-fills, so head and every sequence start at 0
+    uint32_t version = kVersion;
+    auto slot_size = static_cast<uint32_t>(kSlotSize);
+    uint64_t slots = slot_count_;
+    uint64_t pid = static_cast<uint64_t>(getpid());
+    std::memcpy(mapping_ + 8, &version, sizeof(version));
+    std::memcpy(mapping_ + 12, &slot_size, sizeof(slot_size));
+    std::memcpy(mapping_ + 16, &slots, sizeof(slots));
+    std::memcpy(mapping_ + 24, &pid, sizeof(pid));
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(mapping_, kMagic, sizeof(kMagic));
+}
+
+ShmRing::~ShmRing() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mapping_size_);
+    }
+}
+
+std::atomic<uint64_t>& ShmRing::head() const {
+    return *reinterpret_cast<std::atomic<uint64_t>*>(mapping_ + kHeadOffset);
+}
+
+char* ShmRing::slot(uint64_t publication) const {
+    return mapping_ + kHeaderSize + (publication % slot_count_) * kSlotSize;
+}
+
+void ShmRing::publish(ShmRecordType type, const void* payload, uint32_t size) {
+    if (size > kSlotSize - kSlotHeaderSize) {
+        throw std::invalid_argument("Shared-memory ring payload too large");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t publication = head().load(std::memory_order_relaxed);
+    char* target = slot(publication);
+    auto& sequence = *reinterpret_cast<std::atomic<uint64_t>*>(target);
+
+    // Seqlock write: odd while the payload is inconsistent
+    sequence.store(2 * publication + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    auto type_value = static_cast<uint32_t>(type);
+    std::memcpy(target + 8, &type_value, sizeof(type_value));
+    std::memcpy(target + 12, &size, sizeof(size));
+    std::memcpy(target + kSlotHeaderSize, payload, size);
+    sequence.store(2 * publication + 2, std::memory_order_release);
+    head().store(publication + 1, std::memory_order_release);
+}
+
+void ShmRingSink::on_result(size_t index, const CompletionStats& stats) {
+    ShmResultRecord record{};
+    record.index = index;
+    record.dispatch_position = stats.dispatch_position;
+    record.start_time = stats.get_start_time().value_or(-1.0);
+    record.ttft_seconds = stats.get_ttft_duration().value_or(-1.0);
+    record.total_duration_seconds = stats.get_total_duration().value_or(-1.0);
+    record.rate_limit_wait_seconds = stats.rate_limit_wait_seconds;
+    record.prompt_tokens = stats.api_usage.prompt_tokens;
+    record.completion_tokens = stats.api_usage.completion_tokens;
+    record.number_of_choices = static_cast<uint32_t>(stats.choices.size());
+    record.number_of_chunks = static_cast<uint32_t>(stats.number_of_chunks);
+    record.success = stats.success ? 1 : 0;
+    record.aborted = stats.aborted ? 1 : 0;
+    record.slow_reader = stats.slow_reader ? 1 : 0;
+    record.new_connection = stats.new_connection ? 1 : 0;
+    ring_.publish(ShmRecordType::kResult, &record, sizeof(record));
+}
+
+void ShmRingSink::on_finish(const Stats& stats) {
+    const auto& overall = stats.first;
+    MetricsSnapshot snapshot;
+    snapshot.elapsed_seconds = overall.get_total_duration().value_or(0.0);
+    snapshot.requests_total = overall.total_number_requests;
+    snapshot.requests_started = overall.total_number_requests;
+    snapshot.requests_completed = overall.total_number_requests;
+    snapshot.requests_failed = overall.total_number_failures;
+    snapshot.prompt_tokens = overall.total_prompt_tokens;
+    snapshot.completion_tokens = overall.total_completion_tokens;
+    auto record = make_snapshot_record(snapshot);
+    ring_.publish(ShmRecordType::kFinalSnapshot, &record, sizeof(record));
+}
+
+void ShmRingSink::publish_snapshot(const MetricsSnapshot& snapshot) {
+    auto record = make_snapshot_record(snapshot);
+    ring_.publish(ShmRecordType::kSnapshot, &record, sizeof(record));
+}
+
+}  // namespace bench_core
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "bench_core/engine.h"
+#include "bench_core/sink.h"
+
+namespace bench_core {
+
+// Live results in a POSIX shared-memory ring, for local consumers that tail a
+// run without parsing files. Layout (version 1, little-endian, native types):
+//
+//   offset 0    char[8]  magic "BNCHRING", written last
+//          8    uint32   version
+//          12   uint32   slot_size in bytes
+//          16   uint64   slot_count
+//          24   uint64   producer pid
+//          64   uint64   head: number of publications so far (atomic)
+//   offset 128  slot_count slots of slot_size bytes; publication n is in slot
+//               n % slot_count:
+//          0    uint64   sequence (atomic): 2n+1 while being written, 2n+2 once
+//                        complete
+//          8    uint32   type, a ShmRecordType
+//          12   uint32   payload size in bytes
+//          16   payload  ShmResultRecord or ShmSnapshotRecord
+//
+// There is one producer. A consumer loads head (acquire), and for each n it
+// has not seen yet loads the slot's sequence (acquire), copies the payload,
+// issues an acquire fence and reloads the sequence. The copy is valid if both
+// loads returned 2n+2; a larger value means the producer lapped the consumer.
+// The producer never waits for consumers.
+enum class ShmRecordType : uint32_t { kResult = 1, kSnapshot = 2, kFinalSnapshot = 3 };
+
+// One finished request. Durations are -1 when not recorded.
+struct ShmResultRecord {
+    uint64_t index;
+    uint64_t dispatch_position;
+    double start_time;  // Same clock as start_time in the JSON report
+    double ttft_seconds;
+    double total_duration_seconds;
+    double rate_limit_wait_seconds;
+    uint64_t prompt_tokens;
+    uint64_t completion_tokens;
+    uint32_t number_of_choices;
+    uint32_t number_of_chunks;
+    uint8_t success;
+    uint8_t aborted;
+    uint8_t slow_reader;
+    uint8_t new_connection;
+    uint32_t reserved;
+};
+
+// Engine counters at a point in time
+struct ShmSnapshotRecord {
+    double elapsed_seconds;
+    uint64_t requests_total;
+    uint64_t requests_started;
+    uint64_t requests_completed;
+    uint64_t requests_failed;
+    uint64_t prompt_tokens;
+    uint64_t completion_tokens;
+    double requests_per_second;
+    double completion_tokens_per_second;
+};
+
+// Producer side of the ring. Creates (or recreates) the shared-memory object;
+// it is left in place on exit so consumers can read the end of the run.
+class ShmRing {
+public:
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kHeaderSize = 128;
+    static constexpr size_t kSlotSize = 128;
+    static constexpr size_t kSlotHeaderSize = 16;
+
+    // name is a POSIX shared-memory name; a leading '/' is added if missing.
+    // Throws std::runtime_error if the object cannot be created.
+    ShmRing(const std::string& name, size_t slot_count);
+    ~ShmRing();
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    // Thread-safe; concurrent callers are serialized into the single producer
+    void publish(ShmRecordType type, const void* payload, uint32_t size);
+
+    const std::string& name() const { return name_; }
+
+private:
+    std::atomic<uint64_t>& head() const;
+    char* slot(uint64_t publication) const;
+
+    std::string name_;
+    size_t slot_count_;
+    size_t mapping_size_ = 0;
+    char* mapping_ = nullptr;
+    std::mutex mutex_;
+};
+
+// Publishes every result, plus engine snapshots on request and a final
+// snapshot when the run ends
+class ShmRingSink : public ResultsSink {
+public:
+    ShmRingSink(const std::string& name, size_t slot_count) : ring_(name, slot_count) {}
+
+    void on_result(size_t index, const CompletionStats& stats) override;
+    void on_finish(const Stats& stats) override;
+
+    void publish_snapshot(const MetricsSnapshot& snapshot);
+
+private:
+    ShmRing ring_;
+};
+
+}  // namespace bench_core
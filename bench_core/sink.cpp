@@ -0,0 +1,38 @@
+#include "bench_core/sink.h"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace bench_core {
+
+void write_json_to_file(const nlohmann::json& output_json, const std::string& filename) {
+    std::ofstream output_file(filename);
+    if (output_file.is_open()) {
+        output_file << output_json.dump(4);
+        output_file.close();
+        std::cout << "[INFO] Statistics written to " + filename << '\n';
+    } else {
+        std::cerr << "[ERROR] Failed to open output file: " + filename << '\n';
+    }
+}
+
+void dump_stats_to_file(const Stats& stats, const std::string& filename) {
+    write_json_to_file(stats_to_json(stats), filename);
+}
+
+NdjsonFileSink::NdjsonFileSink(const std::string& filename) : file_(filename) {
+    if (!file_.is_open()) {
+        throw std::runtime_error("Failed to open output file: " + filename);
+    }
+}
+
+void NdjsonFileSink::on_result(size_t index, const CompletionStats& stats) {
+    nlohmann::json record = stats.to_json();
+    record["index"] = index;
+    std::string line = record.dump();
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_ << line << '\n';
+}
+
+}  // namespace bench_core
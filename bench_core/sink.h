@@ -0,0 +1,48 @@
+#pragma once
+
+#include <fstream>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// Receives results from an Engine. on_result is called from worker threads as
+// each request finishes, so implementations must be thread-safe; on_finish is
+// called once with the aggregated results after all workers have stopped.
+class ResultsSink {
+public:
+    virtual ~ResultsSink() = default;
+    virtual void on_result(size_t /*index*/, const CompletionStats& /*stats*/) {}
+    virtual void on_finish(const Stats& /*stats*/) {}
+};
+
+void write_json_to_file(const nlohmann::json& output_json, const std::string& filename);
+
+void dump_stats_to_file(const Stats& stats, const std::string& filename);
+
+// Writes the full report (overall_stats and completions) at the end of a run
+class JsonFileSink : public ResultsSink {
+public:
+    explicit JsonFileSink(std::string filename) : filename_(std::move(filename)) {}
+    void on_finish(const Stats& stats) override { dump_stats_to_file(stats, filename_); }
+
+private:
+    std::string filename_;
+};
+
+// Appends one compact JSON line per finished request, so huge runs can be
+// tailed or post-processed without holding the whole report
+class NdjsonFileSink : public ResultsSink {
+public:
+    explicit NdjsonFileSink(const std::string& filename);
+    void on_result(size_t index, const CompletionStats& stats) override;
+
+private:
+    std::mutex mutex_;
+    std::ofstream file_;
+};
+
+}  // namespace bench_core
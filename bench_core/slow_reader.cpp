@@ -0,0 +1,100 @@
+#include "bench_core/slow_reader.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+
+namespace bench_core {
+
+namespace {
+
+using TimePoint = std::chrono::steady_clock::time_point;
+
+nlohmann::json summarize_group(const std::vector<const CompletionStats*>& group) {
+    std::vector<double> lags;
+    std::vector<double> queue_times;
+    std::vector<double> completion_times;
+    for (const auto* completion_stats : group) {
+        auto lag = completion_stats->get_delivery_lag();
+        if (lag.has_value()) {
+            lags.push_back(lag.value());
+        }
+        queue_times.push_back(completion_stats->api_time_info.queue_time);
+        completion_times.push_back(completion_stats->api_time_info.completion_time);
+    }
+    return {{"number_requests", group.size()},
+            {"delivery_lag_p50_seconds", percentile(lags, 50)},
+            {"delivery_lag_p99_seconds", percentile(lags, 99)},
+            {"server_queue_time_p50_seconds", percentile(queue_times, 50)},
+            {"server_completion_time_p50_seconds", percentile(completion_times, 50)},
+            {"server_completion_time_p99_seconds", percentile(completion_times, 99)}};
+}
+
+}  // namespace
+
+bool select_slow_reader(const SlowReaderConfig& config, size_t index, unsigned int seed) {
+    if (!config.enabled()) {
+        return false;
+    }
+    // Different stream than the abort selection, so the two sets are independent
+    std::mt19937_64 rng((seed + 0x51u) ^ (static_cast<uint64_t>(index) * 0xBF58476D1CE4E5B9ULL));
+    return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < config.fraction;
+}
+
+nlohmann::json summarize_slow_readers(const std::vector<CompletionStats>& all_completion_stats) {
+    std::vector<const CompletionStats*> slow;
+    std::vector<const CompletionStats*> normal;
+    std::vector<std::pair<TimePoint, TimePoint>> slow_intervals;
+    for (const auto& completion_stats : all_completion_stats) {
+        if (!completion_stats.success) {
+            continue;
+        }
+        if (completion_stats.slow_reader) {
+            slow.push_back(&completion_stats);
+            slow_intervals.emplace_back(completion_stats.start_time, completion_stats.end_time);
+        } else {
+            normal.push_back(&completion_stats);
+        }
+    }
+
+    // Merge into disjoint intervals so membership is a binary search
+    std::sort(slow_intervals.begin(), slow_intervals.end());
+    std::vector<std::pair<TimePoint, TimePoint>> merged;
+    for (const auto& interval : slow_intervals) {
+        if (!merged.empty() && interval.first <= merged.back().second) {
+            merged.back().second = std::max(merged.back().second, interval.second);
+        } else {
+            merged.push_back(interval);
+        }
+    }
+    auto slow_reader_active = [&merged](TimePoint time) {
+        auto it = std::upper_bound(
+            merged.begin(), merged.end(), time,
+            [](TimePoint value, const auto& interval) { return value < interval.first; });
+        return it != merged.begin() && time <= std::prev(it)->second;
+    };
+
+    std::vector<double> itl_with_slow;
+    std::vector<double> itl_without_slow;
+    for (const auto* completion_stats : normal) {
+        for (const auto& choice_stats : completion_stats->choices) {
+            const auto& times = choice_stats.chunk_times;
+            for (size_t i = 1; i < times.size(); ++i) {
+                double itl = seconds_between(times[i - 1], times[i]).value_or(0.0);
+                (slow_reader_active(times[i]) ? itl_with_slow : itl_without_slow).push_back(itl);
+            }
+        }
+    }
+
+    return {{"slow", summarize_group(slow)},
+            {"normal", summarize_group(normal)},
+            {"normal_itl",
+             {{"with_slow_readers_samples", itl_with_slow.size()},
+              {"with_slow_readers_p50_seconds", percentile(itl_with_slow, 50)},
+              {"with_slow_readers_p99_seconds", percentile(itl_with_slow, 99)},
+              {"without_slow_readers_samples", itl_without_slow.size()},
+              {"without_slow_readers_p50_seconds", percentile(itl_without_slow, 50)},
+              {"without_slow_readers_p99_seconds", percentile(itl_without_slow, 99)}}}};
+}
+
+}  // namespace bench_core
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "bench_core/http_client.h"
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// Slow-reader simulation: a fraction of streams is consumed slowly, like a
+// mobile client on a congested link, so the server has to buffer or block on
+// them. Needs the curl transport, which applies the HTTP options.
+struct SlowReaderConfig {
+    double fraction = 0.0;
+    // Read throttling applied to the selected streams
+    HttpOptions http;
+
+    bool enabled() const { return fraction > 0; }
+};
+
+// Whether request `index` is read slowly; deterministic for a given seed
+bool select_slow_reader(const SlowReaderConfig& config, size_t index, unsigned int seed);
+
+// Delivery lag (client-side decode time minus the server's completion_time)
+// and server time_info for slow and normal streams, plus the normal streams'
+// ITL split by whether a slow reader was in flight when the chunk arrived
+nlohmann::json summarize_slow_readers(const std::vector<CompletionStats>& all_completion_stats);
+
+}  // namespace bench_core
@@ -0,0 +1,157 @@
+#include "bench_core/socket_options.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+namespace {
+
+std::mutex effective_mutex;
+nlohmann::json effective_options;
+
+// Set an integer option and record what the kernel reports back
+void set_int_option(int socket, int level, int name, int value, const char* label,
+                    nlohmann::json& effective) {
+    if (setsockopt(socket, level, name, &value, sizeof(value)) != 0) {
+        effective[label] = {{"error", std::strerror(errno)}};
+        return;
+    }
+    int actual = 0;
+    socklen_t length = sizeof(actual);
+    if (getsockopt(socket, level, name, &actual, &length) == 0) {
+        effective[label] = actual;
+    }
+}
+
+}  // namespace
+
+nlohmann::json SocketOptions::to_json() const {
+    nlohmann::json options_json = nlohmann::json::object();
+    if (tcp_nodelay.has_value()) {
+        options_json["tcp_nodelay"] = tcp_nodelay.value();
+    }
+    if (tcp_quickack) {
+        options_json["tcp_quickack"] = true;
+    }
+    if (receive_buffer_bytes > 0) {
+        options_json["so_rcvbuf"] = receive_buffer_bytes;
+    }
+    if (send_buffer_bytes > 0) {
+        options_json["so_sndbuf"] = send_buffer_bytes;
+    }
+    if (busy_poll_us > 0) {
+        options_json["so_busy_poll_us"] = busy_poll_us;
+    }
+    if (!congestion_control.empty()) {
+        options_json["tcp_congestion"] = congestion_control;
+    }
+    return options_json;
+}
+
+void apply_socket_options(int socket, const SocketOptions& options) {
+    nlohmann::json effective = nlohmann::json::object();
+    if (options.tcp_nodelay.has_value()) {
+        set_int_option(socket, IPPROTO_TCP, TCP_NODELAY, options.tcp_nodelay.value() ? 1 : 0,
+                       "tcp_nodelay", effective);
+    }
+#ifdef TCP_QUICKACK
+    if (options.tcp_quickack) {
+        set_int_option(socket, IPPROTO_TCP, TCP_QUICKACK, 1, "tcp_quickack", effective);
+    }
+#endif
+    // The kernel doubles buffer sizes for bookkeeping, so the effective values differ
+    if (options.receive_buffer_bytes > 0) {
+        set_int_option(socket, SOL_SOCKET, SO_RCVBUF,
+                       static_cast<int>(options.receive_buffer_bytes), "so_rcvbuf", effective);
+    }
+    if (options.send_buffer_bytes > 0) {
+        set_int_option(socket, SOL_SOCKET, SO_SNDBUF, static_cast<int>(options.send_buffer_bytes),
+                       "so_sndbuf", effective);
+    }
+#ifdef SO_BUSY_POLL
+    if (options.busy_poll_us > 0) {
+        set_int_option(socket, SOL_SOCKET, SO_BUSY_POLL, options.busy_poll_us, "so_busy_poll_us",
+                       effective);
+    }
+#endif
+#ifdef TCP_CONGESTION
+    if (!options.congestion_control.empty()) {
+        const auto& name = options.congestion_control;
+        if (setsockopt(socket, IPPROTO_TCP, TCP_CONGESTION, name.data(),
+                       static_cast<socklen_t>(name.size())) != 0) {
+            effective["tcp_congestion"] = {{"error", std::strerror(errno)}};
+        } else {
+            char actual[64] = {};
+            socklen_t length = sizeof(actual);
+            if (getsockopt(socket, IPPROTO_TCP, TCP_CONGESTION, actual, &length) == 0) {
+                effective["tcp_congestion"] = std::string(actual, strnlen(actual, length));
+            }
+        }
+    }
+#endif
+
+    std::lock_guard<std::mutex> lock(effective_mutex);
+    effective_options = std::move(effective);
+}
+
+void rearm_quickack(int socket) {
+#ifdef TCP_QUICKACK
+    int enable = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_QUICKACK, &enable, sizeof(enable));
+#else
+    (void)socket;
+#endif
+}
+
+std::optional<TcpInfo> read_tcp_info(int socket) {
+#ifdef TCP_INFO
+    tcp_info info{};
+    socklen_t length = sizeof(info);
+    if (getsockopt(socket, IPPROTO_TCP, TCP_INFO, &info, &length) != 0) {
+        return std::nullopt;
+    }
+    TcpInfo tcp;
+    tcp.rtt_us = info.tcpi_rtt;
+    tcp.rttvar_us = info.tcpi_rttvar;
+    tcp.ato_us = info.tcpi_ato;
+    tcp.snd_cwnd = info.tcpi_snd_cwnd;
+    tcp.total_retransmits = info.tcpi_total_retrans;
+    return tcp;
+#else
+    (void)socket;
+    return std::nullopt;
+#endif
+}
+
+nlohmann::json effective_socket_options() {
+    std::lock_guard<std::mutex> lock(effective_mutex);
+    return effective_options;
+}
+
+nlohmann::json summarize_tcp_info(const std::vector<TcpInfo>& samples) {
+    std::vector<double> rtts;
+    std::vector<double> atos;
+    // Retransmits are cumulative per connection, so only the maximum is meaningful
+    uint32_t retransmits = 0;
+    for (const auto& sample : samples) {
+        rtts.push_back(sample.rtt_us);
+        atos.push_back(sample.ato_us);
+        retransmits = std::max(retransmits, sample.total_retransmits);
+    }
+    return {{"samples", samples.size()},
+            {"rtt_p50_us", percentile(rtts, 50)},
+            {"rtt_p99_us", percentile(rtts, 99)},
+            {"ato_p50_us", percentile(atos, 50)},
+            {"max_connection_retransmits", retransmits}};
+}
+
+}  // namespace bench_core
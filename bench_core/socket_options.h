@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace bench_core {
+
+// Socket tuning for the curl transport's connections. Small-chunk SSE streams
+// are sensitive to Nagle and delayed-ACK interactions, so these are exposed
+// to measure the client-side share of per-token latency.
+struct SocketOptions {
+    std::optional<bool> tcp_nodelay;
+    // Linux clears TCP_QUICKACK after use, so it is re-armed on every read
+    bool tcp_quickack = false;
+    size_t receive_buffer_bytes = 0;  // SO_RCVBUF, 0 = system default
+    size_t send_buffer_bytes = 0;     // SO_SNDBUF, 0 = system default
+    int busy_poll_us = 0;             // SO_BUSY_POLL, 0 = off
+    std::string congestion_control;   // TCP_CONGESTION, empty = system default
+
+    bool configured() const {
+        return tcp_nodelay.has_value() || tcp_quickack || receive_buffer_bytes > 0 ||
+               send_buffer_bytes > 0 || busy_poll_us > 0 || !congestion_control.empty();
+    }
+
+    nlohmann::json to_json() const;
+};
+
+// Kernel view of a connection at the end of a request (Linux TCP_INFO)
+struct TcpInfo {
+    uint32_t rtt_us = 0;
+    uint32_t rttvar_us = 0;
+    uint32_t ato_us = 0;  // Delayed-ACK timeout
+    uint32_t snd_cwnd = 0;
+    uint32_t total_retransmits = 0;
+
+    nlohmann::json to_json() const {
+        return {{"rtt_us", rtt_us},
+                {"rttvar_us", rttvar_us},
+                {"ato_us", ato_us},
+                {"snd_cwnd", snd_cwnd},
+                {"total_retransmits", total_retransmits}};
+    }
+};
+
+// Apply options to a freshly created socket. Values are read back and kept as
+// the effective settings, with the error for any option the kernel refused.
+void apply_socket_options(int socket, const SocketOptions& options);
+
+// Re-arm TCP_QUICKACK after a read
+void rearm_quickack(int socket);
+
+// TCP_INFO of a connected socket, where supported
+std::optional<TcpInfo> read_tcp_info(int socket);
+
+// Effective settings of the most recently configured socket, null if none
+nlohmann::json effective_socket_options();
+
+// Percentiles of the per-request TCP_INFO samples
+nlohmann::json summarize_tcp_info(const std::vector<TcpInfo>& samples);
+
+}  // namespace bench_core
@@ -0,0 +1,110 @@
+#include "bench_core/stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace bench_core {
+
+TextPolicy parse_text_policy(const std::string& value) {
+    if (value == "full") {
+        return TextPolicy::kFull;
+    }
+    if (value == "hash") {
+        return TextPolicy::kHash;
+    }
+    if (value == "none") {
+        return TextPolicy::kNone;
+    }
+    throw std::invalid_argument("Unknown output_text_policy: " + value);
+}
+
+std::optional<double> seconds_between(std::chrono::steady_clock::time_point from,
+                                      std::chrono::steady_clock::time_point to) {
+    if (to.time_since_epoch().count() > 0 && from.time_since_epoch().count() > 0) {
+        return std::chrono::duration_cast<std::chrono::duration<double>>(to - from).count();
+    }
+    return std::nullopt;
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    double rank = (p / 100.0) * static_cast<double>(values.size() - 1);
+    auto lower = static_cast<size_t>(std::floor(rank));
+    auto upper = static_cast<size_t>(std::ceil(rank));
+    double fraction = rank - static_cast<double>(lower);
+    return values[lower] + (values[upper] - values[lower]) * fraction;
+}
+
+nlohmann::json json_validation_to_json(const JsonStreamValidator& validator) {
+    nlohmann::json validation_json = {{"valid", validator.valid()},
+                                      {"complete", validator.complete()},
+                                      {"bytes", validator.bytes()},
+                                      {"max_depth", validator.max_depth()}};
+    if (!validator.valid()) {
+        validation_json["error_offset"] = validator.error_offset();
+    }
+    return validation_json;
+}
+
+OverallStats aggregate_stats(const std::vector<CompletionStats>& all_completion_stats) {
+    OverallStats stats;
+    stats.total_number_requests = all_completion_stats.size();
+
+    for (const auto& completion_stats : all_completion_stats) {
+        stats.total_prompt_tokens += completion_stats.api_usage.prompt_tokens;
+        stats.total_completion_tokens += completion_stats.api_usage.completion_tokens;
+        stats.total_tokens += completion_stats.api_usage.total_tokens;
+        stats.total_number_choices += completion_stats.choices.size();
+        stats.total_rate_limit_wait_seconds += completion_stats.rate_limit_wait_seconds;
+        if (!completion_stats.success) {
+            stats.total_number_failures++;
+        }
+        for (const auto& header : completion_stats.response_headers) {
+            if (header.is_numeric) {
+                stats.header_series[header_name(header.name_id)].points.emplace_back(
+                    completion_stats.headers_time, header.number);
+            }
+        }
+
+        if (completion_stats.embedding.has_value()) {
+            auto& batch_stats = stats.by_batch_size[completion_stats.embedding->batch_size];
+            if (batch_stats.number_requests == 0 ||
+                completion_stats.start_time < batch_stats.start_time) {
+                batch_stats.start_time = completion_stats.start_time;
+            }
+            batch_stats.end_time = std::max(batch_stats.end_time, completion_stats.end_time);
+            batch_stats.number_requests++;
+            batch_stats.number_inputs += completion_stats.embedding->number_of_inputs;
+            batch_stats.tokens += completion_stats.api_usage.total_tokens;
+            stats.total_number_inputs += completion_stats.embedding->number_of_inputs;
+            if (completion_stats.success) {
+                batch_stats.latencies.push_back(completion_stats.get_total_duration().value_or(0));
+            } else {
+                batch_stats.number_failures++;
+            }
+        }
+    }
+    return stats;
+}
+
+nlohmann::json stats_to_json(const Stats& stats) {
+    nlohmann::json output_json;
+
+    // Add overall stats using the to_json method
+    output_json["overall_stats"] = stats.first.to_json();
+
+    // Add individual completion stats using the to_json method
+    nlohmann::json completions_array = nlohmann::json::array();
+    for (const auto& completion_stats : stats.second) {
+        completions_array.push_back(completion_stats.to_json());
+    }
+
+    output_json["completions"] = completions_array;
+    return output_json;
+}
+
+}  // namespace bench_core
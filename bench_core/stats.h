@@ -0,0 +1,841 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "bench_core/headers.h"
+#include "bench_core/socket_options.h"
+#include "bench_core/text_decoding.h"
+#include "bench_core/wire_bytes.h"
+
+namespace bench_core {
+
+// How generated text is retained per choice. Keeping every output in memory is
+// expensive for large runs and n > 1, so it can be reduced to a hash or dropped.
+enum class TextPolicy { kFull, kHash, kNone };
+
+// Parse "full", "hash" or "none"; throws std::invalid_argument otherwise
+TextPolicy parse_text_policy(const std::string& value);
+
+// Convert a steady_clock interval to seconds, if both ends have been recorded
+std::optional<double> seconds_between(std::chrono::steady_clock::time_point from,
+                                      std::chrono::steady_clock::time_point to);
+
+// Percentile with linear interpolation between closest ranks (numpy's default)
+double percentile(std::vector<double> values, double p);
+
+// Validity, completeness and size of text checked as JSON while streaming
+nlohmann::json json_validation_to_json(const JsonStreamValidator& validator);
+
+// One tool call of a chat response, reassembled from its streamed deltas. The
+// argument fragments are decoded and validated as they arrive; the text itself
+// is only kept under the full text policy.
+struct ToolCallStats {
+    size_t index = 0;
+    std::string id;
+    std::string name;
+    std::string arguments;
+    size_t arguments_length = 0;
+    size_t number_of_deltas = 0;
+    JsonStringDecoder decoder;
+    JsonStreamValidator validator;
+
+    void append_arguments(std::string_view text, TextPolicy policy) {
+        arguments_length += text.size();
+        validator.feed(text);
+        if (policy == TextPolicy::kFull) {
+            arguments += text;
+        }
+    }
+
+    void append_arguments_escaped(std::string_view escaped, TextPolicy policy) {
+        thread_local std::string scratch;
+        scratch.clear();
+        decoder.decode(escaped, scratch);
+        append_arguments(scratch, policy);
+    }
+
+    void finish(TextPolicy policy) {
+        std::string tail;
+        decoder.finish(tail);
+        append_arguments(tail, policy);
+        validator.finish();
+    }
+
+    nlohmann::json to_json(TextPolicy policy) const {
+        nlohmann::json tool_call_json = {{"index", index},
+                                         {"id", id},
+                                         {"name", name},
+                                         {"arguments_length", arguments_length},
+                                         {"number_of_deltas", number_of_deltas},
+                                         {"arguments_json", json_validation_to_json(validator)}};
+        if (policy == TextPolicy::kFull) {
+            tool_call_json["arguments"] = arguments;
+        }
+        return tool_call_json;
+    }
+};
+
+// Per-choice stream state for requests with n > 1 (or best_of). Chunks are
+// demultiplexed by choices[i].index so every sampled sequence is tracked.
+struct ChoiceStats {
+    static constexpr uint64_t kFnvOffsetBasis = 1469598103934665603ULL;
+    static constexpr uint64_t kFnvPrime = 1099511628211ULL;
+
+    size_t index = 0;
+    std::chrono::steady_clock::time_point ttft_time;
+    std::chrono::steady_clock::time_point end_time;
+    size_t number_of_chunks = 0;
+    std::string output_text;
+    size_t output_length = 0;
+    uint64_t output_hash = kFnvOffsetBasis;
+    std::string finish_reason;
+    JsonStringDecoder decoder;
+    // Arrival time of every content chunk, for inter-token latency analysis
+    std::vector<std::chrono::steady_clock::time_point> chunk_times;
+    // Decoded bytes (text and tool-call arguments) of every content chunk, only
+    // recorded for chunk granularity analytics
+    std::vector<uint32_t> chunk_bytes;
+    // Tool calls of a chat response, by tool call index
+    std::vector<ToolCallStats> tool_calls;
+    // Set when the request asks for a JSON response_format; checks the output
+    // text as it streams
+    std::optional<JsonStreamValidator> json_validator;
+
+    // Find the state of a tool call index, creating it on first sight
+    ToolCallStats& tool_call(size_t tool_index) {
+        for (auto& tool_call_stats : tool_calls) {
+            if (tool_call_stats.index == tool_index) {
+                return tool_call_stats;
+            }
+        }
+        tool_calls.emplace_back().index = tool_index;
+        return tool_calls.back();
+    }
+
+    // Account for a piece of generated text according to the text policy
+    void append_text(std::string_view text, TextPolicy policy) {
+        output_length += text.size();
+        if (json_validator.has_value()) {
+            json_validator->feed(text);
+        }
+        if (policy == TextPolicy::kFull) {
+            output_text += text;
+        } else if (policy == TextPolicy::kHash) {
+            for (unsigned char c : text) {
+                output_hash = (output_hash ^ c) * kFnvPrime;
+            }
+        }
+    }
+
+    // Decode still-escaped JSON string contents directly into the output text,
+    // or through a reusable scratch buffer into the hash / length sink
+    void append_escaped(std::string_view escaped, TextPolicy policy) {
+        if (policy == TextPolicy::kFull) {
+            size_t before = output_text.size();
+            decoder.decode(escaped, output_text);
+            output_length += output_text.size() - before;
+            if (json_validator.has_value()) {
+                json_validator->feed(std::string_view(output_text).substr(before));
+            }
+            return;
+        }
+        thread_local std::string scratch;
+        scratch.clear();
+        decoder.decode(escaped, scratch);
+        append_text(scratch, policy);
+    }
+
+    // Flush sequences left incomplete at the end of the stream
+    void finish_text(TextPolicy policy) {
+        std::string tail;
+        decoder.finish(tail);
+        append_text(tail, policy);
+        if (json_validator.has_value()) {
+            json_validator->finish();
+        }
+        for (auto& tool_call_stats : tool_calls) {
+            tool_call_stats.finish(policy);
+        }
+    }
+
+    // JSON validation of the output and the reassembled tool calls, if any
+    void structured_to_json(nlohmann::json& out, TextPolicy policy) const {
+        if (json_validator.has_value()) {
+            out["json_output"] = json_validation_to_json(json_validator.value());
+        }
+        if (!tool_calls.empty()) {
+            nlohmann::json tool_calls_json = nlohmann::json::array();
+            for (const auto& tool_call_stats : tool_calls) {
+                tool_calls_json.push_back(tool_call_stats.to_json(policy));
+            }
+            out["tool_calls"] = tool_calls_json;
+        }
+    }
+
+    nlohmann::json to_json(std::chrono::steady_clock::time_point request_start,
+                           TextPolicy policy, double estimated_completion_tokens) const {
+        nlohmann::json choice_json;
+        choice_json["index"] = index;
+        if (policy == TextPolicy::kFull) {
+            choice_json["output_text"] = output_text;
+        } else if (policy == TextPolicy::kHash) {
+            std::ostringstream hash;
+            hash << std::hex << output_hash;
+            choice_json["output_hash"] = hash.str();
+        }
+        choice_json["output_length"] = output_length;
+        choice_json["finish_reason"] = finish_reason;
+        choice_json["number_of_chunks"] = number_of_chunks;
+        choice_json["invalid_utf8_sequences"] = decoder.invalid_sequences();
+        choice_json["estimated_completion_tokens"] = estimated_completion_tokens;
+        structured_to_json(choice_json, policy);
+
+        auto ttft_duration = seconds_between(request_start, ttft_time);
+        if (ttft_duration.has_value()) {
+            choice_json["ttft_duration_seconds"] = ttft_duration.value();
+        }
+
+        auto total_duration = seconds_between(request_start, end_time);
+        if (total_duration.has_value()) {
+            choice_json["total_duration_seconds"] = total_duration.value();
+            if (total_duration.value() > 0) {
+                choice_json["completion_tokens_per_second"] =
+                    estimated_completion_tokens / total_duration.value();
+            }
+        }
+        return choice_json;
+    }
+};
+
+struct CompletionStats {
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point ttft_time;
+    std::chrono::steady_clock::time_point end_time;
+    size_t number_of_chunks = 0;
+    nlohmann::json input;
+    TextPolicy text_policy = TextPolicy::kFull;
+    // Keep per-chunk byte counts; only chunk granularity analytics reads them
+    bool record_chunk_bytes = false;
+    std::vector<ChoiceStats> choices;
+    bool success = true;
+    std::string error_message;
+    // Time spent waiting on the client-side rate limiter before start_time
+    double rate_limit_wait_seconds = 0.0;
+    // Cancelled mid-stream by the client-abort simulation; not a failure
+    bool aborted = false;
+    // Consumed slowly by the slow-reader simulation
+    bool slow_reader = false;
+    // Position in the dispatch order chosen by the ordering policy
+    size_t dispatch_position = 0;
+    // Engine worker that ran the request; each worker keeps its own connection
+    size_t worker_id = 0;
+    // Response headers selected by the header capture patterns
+    std::vector<CapturedHeader> response_headers;
+    std::chrono::steady_clock::time_point headers_time;
+    // Whether the transfer opened a new connection, and its TCP_INFO afterwards
+    bool new_connection = false;
+    std::optional<TcpInfo> tcp_info;
+    // Peer address of the connection, curl transport only
+    std::string remote_address;
+    // Validate every choice's output as JSON (response_format json_object or
+    // json_schema)
+    bool validate_json_output = false;
+    // SSE events received, the transport deliveries (HTTP chunks or DATA
+    // frames) that completed at least one, and those that completed several
+    size_t sse_events = 0;
+    size_t stream_reads = 0;
+    size_t coalesced_reads = 0;
+    // Chunk granularity analytics, null when disabled
+    nlohmann::json chunk_granularity;
+    // Bytes on the wire in each direction, curl transport only
+    WireBytes wire;
+
+    // Find the stats for a choice index, creating them on first sight
+    ChoiceStats& choice(size_t index) {
+        for (auto& choice_stats : choices) {
+            if (choice_stats.index == index) {
+                return choice_stats;
+            }
+        }
+        auto& choice_stats = choices.emplace_back();
+        choice_stats.index = index;
+        if (validate_json_output) {
+            choice_stats.json_validator.emplace();
+        }
+        return choice_stats;
+    }
+
+    // Count a content chunk for a choice, tracking per-choice and request TTFT
+    ChoiceStats& record_choice_chunk(size_t index) {
+        auto now = std::chrono::steady_clock::now();
+        auto& choice_stats = choice(index);
+        if (choice_stats.number_of_chunks == 0) {
+            choice_stats.ttft_time = now;
+        }
+        if (ttft_time.time_since_epoch().count() == 0) {
+            ttft_time = now;
+        }
+        choice_stats.number_of_chunks++;
+        choice_stats.chunk_times.push_back(now);
+        if (record_chunk_bytes) {
+            choice_stats.chunk_bytes.push_back(0);
+        }
+        return choice_stats;
+    }
+
+    // Add decoded bytes to the chunk just recorded for a choice
+    void add_chunk_bytes(ChoiceStats& choice_stats, size_t bytes) {
+        if (record_chunk_bytes) {
+            choice_stats.chunk_bytes.back() += static_cast<uint32_t>(bytes);
+        }
+    }
+
+    // Record already decoded text for a choice
+    void add_choice_text(size_t index, std::string_view text) {
+        if (!text.empty()) {
+            auto& choice_stats = record_choice_chunk(index);
+            choice_stats.append_text(text, text_policy);
+            add_chunk_bytes(choice_stats, text.size());
+        }
+    }
+
+    // Record still-escaped text taken straight from the raw chunk
+    void add_choice_escaped(size_t index, std::string_view escaped) {
+        if (!escaped.empty()) {
+            auto& choice_stats = record_choice_chunk(index);
+            size_t before = choice_stats.output_length;
+            choice_stats.append_escaped(escaped, text_policy);
+            add_chunk_bytes(choice_stats, choice_stats.output_length - before);
+        }
+    }
+
+    // Content chunks received over all choices
+    size_t content_chunks() const {
+        size_t chunks = 0;
+        for (const auto& choice_stats : choices) {
+            chunks += choice_stats.number_of_chunks;
+        }
+        return chunks;
+    }
+
+    // Text and tool-call argument bytes received over all choices
+    size_t content_bytes() const {
+        size_t bytes = 0;
+        for (const auto& choice_stats : choices) {
+            bytes += choice_stats.output_length;
+            for (const auto& tool_call : choice_stats.tool_calls) {
+                bytes += tool_call.arguments_length;
+            }
+        }
+        return bytes;
+    }
+
+    // Flush decoders and order choices by index; choices arrive in stream order, so
+    // without this front() would be whichever choice happened to stream first
+    void finish_choices() {
+        for (auto& choice_stats : choices) {
+            choice_stats.finish_text(text_policy);
+        }
+        std::sort(choices.begin(), choices.end(),
+                  [](const ChoiceStats& a, const ChoiceStats& b) { return a.index < b.index; });
+    }
+
+    // Helper functions to calculate durations
+    std::optional<double> get_total_duration() const {
+        return seconds_between(start_time, end_time);
+    }
+
+    std::optional<double> get_ttft_duration() const {
+        return seconds_between(start_time, ttft_time);
+    }
+
+    // How much longer the client took to receive the output than the server
+    // reports it took to generate it
+    std::optional<double> get_delivery_lag() const {
+        auto decode_duration = seconds_between(ttft_time, end_time);
+        if (!decode_duration.has_value() || api_time_info.completion_time <= 0) {
+            return std::nullopt;
+        }
+        return decode_duration.value() - api_time_info.completion_time;
+    }
+
+    // Helper functions to get timestamps in seconds since epoch
+    std::optional<double> get_start_time() const {
+        if (start_time.time_since_epoch().count() > 0) {
+            return std::chrono::duration_cast<std::chrono::duration<double>>(
+                       start_time.time_since_epoch())
+                .count();
+        }
+        return std::nullopt;
+    }
+
+    std::optional<double> get_ttft_time() const {
+        if (ttft_time.time_since_epoch().count() > 0) {
+            return std::chrono::duration_cast<std::chrono::duration<double>>(
+                       ttft_time.time_since_epoch())
+                .count();
+        }
+        return std::nullopt;
+    }
+
+    std::optional<double> get_end_time() const {
+        if (end_time.time_since_epoch().count() > 0) {
+            return std::chrono::duration_cast<std::chrono::duration<double>>(
+                       end_time.time_since_epoch())
+                .count();
+        }
+        return std::nullopt;
+    }
+
+    // Usage information from API
+    struct UsageDetails {
+        size_t prompt_tokens = 0;
+        size_t completion_tokens = 0;
+        size_t total_tokens = 0;
+        // The response carried a usage block; aborted or failed streams often don't
+        bool reported = false;
+
+        static UsageDetails from_json(const nlohmann::json& usage) {
+            UsageDetails details;
+            details.reported = true;
+            details.prompt_tokens = usage.value("prompt_tokens", 0);
+            details.completion_tokens = usage.value("completion_tokens", 0);
+            details.total_tokens = usage.value("total_tokens", 0);
+            return details;
+        }
+
+        nlohmann::json to_json() const {
+            return {{"prompt_tokens", prompt_tokens},
+                    {"completion_tokens", completion_tokens},
+                    {"total_tokens", total_tokens}};
+        }
+    };
+    UsageDetails api_usage{};
+
+    // Time information from API
+    struct TimeInfo {
+        double queue_time = 0.0;
+        double prompt_time = 0.0;
+        double completion_time = 0.0;
+        double total_time = 0.0;
+        long long created = 0;
+
+        static TimeInfo from_json(const nlohmann::json& time_info) {
+            TimeInfo info;
+            info.queue_time = time_info.value("queue_time", 0.0);
+            info.prompt_time = time_info.value("prompt_time", 0.0);
+            info.completion_time = time_info.value("completion_time", 0.0);
+            info.total_time = time_info.value("total_time", 0.0);
+            info.created = time_info.value("created", 0);
+            return info;
+        }
+
+        nlohmann::json to_json() const {
+            return {{"queue_time", queue_time},
+                    {"prompt_time", prompt_time},
+                    {"completion_time", completion_time},
+                    {"total_time", total_time},
+                    {"created", created}};
+        }
+    };
+    TimeInfo api_time_info{};
+
+    // Embeddings mode details
+    struct EmbeddingDetails {
+        size_t batch_size = 0;
+        size_t number_of_inputs = 0;
+        size_t number_of_embeddings = 0;
+        size_t dimensions = 0;
+
+        nlohmann::json to_json() const {
+            return {{"batch_size", batch_size},
+                    {"number_of_inputs", number_of_inputs},
+                    {"number_of_embeddings", number_of_embeddings},
+                    {"dimensions", dimensions}};
+        }
+    };
+    std::optional<EmbeddingDetails> embedding;
+
+    nlohmann::json to_json() const {
+        nlohmann::json completion_json;
+        completion_json["input"] = input;
+        // finish_choices() sorts by index, so front() is the primary choice
+        if (text_policy == TextPolicy::kFull) {
+            completion_json["output_text"] = choices.empty() ? "" : choices.front().output_text;
+        } else if (text_policy == TextPolicy::kHash && !choices.empty()) {
+            std::ostringstream hash;
+            hash << std::hex << choices.front().output_hash;
+            completion_json["output_hash"] = hash.str();
+        }
+        completion_json["output_length"] = choices.empty() ? 0 : choices.front().output_length;
+        size_t invalid_utf8_sequences = 0;
+        for (const auto& choice_stats : choices) {
+            invalid_utf8_sequences += choice_stats.decoder.invalid_sequences();
+        }
+        completion_json["invalid_utf8_sequences"] = invalid_utf8_sequences;
+        if (!choices.empty()) {
+            choices.front().structured_to_json(completion_json, text_policy);
+        }
+        completion_json["success"] = success;
+        completion_json["error_message"] = error_message;
+
+        // Add duration information
+        auto total_duration = get_total_duration();
+        if (total_duration.has_value()) {
+            completion_json["total_duration_seconds"] = total_duration.value();
+        }
+
+        auto ttft_duration = get_ttft_duration();
+        if (ttft_duration.has_value()) {
+            completion_json["ttft_duration_seconds"] = ttft_duration.value();
+        }
+
+        completion_json["number_of_chunks"] = number_of_chunks;
+        completion_json["number_of_choices"] = choices.size();
+        completion_json["rate_limit_wait_seconds"] = rate_limit_wait_seconds;
+        completion_json["dispatch_position"] = dispatch_position;
+        completion_json["worker_id"] = worker_id;
+        if (slow_reader) {
+            completion_json["slow_reader"] = true;
+            auto delivery_lag = get_delivery_lag();
+            if (delivery_lag.has_value()) {
+                completion_json["delivery_lag_seconds"] = delivery_lag.value();
+            }
+        }
+        if (aborted) {
+            completion_json["aborted"] = true;
+            completion_json["wasted_chunks"] = content_chunks();
+        }
+        if (!chunk_granularity.is_null()) {
+            completion_json["chunk_granularity"] = chunk_granularity;
+        }
+        if (wire.recorded()) {
+            completion_json["wire_bytes"] =
+                wire.to_json(content_bytes(), api_usage.completion_tokens);
+        }
+
+        // Per-request throughput, over the whole request and over the decode phase
+        if (total_duration.has_value() && total_duration.value() > 0) {
+            completion_json["completion_tokens_per_second"] =
+                api_usage.completion_tokens / total_duration.value();
+        }
+        auto decode_duration = seconds_between(ttft_time, end_time);
+        if (decode_duration.has_value() && decode_duration.value() > 0) {
+            completion_json["decode_tokens_per_second"] =
+                api_usage.completion_tokens / decode_duration.value();
+        }
+
+        // Add timestamp information in seconds since epoch
+        auto start_time_seconds = get_start_time();
+        if (start_time_seconds.has_value()) {
+            completion_json["start_time"] = start_time_seconds.value();
+        }
+
+        auto ttft_time_seconds = get_ttft_time();
+        if (ttft_time_seconds.has_value()) {
+            completion_json["ttft_time"] = ttft_time_seconds.value();
+        }
+
+        auto end_time_seconds = get_end_time();
+        if (end_time_seconds.has_value()) {
+            completion_json["end_time"] = end_time_seconds.value();
+        }
+
+        // Add API usage details
+        completion_json["api_usage"] = api_usage.to_json();
+
+        // Add API time info
+        completion_json["api_time_info"] = api_time_info.to_json();
+
+        if (embedding.has_value()) {
+            completion_json["embedding"] = embedding->to_json();
+        }
+
+        if (!response_headers.empty()) {
+            nlohmann::json headers_json = nlohmann::json::object();
+            for (const auto& header : response_headers) {
+                if (header.is_numeric) {
+                    headers_json[header_name(header.name_id)] = header.number;
+                } else {
+                    headers_json[header_name(header.name_id)] = header.text;
+                }
+            }
+            completion_json["response_headers"] = headers_json;
+        }
+
+        if (!remote_address.empty()) {
+            completion_json["remote_address"] = remote_address;
+        }
+        if (!remote_address.empty() || tcp_info.has_value()) {
+            completion_json["new_connection"] = new_connection;
+        }
+        if (tcp_info.has_value()) {
+            completion_json["tcp_info"] = tcp_info->to_json();
+        }
+
+        // Usage is reported for the whole request, so it is split across choices in
+        // proportion to the number of content chunks each one received
+        if (choices.size() > 1) {
+            size_t total_choice_chunks = 0;
+            for (const auto& choice_stats : choices) {
+                total_choice_chunks += choice_stats.number_of_chunks;
+            }
+            nlohmann::json choices_array = nlohmann::json::array();
+            for (const auto& choice_stats : choices) {
+                double share = total_choice_chunks > 0
+                                   ? static_cast<double>(choice_stats.number_of_chunks) /
+                                         static_cast<double>(total_choice_chunks)
+                                   : 1.0 / static_cast<double>(choices.size());
+                choices_array.push_back(choice_stats.to_json(
+                    start_time, text_policy, share * api_usage.completion_tokens));
+            }
+            completion_json["choices"] = choices_array;
+        }
+
+        return completion_json;
+    }
+};
+
+// Stats structure for overall performance metrics
+struct OverallStats {
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point end_time;
+    size_t total_prompt_tokens = 0;
+    size_t total_completion_tokens = 0;
+    size_t total_tokens = 0;
+    size_t total_number_requests = 0;
+    size_t total_number_failures = 0;
+    size_t total_number_choices = 0;
+    size_t total_number_inputs = 0;
+    double total_rate_limit_wait_seconds = 0.0;
+
+    // Embeddings mode breakdown, keyed by input batch size
+    struct BatchSizeStats {
+        std::chrono::steady_clock::time_point start_time;
+        std::chrono::steady_clock::time_point end_time;
+        size_t number_requests = 0;
+        size_t number_failures = 0;
+        size_t number_inputs = 0;
+        size_t tokens = 0;
+        std::vector<double> latencies;
+
+        nlohmann::json to_json() const {
+            double duration = seconds_between(start_time, end_time).value_or(0.0);
+            double mean_latency = 0.0;
+            for (double latency : latencies) {
+                mean_latency += latency / static_cast<double>(latencies.size());
+            }
+            return {{"number_requests", number_requests},
+                    {"number_failures", number_failures},
+                    {"number_inputs", number_inputs},
+                    {"tokens", tokens},
+                    {"duration_seconds", duration},
+                    {"requests_per_second", duration > 0 ? number_requests / duration : 0.0},
+                    {"inputs_per_second", duration > 0 ? number_inputs / duration : 0.0},
+                    {"tokens_per_second", duration > 0 ? tokens / duration : 0.0},
+                    {"latency_seconds",
+                     {{"mean", mean_latency},
+                      {"p50", percentile(latencies, 50)},
+                      {"p90", percentile(latencies, 90)},
+                      {"p99", percentile(latencies, 99)},
+                      {"max", percentile(latencies, 100)}}}};
+        }
+    };
+    std::map<size_t, BatchSizeStats> by_batch_size;
+
+    // Numeric captured response headers, keyed by header name
+    HeaderSeriesMap header_series;
+
+    // Client-abort simulation summary, null when disabled
+    nlohmann::json aborts;
+
+    // Ramp and steady phase metrics, null without a ramp
+    nlohmann::json phases;
+
+    // Slow-reader simulation summary, null when disabled
+    nlohmann::json slow_readers;
+
+    // Detected warmup cutoff with full-run and steady-state metrics, null when
+    // detection is disabled
+    nlohmann::json steady_state;
+
+    // Features ranked by how much they set the slowest requests apart, null
+    // when tail attribution is disabled
+    nlohmann::json tail_attribution;
+
+    // Stage and queue metrics of a pipelined run, null for fused workers
+    nlohmann::json pipeline;
+
+    // Structured output and tool-call requests next to their free-form
+    // baselines, null when no request asks for either
+    nlohmann::json structured_output;
+
+    // Tokens per chunk, chunk sizes, gaps and coalescing signals, null when
+    // chunk analytics are disabled
+    nlohmann::json chunk_granularity;
+
+    // Wire bytes and egress rates per requested Accept-Encoding, with the
+    // compressed requests compared against the uncompressed ones
+    nlohmann::json wire_bytes;
+
+    // Requested and effective socket options with a TCP_INFO summary, null when
+    // no socket option was set
+    nlohmann::json socket_options;
+
+    // Endpoint addresses and per-address metrics, null without address pinning
+    nlohmann::json endpoint_addresses;
+    nlohmann::json by_remote_address;
+
+    // Helper functions to calculate durations
+    std::optional<double> get_total_duration() const {
+        return seconds_between(start_time, end_time);
+    }
+
+    // Helper functions to get timestamps in seconds since epoch
+    std::optional<double> get_start_time() const {
+        if (start_time.time_since_epoch().count() > 0) {
+            return std::chrono::duration_cast<std::chrono::duration<double>>(
+                       start_time.time_since_epoch())
+                .count();
+        }
+        return std::nullopt;
+    }
+
+    std::optional<double> get_end_time() const {
+        if (end_time.time_since_epoch().count() > 0) {
+            return std::chrono::duration_cast<std::chrono::duration<double>>(
+                       end_time.time_since_epoch())
+                .count();
+        }
+        return std::nullopt;
+    }
+
+    nlohmann::json to_json() const {
+        // Calculate duration from timestamps
+        auto total_duration = get_total_duration();
+        double total_duration_seconds = total_duration.value_or(0.0);
+
+        double requests_per_second =
+            total_duration_seconds > 0 ? total_number_requests / total_duration_seconds : 0.0;
+        double choices_per_second =
+            total_duration_seconds > 0 ? total_number_choices / total_duration_seconds : 0.0;
+        double completion_tokens_per_second =
+            total_duration_seconds > 0 ? total_completion_tokens / total_duration_seconds : 0.0;
+        double tokens_per_second =
+            total_duration_seconds > 0 ? total_tokens / total_duration_seconds : 0.0;
+
+        nlohmann::json overall_json = {{"total_duration_seconds", total_duration_seconds},
+                                       {"total_prompt_tokens", total_prompt_tokens},
+                                       {"total_completion_tokens", total_completion_tokens},
+                                       {"total_tokens", total_tokens},
+                                       {"total_number_requests", total_number_requests},
+                                       {"total_number_failures", total_number_failures},
+                                       {"total_number_choices", total_number_choices},
+                                       {"requests_per_second", requests_per_second},
+                                       {"choices_per_second", choices_per_second},
+                                       {"completion_tokens_per_second",
+                                        completion_tokens_per_second},
+                                       {"tokens_per_second", tokens_per_second},
+                                       {"total_rate_limit_wait_seconds",
+                                        total_rate_limit_wait_seconds}};
+
+        if (!by_batch_size.empty()) {
+            overall_json["total_number_inputs"] = total_number_inputs;
+            overall_json["inputs_per_second"] =
+                total_duration_seconds > 0 ? total_number_inputs / total_duration_seconds : 0.0;
+            nlohmann::json batch_json = nlohmann::json::object();
+            for (const auto& [batch_size, batch_stats] : by_batch_size) {
+                batch_json[std::to_string(batch_size)] = batch_stats.to_json();
+            }
+            overall_json["by_batch_size"] = batch_json;
+        }
+
+        if (!aborts.is_null()) {
+            overall_json["aborts"] = aborts;
+        }
+
+        if (!phases.is_null()) {
+            overall_json["phases"] = phases;
+        }
+
+        if (!slow_readers.is_null()) {
+            overall_json["slow_readers"] = slow_readers;
+        }
+
+        if (!steady_state.is_null()) {
+            overall_json["steady_state"] = steady_state;
+        }
+
+        if (!tail_attribution.is_null()) {
+            overall_json["tail_attribution"] = tail_attribution;
+        }
+
+        if (!pipeline.is_null()) {
+            overall_json["pipeline"] = pipeline;
+        }
+
+        if (!structured_output.is_null()) {
+            overall_json["structured_output"] = structured_output;
+        }
+
+        if (!chunk_granularity.is_null()) {
+            overall_json["chunk_granularity"] = chunk_granularity;
+        }
+
+        if (!wire_bytes.is_null()) {
+            overall_json["wire_bytes"] = wire_bytes;
+        }
+
+        if (!socket_options.is_null()) {
+            overall_json["socket_options"] = socket_options;
+        }
+
+        if (!endpoint_addresses.is_null()) {
+            overall_json["endpoint_addresses"] = endpoint_addresses;
+            overall_json["by_remote_address"] = by_remote_address;
+        }
+
+        if (!header_series.empty()) {
+            nlohmann::json headers_json = nlohmann::json::object();
+            for (const auto& [name, series] : header_series) {
+                headers_json[name] = series.to_json(start_time);
+            }
+            overall_json["response_headers"] = headers_json;
+        }
+
+        // Add timestamp information in seconds since epoch
+        auto start_time_seconds = get_start_time();
+        if (start_time_seconds.has_value()) {
+            overall_json["start_time"] = start_time_seconds.value();
+        }
+
+        auto end_time_seconds = get_end_time();
+        if (end_time_seconds.has_value()) {
+            overall_json["end_time"] = end_time_seconds.value();
+        }
+
+        return overall_json;
+    }
+};
+
+// Aggregated run statistics plus the per-request records, in request order
+using Stats = std::pair<OverallStats, std::vector<CompletionStats>>;
+
+// Totals over a set of per-request records; start_time and end_time are left
+// for the caller, which knows the run boundaries
+OverallStats aggregate_stats(const std::vector<CompletionStats>& all_completion_stats);
+
+// Report layout written by the JSON sink: overall_stats and completions
+nlohmann::json stats_to_json(const Stats& stats);
+
+}  // namespace bench_core
@@ -0,0 +1,219 @@
+#include "bench_core/steady_state.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace bench_core {
+
+namespace {
+
+constexpr size_t kBatchSize = 5;
+constexpr size_t kMinBatches = 4;
+
+// Interval of a time point, clamped to the run
+size_t interval_of(std::chrono::steady_clock::time_point time,
+                   std::chrono::steady_clock::time_point start_time, double interval_seconds,
+                   size_t intervals) {
+    double offset = seconds_between(start_time, time).value_or(0.0);
+    double index = std::floor(std::max(0.0, offset) / interval_seconds);
+    return std::min(static_cast<size_t>(index), intervals - 1);
+}
+
+// Per-interval mean of the samples; empty intervals repeat the previous mean
+// (the first non-empty one at the start) so the series stays evenly spaced
+std::vector<double> interval_means(const std::vector<double>& sums,
+                                   const std::vector<size_t>& counts) {
+    std::vector<double> means(sums.size(), 0.0);
+    std::optional<double> previous;
+    for (size_t i = 0; i < sums.size(); ++i) {
+        if (counts[i] > 0) {
+            means[i] = sums[i] / static_cast<double>(counts[i]);
+            if (!previous.has_value()) {
+                std::fill(means.begin(), means.begin() + static_cast<std::ptrdiff_t>(i), means[i]);
+            }
+            previous = means[i];
+        } else if (previous.has_value()) {
+            means[i] = previous.value();
+        }
+    }
+    return means;
+}
+
+nlohmann::json summarize_window(const std::vector<const CompletionStats*>& window,
+                                 double duration_seconds) {
+    size_t failures = 0;
+    size_t completion_tokens = 0;
+    std::vector<double> ttfts;
+    std::vector<double> latencies;
+    for (const auto* completion_stats : window) {
+        completion_tokens += completion_stats->api_usage.completion_tokens;
+        if (!completion_stats->success) {
+            failures++;
+            continue;
+        }
+        if (auto ttft = completion_stats->get_ttft_duration(); ttft.has_value()) {
+            ttfts.push_back(ttft.value());
+        }
+        if (auto latency = completion_stats->get_total_duration(); latency.has_value()) {
+            latencies.push_back(latency.value());
+        }
+    }
+    double requests = static_cast<double>(window.size());
+    return {{"duration_seconds", duration_seconds},
+            {"number_requests", window.size()},
+            {"number_failures", failures},
+            {"requests_per_second", duration_seconds > 0 ? requests / duration_seconds : 0.0},
+            {"completion_tokens_per_second",
+             duration_seconds > 0 ? completion_tokens / duration_seconds : 0.0},
+            {"ttft_p50_seconds", percentile(ttfts, 50)},
+            {"ttft_p90_seconds", percentile(ttfts, 90)},
+            {"ttft_p99_seconds", percentile(ttfts, 99)},
+            {"latency_p50_seconds", percentile(latencies, 50)},
+            {"latency_p90_seconds", percentile(latencies, 90)},
+            {"latency_p99_seconds", percentile(latencies, 99)}};
+}
+
+}  // namespace
+
+size_t mser5_truncation(const std::vector<double>& series) {
+    size_t batches = series.size() / kBatchSize;
+    if (batches < kMinBatches) {
+        return 0;
+    }
+    std::vector<double> means(batches, 0.0);
+    for (size_t i = 0; i < batches * kBatchSize; ++i) {
+        means[i / kBatchSize] += series[i] / static_cast<double>(kBatchSize);
+    }
+
+    // Sums over the kept suffix, accumulated from the end
+    double sum = 0.0;
+    double sum_squares = 0.0;
+    std::vector<double> statistic(batches, 0.0);
+    for (size_t d = batches; d-- > 0;) {
+        sum += means[d];
+        sum_squares += means[d] * means[d];
+        double kept = static_cast<double>(batches - d);
+        double squared_error = std::max(0.0, sum_squares - sum * sum / kept);
+        statistic[d] = squared_error / (kept * kept);
+    }
+
+    size_t best = 0;
+    double best_statistic = std::numeric_limits<double>::infinity();
+    for (size_t d = 0; d <= batches / 2; ++d) {
+        if (statistic[d] < best_statistic) {
+            best_statistic = statistic[d];
+            best = d;
+        }
+    }
+    return best * kBatchSize;
+}
+
+nlohmann::json summarize_steady_state(const std::vector<CompletionStats>& all_completion_stats,
+                                      std::chrono::steady_clock::time_point start_time,
+                                      std::chrono::steady_clock::time_point end_time,
+                                      const SteadyStateConfig& config) {
+    double run_seconds = seconds_between(start_time, end_time).value_or(0.0);
+    double interval_seconds =
+        config.interval_seconds > 0
+            ? config.interval_seconds
+            : run_seconds / static_cast<double>(SteadyStateConfig::kAutoIntervals);
+    if (run_seconds <= 0 || interval_seconds <= 0) {
+        return nullptr;
+    }
+    size_t intervals = static_cast<size_t>(std::ceil(run_seconds / interval_seconds));
+    intervals = std::max<size_t>(1, intervals);
+
+    std::vector<double> completed(intervals, 0.0);
+    std::vector<double> completion_tokens(intervals, 0.0);
+    std::vector<double> ttft_sums(intervals, 0.0);
+    std::vector<size_t> ttft_counts(intervals, 0);
+    std::vector<double> latency_sums(intervals, 0.0);
+    std::vector<size_t> latency_counts(intervals, 0);
+    for (const auto& completion_stats : all_completion_stats) {
+        if (!completion_stats.success) {
+            continue;
+        }
+        size_t start_interval =
+            interval_of(completion_stats.start_time, start_time, interval_seconds, intervals);
+        size_t end_interval =
+            interval_of(completion_stats.end_time, start_time, interval_seconds, intervals);
+        completed[end_interval] += 1.0;
+
+        // Completion tokens are spread over the chunks that carried them, or
+        // land at the end of requests without chunk timings
+        size_t chunks = 0;
+        for (const auto& choice_stats : completion_stats.choices) {
+            chunks += choice_stats.chunk_times.size();
+        }
+        double tokens = static_cast<double>(completion_stats.api_usage.completion_tokens);
+        if (chunks == 0) {
+            completion_tokens[end_interval] += tokens;
+        } else {
+            for (const auto& choice_stats : completion_stats.choices) {
+                for (auto chunk_time : choice_stats.chunk_times) {
+                    completion_tokens[interval_of(chunk_time, start_time, interval_seconds,
+                                                  intervals)] +=
+                        tokens / static_cast<double>(chunks);
+                }
+            }
+        }
+
+        if (auto ttft = completion_stats.get_ttft_duration(); ttft.has_value()) {
+            ttft_sums[start_interval] += ttft.value();
+            ttft_counts[start_interval]++;
+        }
+        if (auto latency = completion_stats.get_total_duration(); latency.has_value()) {
+            latency_sums[start_interval] += latency.value();
+            latency_counts[start_interval]++;
+        }
+    }
+    for (size_t i = 0; i < intervals; ++i) {
+        completed[i] /= interval_seconds;
+        completion_tokens[i] /= interval_seconds;
+    }
+
+    std::vector<std::pair<const char*, std::vector<double>>> series = {
+        {"requests_per_second", std::move(completed)},
+        {"completion_tokens_per_second", std::move(completion_tokens)},
+        {"ttft_seconds", interval_means(ttft_sums, ttft_counts)},
+        {"latency_seconds", interval_means(latency_sums, latency_counts)}};
+
+    size_t cutoff_interval = 0;
+    nlohmann::json series_json = nlohmann::json::object();
+    for (const auto& [name, values] : series) {
+        size_t truncation = mser5_truncation(values);
+        cutoff_interval = std::max(cutoff_interval, truncation);
+        series_json[name] = {{"cutoff_interval", truncation},
+                             {"cutoff_seconds", truncation * interval_seconds}};
+    }
+    double cutoff_seconds = cutoff_interval * interval_seconds;
+    auto cutoff_time = start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                        std::chrono::duration<double>(cutoff_seconds));
+
+    std::vector<const CompletionStats*> full_run;
+    std::vector<const CompletionStats*> steady_state;
+    for (const auto& completion_stats : all_completion_stats) {
+        full_run.push_back(&completion_stats);
+        if (completion_stats.start_time >= cutoff_time) {
+            steady_state.push_back(&completion_stats);
+        }
+    }
+
+    return {{"method", "mser-5"},
+            {"interval_seconds", interval_seconds},
+            {"intervals", intervals},
+            {"sufficient_data", intervals / kBatchSize >= kMinBatches},
+            {"cutoff_interval", cutoff_interval},
+            {"cutoff_seconds", cutoff_seconds},
+            {"truncated_requests", full_run.size() - steady_state.size()},
+            {"series", series_json},
+            {"full_run", summarize_window(full_run, run_seconds)},
+            {"steady_state",
+             summarize_window(steady_state, std::max(0.0, run_seconds - cutoff_seconds))}};
+}
+
+}  // namespace bench_core
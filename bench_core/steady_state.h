@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// Automatic warmup truncation: the run is cut into fixed-width intervals, and
+// MSER-5 picks the end of the initialization transient on throughput and
+// latency series built from them
+struct SteadyStateConfig {
+    bool enabled = false;
+    // Interval width; 0 splits the run into kAutoIntervals intervals
+    double interval_seconds = 0.0;
+
+    static constexpr size_t kAutoIntervals = 100;
+};
+
+// MSER-5 truncation point of series: averages batches of 5 observations and
+// returns the index of the first observation kept, minimizing the standard
+// error of the remaining batch means. Only the first half of the batches may
+// be truncated; fewer than 4 batches yield 0.
+size_t mser5_truncation(const std::vector<double>& series);
+
+// Cutoff per series (request and completion token throughput by completion
+// time, TTFT and latency by start time), the overall cutoff as the latest of
+// them, and full-run metrics next to those of the requests started after it
+nlohmann::json summarize_steady_state(const std::vector<CompletionStats>& all_completion_stats,
+                                      std::chrono::steady_clock::time_point start_time,
+                                      std::chrono::steady_clock::time_point end_time,
+                                      const SteadyStateConfig& config);
+
+}  // namespace bench_core
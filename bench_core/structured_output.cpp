@@ -0,0 +1,240 @@
+#include "bench_core/structured_output.h"
+
+#include <array>
+#include <map>
+
+namespace bench_core {
+
+namespace {
+
+constexpr std::array<const char*, 2> kStructuredKinds = {"response_format", "tools"};
+
+// Latency and throughput samples of one group of successful requests
+struct GroupSamples {
+    size_t requests = 0;
+    size_t failures = 0;
+    size_t completion_tokens = 0;
+    std::vector<double> ttfts;
+    // Time per output token after the first one
+    std::vector<double> tpots;
+    std::vector<double> latencies;
+    std::vector<double> decode_tokens_per_second;
+
+    void add(const CompletionStats& stats) {
+        requests++;
+        if (!stats.success) {
+            failures++;
+            return;
+        }
+        size_t tokens = stats.api_usage.completion_tokens;
+        completion_tokens += tokens;
+        if (auto ttft = stats.get_ttft_duration(); ttft.has_value()) {
+            ttfts.push_back(ttft.value());
+        }
+        if (auto latency = stats.get_total_duration(); latency.has_value()) {
+            latencies.push_back(latency.value());
+        }
+        auto decode_duration = seconds_between(stats.ttft_time, stats.end_time);
+        if (decode_duration.has_value() && decode_duration.value() > 0 && tokens > 1) {
+            tpots.push_back(decode_duration.value() / static_cast<double>(tokens - 1));
+            decode_tokens_per_second.push_back(static_cast<double>(tokens) /
+                                               decode_duration.value());
+        }
+    }
+
+    bool empty() const { return requests == failures; }
+
+    nlohmann::json to_json() const {
+        size_t successes = requests - failures;
+        return {{"requests", requests},
+                {"failures", failures},
+                {"mean_completion_tokens",
+                 successes > 0 ? static_cast<double>(completion_tokens) /
+                                     static_cast<double>(successes)
+                               : 0.0},
+                {"ttft_p50_seconds", percentile(ttfts, 50)},
+                {"ttft_p99_seconds", percentile(ttfts, 99)},
+                {"tpot_p50_seconds", percentile(tpots, 50)},
+                {"tpot_p99_seconds", percentile(tpots, 99)},
+                {"latency_p50_seconds", percentile(latencies, 50)},
+                {"latency_p99_seconds", percentile(latencies, 99)},
+                {"decode_tokens_per_second_p50", percentile(decode_tokens_per_second, 50)}};
+    }
+};
+
+// Outcome counts of streamed JSON validation
+struct ValidationCounts {
+    size_t checked = 0;
+    size_t valid = 0;
+    size_t incomplete = 0;
+    size_t invalid = 0;
+
+    void add(const JsonStreamValidator& validator) {
+        checked++;
+        if (!validator.valid()) {
+            invalid++;
+        } else if (validator.complete()) {
+            valid++;
+        } else {
+            incomplete++;
+        }
+    }
+
+    nlohmann::json to_json() const {
+        return {{"checked", checked},
+                {"valid", valid},
+                {"incomplete", incomplete},
+                {"invalid", invalid}};
+    }
+};
+
+struct KindSummary {
+    GroupSamples structured;
+    GroupSamples generated_baseline;
+    ValidationCounts json_output;
+    ValidationCounts tool_call_arguments;
+    size_t tool_calls = 0;
+    size_t requests_without_tool_calls = 0;
+};
+
+nlohmann::json ratio(double value, double baseline) {
+    return baseline > 0 ? nlohmann::json(value / baseline) : nlohmann::json(nullptr);
+}
+
+nlohmann::json overhead_json(const GroupSamples& structured, const GroupSamples& baseline) {
+    double ttft = percentile(structured.ttfts, 50);
+    double baseline_ttft = percentile(baseline.ttfts, 50);
+    double tpot = percentile(structured.tpots, 50);
+    double baseline_tpot = percentile(baseline.tpots, 50);
+    return {{"ttft_p50_ratio", ratio(ttft, baseline_ttft)},
+            {"ttft_p50_delta_seconds", ttft - baseline_ttft},
+            {"tpot_p50_ratio", ratio(tpot, baseline_tpot)},
+            {"tpot_p50_delta_seconds", tpot - baseline_tpot},
+            {"latency_p50_ratio",
+             ratio(percentile(structured.latencies, 50), percentile(baseline.latencies, 50))},
+            {"decode_tokens_per_second_p50_ratio",
+             ratio(percentile(structured.decode_tokens_per_second, 50),
+                   percentile(baseline.decode_tokens_per_second, 50))}};
+}
+
+}  // namespace
+
+bool expects_json_output(const nlohmann::json& request) {
+    if (!request.contains("response_format") || !request["response_format"].is_object()) {
+        return false;
+    }
+    std::string type = request["response_format"].value("type", "");
+    return type == "json_object" || type == "json_schema";
+}
+
+std::string structured_output_kind(const nlohmann::json& request) {
+    if (request.contains("tools") && request["tools"].is_array() && !request["tools"].empty()) {
+        return "tools";
+    }
+    if (request.contains("response_format") && request["response_format"].is_object() &&
+        request["response_format"].value("type", "text") != "text") {
+        return "response_format";
+    }
+    return "free_form";
+}
+
+std::vector<nlohmann::json> add_structured_baselines(
+    const std::vector<nlohmann::json>& requests) {
+    std::vector<nlohmann::json> expanded;
+    expanded.reserve(requests.size() * 2);
+    for (const auto& request : requests) {
+        expanded.push_back(request);
+        std::string kind = structured_output_kind(request);
+        if (kind == "free_form") {
+            continue;
+        }
+        nlohmann::json baseline = request;
+        baseline.erase("response_format");
+        baseline.erase("tools");
+        baseline.erase("tool_choice");
+        baseline.erase("parallel_tool_calls");
+        baseline[kStructuredBaselineField] = kind;
+        expanded.push_back(std::move(baseline));
+    }
+    return expanded;
+}
+
+nlohmann::json summarize_structured_output(const std::vector<CompletionStats>& all) {
+    std::map<std::string, KindSummary> kinds;
+    GroupSamples free_form;
+    for (const auto& stats : all) {
+        if (stats.input.contains(kStructuredBaselineField)) {
+            kinds[stats.input.value(kStructuredBaselineField, "")].generated_baseline.add(stats);
+            continue;
+        }
+        std::string kind = structured_output_kind(stats.input);
+        if (kind == "free_form") {
+            free_form.add(stats);
+            continue;
+        }
+        auto& summary = kinds[kind];
+        summary.structured.add(stats);
+        // Aborted streams are truncated on purpose
+        if (!stats.success || stats.aborted) {
+            continue;
+        }
+        bool has_tool_calls = false;
+        for (const auto& choice_stats : stats.choices) {
+            if (choice_stats.json_validator.has_value()) {
+                summary.json_output.add(choice_stats.json_validator.value());
+            }
+            for (const auto& tool_call_stats : choice_stats.tool_calls) {
+                summary.tool_call_arguments.add(tool_call_stats.validator);
+                summary.tool_calls++;
+                has_tool_calls = true;
+            }
+        }
+        if (kind == "tools" && !has_tool_calls) {
+            summary.requests_without_tool_calls++;
+        }
+    }
+
+    nlohmann::json report = nlohmann::json::object();
+    for (const char* kind : kStructuredKinds) {
+        auto it = kinds.find(kind);
+        if (it == kinds.end() || it->second.structured.requests == 0) {
+            continue;
+        }
+        const auto& summary = it->second;
+        // Generated twins are the closest match; otherwise fall back to the
+        // free-form requests of the same run
+        const GroupSamples* baseline = nullptr;
+        std::string baseline_source = "none";
+        if (summary.generated_baseline.requests > 0) {
+            baseline = &summary.generated_baseline;
+            baseline_source = "generated";
+        } else if (free_form.requests > 0) {
+            baseline = &free_form;
+            baseline_source = "free_form_requests";
+        }
+
+        nlohmann::json kind_json = {{"structured", summary.structured.to_json()},
+                                    {"baseline_source", baseline_source},
+                                    {"baseline", nullptr},
+                                    {"overhead", nullptr}};
+        if (baseline != nullptr) {
+            kind_json["baseline"] = baseline->to_json();
+            if (!summary.structured.empty() && !baseline->empty()) {
+                kind_json["overhead"] = overhead_json(summary.structured, *baseline);
+            }
+        }
+        if (summary.json_output.checked > 0) {
+            kind_json["json_output"] = summary.json_output.to_json();
+        }
+        if (std::string(kind) == "tools") {
+            auto arguments_json = summary.tool_call_arguments.to_json();
+            arguments_json["tool_calls"] = summary.tool_calls;
+            arguments_json["requests_without_tool_calls"] = summary.requests_without_tool_calls;
+            kind_json["tool_call_arguments"] = arguments_json;
+        }
+        report[kind] = kind_json;
+    }
+    return report.empty() ? nlohmann::json(nullptr) : report;
+}
+
+}  // namespace bench_core
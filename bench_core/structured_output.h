@@ -0,0 +1,38 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// Structured output (a JSON response_format) and tool calling add server-side
+// work: constrained decoding, grammar compilation and longer prompts for tool
+// schemas. Requests are classified by what they ask for and measured against
+// free-form baselines.
+
+// Request field labelling a generated baseline with the kind it stands in for;
+// it is never sent to the server
+inline constexpr const char* kStructuredBaselineField = "structured_baseline";
+
+// "tools" for requests offering tools, "response_format" for requests asking
+// for a JSON object or schema, "free_form" otherwise
+std::string structured_output_kind(const nlohmann::json& request);
+
+// Whether the response text is expected to be JSON
+bool expects_json_output(const nlohmann::json& request);
+
+// Follow every structured request with its free-form twin: the same request
+// minus response_format, tools, tool_choice and parallel_tool_calls. Pairs run
+// next to each other, so both see the same load.
+std::vector<nlohmann::json> add_structured_baselines(const std::vector<nlohmann::json>& requests);
+
+// Per kind: TTFT, TPOT, latency and decode throughput of the structured
+// requests next to their baselines (generated ones, else the free-form requests
+// of the input), the overhead ratios, and how many JSON outputs and tool-call
+// arguments were valid and complete. Null when no request is structured.
+nlohmann::json summarize_structured_output(const std::vector<CompletionStats>& all);
+
+}  // namespace bench_core
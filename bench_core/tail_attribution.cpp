@@ -0,0 +1,309 @@
+#include "bench_core/tail_attribution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <optional>
+#include <random>
+#include <stdexcept>
+
+namespace bench_core {
+
+namespace {
+
+constexpr double kBaselineLow = 25.0;
+constexpr double kBaselineHigh = 75.0;
+// Categorical values listed per feature, by largest share difference
+constexpr size_t kTopValues = 5;
+// Below this many tail requests the scores are mostly noise, so none are ranked
+constexpr size_t kMinTailRequests = 10;
+// Group-label permutations used to estimate each score's value under chance
+constexpr size_t kPermutations = 200;
+constexpr unsigned int kPermutationSeed = 0x7a11;
+
+using Group = std::vector<const CompletionStats*>;
+
+// P(tail > baseline) - P(tail < baseline), from the sorted baseline
+double cliffs_delta(const std::vector<double>& tail, std::vector<double> baseline) {
+    if (tail.empty() || baseline.empty()) {
+        return 0.0;
+    }
+    std::sort(baseline.begin(), baseline.end());
+    double dominance = 0.0;
+    for (double value : tail) {
+        auto lower = std::lower_bound(baseline.begin(), baseline.end(), value);
+        auto upper = std::upper_bound(lower, baseline.end(), value);
+        auto below = static_cast<double>(lower - baseline.begin());
+        auto above = static_cast<double>(baseline.end() - upper);
+        dominance += below - above;
+    }
+    return dominance / (static_cast<double>(tail.size()) * static_cast<double>(baseline.size()));
+}
+
+// Total variation distance between the value shares of the two groups; values
+// are small integer codes below number_of_values
+double total_variation(const std::vector<size_t>& tail, const std::vector<size_t>& baseline,
+                       size_t number_of_values) {
+    std::vector<double> difference(number_of_values, 0.0);
+    for (size_t code : tail) {
+        difference[code] += 1.0 / static_cast<double>(tail.size());
+    }
+    for (size_t code : baseline) {
+        difference[code] -= 1.0 / static_cast<double>(baseline.size());
+    }
+    double distance = 0.0;
+    for (double value : difference) {
+        distance += std::abs(value) / 2.0;
+    }
+    return distance;
+}
+
+// Raw scores are biased upward when the tail is small, and more so for
+// categorical features with many values, so each is corrected for chance:
+// the same score is recomputed with the group labels of the pooled values
+// shuffled, and the reported score is (raw - chance) / (1 - chance), floored
+// at 0. Numeric and categorical scores are then comparable, and a feature
+// unrelated to the tail scores near 0 whatever its number of values.
+template <typename Value, typename Score>
+void correct_for_chance(nlohmann::json& result, const std::vector<Value>& tail,
+                        const std::vector<Value>& baseline, double raw, Score score) {
+    std::vector<Value> pooled = tail;
+    pooled.insert(pooled.end(), baseline.begin(), baseline.end());
+    std::mt19937 rng(kPermutationSeed);
+    double chance_sum = 0.0;
+    size_t at_least_raw = 0;
+    for (size_t i = 0; i < kPermutations; ++i) {
+        std::shuffle(pooled.begin(), pooled.end(), rng);
+        std::vector<Value> permuted_tail(pooled.begin(), pooled.begin() + tail.size());
+        std::vector<Value> permuted_baseline(pooled.begin() + tail.size(), pooled.end());
+        double permuted = score(permuted_tail, permuted_baseline);
+        chance_sum += permuted;
+        at_least_raw += permuted >= raw ? 1 : 0;
+    }
+    double chance = chance_sum / static_cast<double>(kPermutations);
+    result["raw_score"] = raw;
+    result["chance_score"] = chance;
+    result["score"] = chance < 1.0 ? std::max(0.0, (raw - chance) / (1.0 - chance)) : 0.0;
+    result["p_value"] =
+        static_cast<double>(at_least_raw + 1) / static_cast<double>(kPermutations + 1);
+}
+
+nlohmann::json numeric_feature(const char* name, const Group& tail, const Group& baseline,
+                               const std::function<double(const CompletionStats&)>& feature) {
+    std::vector<double> tail_values;
+    std::vector<double> baseline_values;
+    for (const auto* completion_stats : tail) {
+        tail_values.push_back(feature(*completion_stats));
+    }
+    for (const auto* completion_stats : baseline) {
+        baseline_values.push_back(feature(*completion_stats));
+    }
+    double delta = cliffs_delta(tail_values, baseline_values);
+    nlohmann::json result = {{"feature", name},
+                             {"kind", "numeric"},
+                             {"cliffs_delta", delta},
+                             {"tail_median", percentile(tail_values, 50)},
+                             {"baseline_median", percentile(baseline_values, 50)}};
+    correct_for_chance(result, tail_values, baseline_values, std::abs(delta),
+                       [](const std::vector<double>& t, const std::vector<double>& b) {
+                           return std::abs(cliffs_delta(t, b));
+                       });
+    return result;
+}
+
+nlohmann::json categorical_feature(
+    const char* name, const Group& tail, const Group& baseline,
+    const std::function<std::string(const CompletionStats&)>& feature) {
+    // Map values to codes, keeping counts per group for the listed shares
+    std::map<std::string, size_t> codes;
+    std::vector<std::string> names;
+    std::vector<std::pair<size_t, size_t>> counts;
+    auto encode = [&](const Group& group, bool is_tail) {
+        std::vector<size_t> encoded;
+        for (const auto* completion_stats : group) {
+            auto [it, inserted] = codes.emplace(feature(*completion_stats), names.size());
+            if (inserted) {
+                names.push_back(it->first);
+                counts.emplace_back(0, 0);
+            }
+            (is_tail ? counts[it->second].first : counts[it->second].second)++;
+            encoded.push_back(it->second);
+        }
+        return encoded;
+    };
+    auto tail_codes = encode(tail, true);
+    auto baseline_codes = encode(baseline, false);
+    size_t number_of_values = names.size();
+
+    std::vector<std::pair<double, size_t>> by_difference;
+    for (size_t code = 0; code < number_of_values; ++code) {
+        double difference =
+            static_cast<double>(counts[code].first) / static_cast<double>(tail.size()) -
+            static_cast<double>(counts[code].second) / static_cast<double>(baseline.size());
+        by_difference.emplace_back(-std::abs(difference), code);
+    }
+    std::sort(by_difference.begin(), by_difference.end());
+    nlohmann::json values = nlohmann::json::array();
+    for (size_t i = 0; i < std::min(kTopValues, by_difference.size()); ++i) {
+        size_t code = by_difference[i].second;
+        values.push_back(
+            {{"value", names[code]},
+             {"tail_share",
+              static_cast<double>(counts[code].first) / static_cast<double>(tail.size())},
+             {"baseline_share",
+              static_cast<double>(counts[code].second) / static_cast<double>(baseline.size())}});
+    }
+    nlohmann::json result = {{"feature", name},
+                             {"kind", "categorical"},
+                             {"distinct_values", number_of_values},
+                             {"values", values}};
+    correct_for_chance(result, tail_codes, baseline_codes,
+                       total_variation(tail_codes, baseline_codes, number_of_values),
+                       [number_of_values](const std::vector<size_t>& t,
+                                          const std::vector<size_t>& b) {
+                           return total_variation(t, b, number_of_values);
+                       });
+    return result;
+}
+
+std::string tags_of(const CompletionStats& completion_stats) {
+    const auto& input = completion_stats.input;
+    std::vector<std::string> tags;
+    if (input.contains("tag") && input["tag"].is_string()) {
+        tags.push_back(input["tag"].get<std::string>());
+    }
+    if (input.contains("tags") && input["tags"].is_array()) {
+        for (const auto& tag : input["tags"]) {
+            if (tag.is_string()) {
+                tags.push_back(tag.get<std::string>());
+            }
+        }
+    }
+    std::sort(tags.begin(), tags.end());
+    std::string joined;
+    for (const auto& tag : tags) {
+        joined += (joined.empty() ? "" : ",") + tag;
+    }
+    return joined;
+}
+
+}  // namespace
+
+TailAttributionConfig::Metric parse_tail_metric(const std::string& value) {
+    if (value == "none") {
+        return TailAttributionConfig::Metric::kNone;
+    }
+    if (value == "ttft") {
+        return TailAttributionConfig::Metric::kTtft;
+    }
+    if (value == "latency") {
+        return TailAttributionConfig::Metric::kLatency;
+    }
+    throw std::invalid_argument("Unknown tail attribution metric: " + value);
+}
+
+nlohmann::json summarize_tail_attribution(const std::vector<CompletionStats>& all_completion_stats,
+                                          std::chrono::steady_clock::time_point start_time,
+                                          const TailAttributionConfig& config) {
+    auto metric_of = [&](const CompletionStats& completion_stats) {
+        return config.metric == TailAttributionConfig::Metric::kTtft
+                   ? completion_stats.get_ttft_duration()
+                   : completion_stats.get_total_duration();
+    };
+    std::vector<std::pair<double, const CompletionStats*>> measured;
+    for (const auto& completion_stats : all_completion_stats) {
+        auto value = metric_of(completion_stats);
+        if (completion_stats.success && value.has_value()) {
+            measured.emplace_back(value.value(), &completion_stats);
+        }
+    }
+    std::vector<double> metric_values;
+    for (const auto& [value, completion_stats] : measured) {
+        metric_values.push_back(value);
+    }
+    double threshold = percentile(metric_values, config.percentile);
+    double baseline_low = percentile(metric_values, kBaselineLow);
+    double baseline_high = percentile(metric_values, kBaselineHigh);
+
+    Group tail;
+    Group baseline;
+    for (const auto& [value, completion_stats] : measured) {
+        if (value >= threshold) {
+            tail.push_back(completion_stats);
+        } else if (value >= baseline_low && value <= baseline_high) {
+            baseline.push_back(completion_stats);
+        }
+    }
+
+    nlohmann::json report = {
+        {"metric", config.metric == TailAttributionConfig::Metric::kTtft ? "ttft" : "latency"},
+        {"percentile", config.percentile},
+        {"threshold_seconds", threshold},
+        {"baseline_low_seconds", baseline_low},
+        {"baseline_high_seconds", baseline_high},
+        {"tail_requests", tail.size()},
+        {"baseline_requests", baseline.size()},
+        {"min_tail_requests", kMinTailRequests}};
+    if (tail.size() < kMinTailRequests || baseline.empty()) {
+        report["ranked"] = false;
+        report["reason"] = "Tail has " + std::to_string(tail.size()) + " requests, at least " +
+                           std::to_string(kMinTailRequests) + " are needed to rank features";
+        if (baseline.empty()) {
+            report["reason"] = "No baseline requests";
+        }
+        report["features"] = nlohmann::json::array();
+        return report;
+    }
+    report["ranked"] = true;
+
+    bool has_connections = false;
+    bool has_tags = false;
+    for (const auto& [value, completion_stats] : measured) {
+        has_connections = has_connections || !completion_stats->remote_address.empty();
+        has_tags = has_tags || !tags_of(*completion_stats).empty();
+    }
+
+    std::vector<nlohmann::json> features = {
+        numeric_feature("prompt_tokens", tail, baseline,
+                        [](const CompletionStats& s) {
+                            return static_cast<double>(s.api_usage.prompt_tokens);
+                        }),
+        numeric_feature("completion_tokens", tail, baseline,
+                        [](const CompletionStats& s) {
+                            return static_cast<double>(s.api_usage.completion_tokens);
+                        }),
+        numeric_feature("server_queue_time_seconds", tail, baseline,
+                        [](const CompletionStats& s) { return s.api_time_info.queue_time; }),
+        numeric_feature("server_prompt_time_seconds", tail, baseline,
+                        [](const CompletionStats& s) { return s.api_time_info.prompt_time; }),
+        numeric_feature("start_offset_seconds", tail, baseline,
+                        [&](const CompletionStats& s) {
+                            return seconds_between(start_time, s.start_time).value_or(0.0);
+                        }),
+        numeric_feature("rate_limit_wait_seconds", tail, baseline,
+                        [](const CompletionStats& s) { return s.rate_limit_wait_seconds; }),
+        categorical_feature("worker_id", tail, baseline, [](const CompletionStats& s) {
+            return std::to_string(s.worker_id);
+        })};
+    if (has_connections) {
+        features.push_back(categorical_feature(
+            "new_connection", tail, baseline,
+            [](const CompletionStats& s) { return s.new_connection ? "true" : "false"; }));
+        features.push_back(categorical_feature(
+            "remote_address", tail, baseline,
+            [](const CompletionStats& s) { return s.remote_address; }));
+    }
+    if (has_tags) {
+        features.push_back(categorical_feature("tags", tail, baseline, tags_of));
+    }
+
+    std::stable_sort(features.begin(), features.end(),
+                     [](const nlohmann::json& a, const nlohmann::json& b) {
+                         return a["score"].get<double>() > b["score"].get<double>();
+                     });
+    report["features"] = features;
+    return report;
+}
+
+}  // namespace bench_core
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// Tail-latency attribution: how the slowest requests differ from typical ones
+struct TailAttributionConfig {
+    enum class Metric { kNone, kTtft, kLatency };
+    Metric metric = Metric::kNone;
+    // Requests at or above this percentile of the metric form the tail
+    double percentile = 99.0;
+
+    bool enabled() const { return metric != Metric::kNone; }
+};
+
+// Parse "none", "ttft" or "latency"; throws std::invalid_argument otherwise
+TailAttributionConfig::Metric parse_tail_metric(const std::string& value);
+
+// Compare the tail of the successful requests against the interquartile
+// baseline (25th to 75th percentile of the metric). Numeric features (prompt
+// and completion tokens, server queue and prompt time, start time in the run,
+// rate-limit wait) are scored by the absolute Cliff's delta between the groups;
+// categorical ones (new connection, worker, remote address, tags) by the total
+// variation distance of their value shares. Both raw scores are corrected for
+// chance against permuted group labels, which puts them on one [0, 1] scale
+// with unrelated features near 0, and features are ranked by the corrected
+// score. A tail too small to rank reports no features.
+nlohmann::json summarize_tail_attribution(const std::vector<CompletionStats>& all_completion_stats,
+                                          std::chrono::steady_clock::time_point start_time,
+                                          const TailAttributionConfig& config);
+
+}  // namespace bench_core
@@ -0,0 +1,903 @@
+#include "bench_core/text_decoding.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define BENCH_HAVE_X86_SIMD 1
+#else
+#define BENCH_HAVE_X86_SIMD 0
+#endif
+
+namespace bench_core {
+
+namespace simd {
+
+namespace {
+
+inline bool is_special_byte(unsigned char c) { return c == '\\' || c < 0x20 || c >= 0x80; }
+
+size_t find_special_byte_scalar(const char* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        if (is_special_byte(static_cast<unsigned char>(data[i]))) {
+            return i;
+        }
+    }
+    return size;
+}
+
+#if BENCH_HAVE_X86_SIMD
+// Bytes >= 0x80 are negative as signed chars, so a single signed "< 0x20"
+// compare catches both control characters and UTF-8 lead/continuation bytes
+size_t find_special_byte_sse2(const char* data, size_t size) {
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i special =
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, backslash), _mm_cmplt_epi8(chunk, space));
+        auto mask = static_cast<unsigned int>(_mm_movemask_epi8(special));
+        if (mask != 0) {
+            return i + std::countr_zero(mask);
+        }
+    }
+    return i + find_special_byte_scalar(data + i, size - i);
+}
+
+#if defined(__GNUC__)
+__attribute__((target("avx2"))) size_t find_special_byte_avx2(const char* data, size_t size) {
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i space = _mm256_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, backslash),
+                                          _mm256_cmpgt_epi8(space, chunk));
+        auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(special));
+        if (mask != 0) {
+            return i + std::countr_zero(mask);
+        }
+    }
+    return i + find_special_byte_sse2(data + i, size - i);
+}
+#endif
+#endif
+
+}  // namespace
+
+size_t find_special_byte(const char* data, size_t size) {
+    using Finder = size_t (*)(const char*, size_t);
+    static const Finder finder = []() -> Finder {
+#if BENCH_HAVE_X86_SIMD && defined(__GNUC__)
+        if (__builtin_cpu_supports("avx2")) {
+            return find_special_byte_avx2;
+        }
+#endif
+#if BENCH_HAVE_X86_SIMD
+        return find_special_byte_sse2;
+#else
+        return find_special_byte_scalar;
+#endif
+    }();
+    return finder(data, size);
+}
+
+std::vector<FindSpecialByteImplementation> find_special_byte_implementations() {
+    std::vector<FindSpecialByteImplementation> implementations = {
+        {"scalar", find_special_byte_scalar}};
+#if BENCH_HAVE_X86_SIMD
+    implementations.push_back({"sse2", find_special_byte_sse2});
+#if defined(__GNUC__)
+    if (__builtin_cpu_supports("avx2")) {
+        implementations.push_back({"avx2", find_special_byte_avx2});
+    }
+#endif
+#endif
+    return implementations;
+}
+
+}  // namespace simd
+
+namespace {
+
+constexpr std::string_view kReplacementCharacter = "\xEF\xBF\xBD";
+
+void append_code_point(uint32_t code_point, std::string& out) {
+    if (code_point < 0x80) {
+        out.push_back(static_cast<char>(code_point));
+    } else if (code_point < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+}
+
+std::optional<uint32_t> parse_hex4(std::string_view hex) {
+    uint32_t value = 0;
+    for (char c : hex) {
+        value <<= 4;
+        if (c >= '0' && c <= '9') {
+            value |= static_cast<uint32_t>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            value |= static_cast<uint32_t>(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            value |= static_cast<uint32_t>(c - 'A' + 10);
+        } else {
+            return std::nullopt;
+        }
+    }
+    return value;
+}
+
+// Length of the valid UTF-8 sequence at data[0], 0 if invalid, or -1 if
+// the sequence is a valid prefix truncated by the end of the input
+int utf8_sequence_length(const unsigned char* data, size_t size) {
+    unsigned char lead = data[0];
+    int length = 0;
+    unsigned char min_second = 0x80;
+    unsigned char max_second = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        min_second = lead == 0xE0 ? 0xA0 : 0x80;  // Overlong
+        max_second = lead == 0xED ? 0x9F : 0xBF;  // Surrogates
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        min_second = lead == 0xF0 ? 0x90 : 0x80;  // Overlong
+        max_second = lead == 0xF4 ? 0x8F : 0xBF;  // Above U+10FFFF
+    } else {
+        return 0;
+    }
+    for (int i = 1; i < length; ++i) {
+        if (static_cast<size_t>(i) >= size) {
+            return -1;
+        }
+        unsigned char lower = i == 1 ? min_second : 0x80;
+        unsigned char upper = i == 1 ? max_second : 0xBF;
+        if (data[i] < lower || data[i] > upper) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+}  // namespace
+
+void JsonStringDecoder::decode(std::string_view escaped, std::string& out) {
+    if (!pending_.empty()) {
+        // Rare: finish the split sequence using a joined copy of the input
+        std::string joined = std::move(pending_);
+        pending_.clear();
+        joined.append(escaped);
+        decode_complete(joined, out);
+        return;
+    }
+    decode_complete(escaped, out);
+}
+
+void JsonStringDecoder::finish(std::string& out) {
+    if (high_surrogate_ != 0) {
+        replace_invalid(out);
+        high_surrogate_ = 0;
+    }
+    if (!pending_.empty()) {
+        replace_invalid(out);
+        pending_.clear();
+    }
+}
+
+void JsonStringDecoder::replace_invalid(std::string& out) {
+    out.append(kReplacementCharacter);
+    invalid_sequences_++;
+}
+
+void JsonStringDecoder::decode_complete(std::string_view input, std::string& out) {
+    const char* data = input.data();
+    const size_t size = input.size();
+    size_t pos = 0;
+    while (pos < size) {
+        // Copy the plain ASCII run up to the next special byte in bulk
+        size_t run = simd::find_special_byte(data + pos, size - pos);
+        if (run > 0) {
+            if (high_surrogate_ != 0) {
+                replace_invalid(out);
+                high_surrogate_ = 0;
+            }
+            out.append(data + pos, run);
+            pos += run;
+            if (pos == size) {
+                break;
+            }
+        }
+
+        auto c = static_cast<unsigned char>(data[pos]);
+        if (c == '\\') {
+            pos = decode_escape(input, pos, out);
+        } else if (c >= 0x80) {
+            if (high_surrogate_ != 0) {
+                replace_invalid(out);
+                high_surrogate_ = 0;
+            }
+            int length = utf8_sequence_length(reinterpret_cast<const unsigned char*>(data + pos),
+                                              size - pos);
+            if (length < 0) {
+                pending_.assign(data + pos, size - pos);
+                return;
+            }
+            if (length == 0) {
+                replace_invalid(out);
+                pos++;
+            } else {
+                out.append(data + pos, static_cast<size_t>(length));
+                pos += static_cast<size_t>(length);
+            }
+        } else {
+            // Raw control characters are not valid JSON, but are kept as-is
+            out.push_back(static_cast<char>(c));
+            pos++;
+        }
+    }
+}
+
+// Decode the escape at input[pos], returning the position after it
+size_t JsonStringDecoder::decode_escape(std::string_view input, size_t pos, std::string& out) {
+    if (pos + 1 >= input.size()) {
+        pending_.assign(input.substr(pos));
+        return input.size();
+    }
+    char kind = input[pos + 1];
+    if (kind != 'u') {
+        if (high_surrogate_ != 0) {
+            replace_invalid(out);
+            high_surrogate_ = 0;
+        }
+        switch (kind) {
+            case '"':
+            case '\\':
+            case '/':
+                out.push_back(kind);
+                break;
+            case 'b':
+                out.push_back('\b');
+                break;
+            case 'f':
+                out.push_back('\f');
+                break;
+            case 'n':
+                out.push_back('\n');
+                break;
+            case 'r':
+                out.push_back('\r');
+                break;
+            case 't':
+                out.push_back('\t');
+                break;
+            default:
+                replace_invalid(out);
+                break;
+        }
+        return pos + 2;
+    }
+
+    if (pos + 6 > input.size()) {
+        pending_.assign(input.substr(pos));
+        return input.size();
+    }
+    auto code_unit = parse_hex4(input.substr(pos + 2, 4));
+    if (!code_unit.has_value()) {
+        if (high_surrogate_ != 0) {
+            replace_invalid(out);
+            high_surrogate_ = 0;
+        }
+        replace_invalid(out);
+        return pos + 6;
+    }
+
+    uint32_t value = code_unit.value();
+    if (value >= 0xD800 && value <= 0xDBFF) {
+        // High surrogate; its low half may arrive in a later event
+        if (high_surrogate_ != 0) {
+            replace_invalid(out);
+        }
+        high_surrogate_ = value;
+    } else if (value >= 0xDC00 && value <= 0xDFFF) {
+        if (high_surrogate_ != 0) {
+            append_code_point(0x10000 + ((high_surrogate_ - 0xD800) << 10) + (value - 0xDC00),
+                              out);
+            high_surrogate_ = 0;
+        } else {
+            replace_invalid(out);
+        }
+    } else {
+        if (high_surrogate_ != 0) {
+            replace_invalid(out);
+            high_surrogate_ = 0;
+        }
+        append_code_point(value, out);
+    }
+    return pos + 6;
+}
+
+void JsonStreamValidator::feed(std::string_view text) {
+    if (state_ == State::kError) {
+        bytes_ += text.size();
+        return;
+    }
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (!step(static_cast<unsigned char>(text[i]))) {
+            state_ = State::kError;
+            error_offset_ = bytes_ + i;
+            break;
+        }
+    }
+    bytes_ += text.size();
+}
+
+void JsonStreamValidator::finish() {
+    if (state_ == State::kNumber && stack_.empty() && number_terminal()) {
+        state_ = State::kDone;
+    }
+}
+
+bool JsonStreamValidator::step(unsigned char c) {
+    bool whitespace = c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    switch (state_) {
+        case State::kString:
+            if (c == '"') {
+                if (in_key_) {
+                    state_ = State::kColon;
+                } else {
+                    after_value();
+                }
+                return true;
+            }
+            if (c == '\\') {
+                state_ = State::kEscape;
+                return true;
+            }
+            return c >= 0x20;
+        case State::kEscape:
+            if (c == 'u') {
+                state_ = State::kUnicode;
+                hex_left_ = 4;
+                return true;
+            }
+            state_ = State::kString;
+            return std::string_view("\"\\/bfnrt").find(static_cast<char>(c)) !=
+                   std::string_view::npos;
+        case State::kUnicode:
+            if (!std::isxdigit(c)) {
+                return false;
+            }
+            if (--hex_left_ == 0) {
+                state_ = State::kString;
+            }
+            return true;
+        case State::kNumber:
+            if (number_step(c)) {
+                return true;
+            }
+            if (!number_terminal()) {
+                return false;
+            }
+            // The byte ending the number belongs to what follows it
+            after_value();
+            return step(c);
+        case State::kLiteral:
+            if (c != static_cast<unsigned char>(literal_[literal_pos_])) {
+                return false;
+            }
+            if (literal_[++literal_pos_] == '\0') {
+                after_value();
+            }
+            return true;
+        case State::kValue:
+            return whitespace || begin_value(c);
+        case State::kValueOrClose:
+            return whitespace || (c == ']' ? close(c) : begin_value(c));
+        case State::kKeyOrClose:
+        case State::kKey:
+            if (whitespace) {
+                return true;
+            }
+            if (c == '}' && state_ == State::kKeyOrClose) {
+                return close(c);
+            }
+            if (c != '"') {
+                return false;
+            }
+            state_ = State::kString;
+            in_key_ = true;
+            return true;
+        case State::kColon:
+            if (c == ':') {
+                state_ = State::kValue;
+                return true;
+            }
+            return whitespace;
+        case State::kCommaOrClose:
+            if (c == ',') {
+                state_ = stack_.back() == '{' ? State::kKey : State::kValue;
+                return true;
+            }
+            return whitespace || close(c);
+        case State::kDone:
+            return whitespace;
+        case State::kError:
+            return false;
+    }
+    return false;
+}
+
+bool JsonStreamValidator::begin_value(unsigned char c) {
+    if (c == '{' || c == '[') {
+        stack_.push_back(static_cast<char>(c));
+        max_depth_ = std::max(max_depth_, stack_.size());
+        state_ = c == '{' ? State::kKeyOrClose : State::kValueOrClose;
+        return true;
+    }
+    if (c == '"') {
+        state_ = State::kString;
+        in_key_ = false;
+        return true;
+    }
+    if (c == '-' || (c >= '0' && c <= '9')) {
+        state_ = State::kNumber;
+        number_state_ = c == '-' ? NumberState::kMinus
+                                 : (c == '0' ? NumberState::kZero : NumberState::kInt);
+        return true;
+    }
+    if (c == 't' || c == 'f' || c == 'n') {
+        state_ = State::kLiteral;
+        literal_ = c == 't' ? "true" : (c == 'f' ? "false" : "null");
+        literal_pos_ = 1;
+        return true;
+    }
+    return false;
+}
+
+bool JsonStreamValidator::close(unsigned char c) {
+    if (stack_.empty() || c != (stack_.back() == '{' ? '}' : ']')) {
+        return false;
+    }
+    stack_.pop_back();
+    after_value();
+    return true;
+}
+
+bool JsonStreamValidator::number_step(unsigned char c) {
+    bool digit = c >= '0' && c <= '9';
+    bool exponent = c == 'e' || c == 'E';
+    switch (number_state_) {
+        case NumberState::kMinus:
+            if (!digit) {
+                return false;
+            }
+            number_state_ = c == '0' ? NumberState::kZero : NumberState::kInt;
+            return true;
+        case NumberState::kZero:
+        case NumberState::kInt:
+            if (digit && number_state_ == NumberState::kInt) {
+                return true;
+            }
+            if (c == '.') {
+                number_state_ = NumberState::kDot;
+                return true;
+            }
+            if (exponent) {
+                number_state_ = NumberState::kE;
+                return true;
+            }
+            return false;
+        case NumberState::kDot:
+        case NumberState::kFrac:
+            if (digit) {
+                number_state_ = NumberState::kFrac;
+                return true;
+            }
+            if (exponent && number_state_ == NumberState::kFrac) {
+                number_state_ = NumberState::kE;
+                return true;
+            }
+            return false;
+        case NumberState::kE:
+            if (c == '+' || c == '-') {
+                number_state_ = NumberState::kExpSign;
+                return true;
+            }
+            [[fallthrough]];
+        case NumberState::kExpSign:
+        case NumberState::kExp:
+            if (digit) {
+                number_state_ = NumberState::kExp;
+                return true;
+            }
+            return false;
+    }
+    return false;
+}
+
+bool JsonStreamValidator::number_terminal() const {
+    return number_state_ == NumberState::kZero || number_state_ == NumberState::kInt ||
+           number_state_ == NumberState::kFrac || number_state_ == NumberState::kExp;
+}
+
+void JsonStreamValidator::after_value() {
+    state_ = stack_.empty() ? State::kDone : State::kCommaOrClose;
+}
+
+namespace {
+
+// Recursive-descent scanner over the raw chunk bytes
+class StreamChunkScanner {
+public:
+    explicit StreamChunkScanner(std::string_view json) : json_(json) {}
+
+    bool scan(StreamChunkView& view) {
+        view.choices.clear();
+        view.usage = {};
+        view.time_info = {};
+        if (!consume('{')) {
+            return false;
+        }
+        if (consume('}')) {
+            return at_end();
+        }
+        do {
+            std::string_view key;
+            if (!parse_string(key) || !consume(':')) {
+                return false;
+            }
+            bool ok = true;
+            if (key == "choices") {
+                ok = parse_choices(view);
+            } else if (key == "usage") {
+                ok = value_span(view.usage);
+            } else if (key == "time_info") {
+                ok = value_span(view.time_info);
+            } else {
+                ok = skip_value();
+            }
+            if (!ok) {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}') && at_end();
+    }
+
+private:
+    void skip_whitespace() {
+        while (pos_ < json_.size() && (json_[pos_] == ' ' || json_[pos_] == '\t' ||
+                                       json_[pos_] == '\r' || json_[pos_] == '\n')) {
+            pos_++;
+        }
+    }
+
+    bool consume(char c) {
+        skip_whitespace();
+        if (pos_ < json_.size() && json_[pos_] == c) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    bool at_end() {
+        skip_whitespace();
+        return pos_ == json_.size();
+    }
+
+    bool consume_null() {
+        skip_whitespace();
+        if (json_.substr(pos_, 4) == "null") {
+            pos_ += 4;
+            return true;
+        }
+        return false;
+    }
+
+    // Locate a string and return its still-escaped contents
+    bool parse_string(std::string_view& raw) {
+        if (!consume('"')) {
+            return false;
+        }
+        size_t begin = pos_;
+        while (true) {
+            pos_ = json_.find_first_of("\"\\", pos_);
+            if (pos_ == std::string_view::npos) {
+                return false;
+            }
+            if (json_[pos_] == '"') {
+                raw = json_.substr(begin, pos_ - begin);
+                pos_++;
+                return true;
+            }
+            pos_ += 2;
+        }
+    }
+
+    bool parse_size(size_t& value) {
+        skip_whitespace();
+        auto [end, error] =
+            std::from_chars(json_.data() + pos_, json_.data() + json_.size(), value);
+        if (error != std::errc()) {
+            return false;
+        }
+        pos_ = static_cast<size_t>(end - json_.data());
+        return true;
+    }
+
+    bool parse_optional_string(std::optional<std::string_view>& value) {
+        if (consume_null()) {
+            value.reset();
+            return true;
+        }
+        std::string_view raw;
+        if (!parse_string(raw)) {
+            return false;
+        }
+        value = raw;
+        return true;
+    }
+
+    bool parse_choices(StreamChunkView& view) {
+        if (consume_null()) {
+            return true;
+        }
+        if (!consume('[')) {
+            return false;
+        }
+        if (consume(']')) {
+            return true;
+        }
+        do {
+            if (!parse_choice(view.choices.emplace_back())) {
+                return false;
+            }
+        } while (consume(','));
+        return consume(']');
+    }
+
+    bool parse_choice(StreamChunkView::Choice& choice) {
+        if (!consume('{')) {
+            return false;
+        }
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            std::string_view key;
+            if (!parse_string(key) || !consume(':')) {
+                return false;
+            }
+            bool ok = true;
+            if (key == "index") {
+                ok = parse_size(choice.index);
+            } else if (key == "delta") {
+                ok = parse_delta(choice);
+            } else if (key == "text") {
+                ok = parse_optional_string(choice.content);
+            } else if (key == "finish_reason") {
+                ok = parse_optional_string(choice.finish_reason);
+            } else {
+                ok = skip_value();
+            }
+            if (!ok) {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}');
+    }
+
+    bool parse_delta(StreamChunkView::Choice& choice) {
+        if (!consume('{')) {
+            return false;
+        }
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            std::string_view key;
+            if (!parse_string(key) || !consume(':')) {
+                return false;
+            }
+            bool ok = true;
+            if (key == "content") {
+                ok = parse_optional_string(choice.content);
+            } else if (key == "tool_calls") {
+                ok = parse_tool_calls(choice.tool_calls);
+            } else {
+                ok = skip_value();
+            }
+            if (!ok) {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}');
+    }
+
+    bool parse_tool_calls(std::vector<StreamChunkView::ToolCallDelta>& tool_calls) {
+        if (consume_null()) {
+            return true;
+        }
+        if (!consume('[')) {
+            return false;
+        }
+        if (consume(']')) {
+            return true;
+        }
+        do {
+            if (!parse_tool_call(tool_calls.emplace_back())) {
+                return false;
+            }
+        } while (consume(','));
+        return consume(']');
+    }
+
+    bool parse_tool_call(StreamChunkView::ToolCallDelta& tool_call) {
+        if (!consume('{')) {
+            return false;
+        }
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            std::string_view key;
+            if (!parse_string(key) || !consume(':')) {
+                return false;
+            }
+            bool ok = true;
+            if (key == "index") {
+                ok = parse_size(tool_call.index);
+            } else if (key == "id") {
+                ok = parse_optional_string(tool_call.id);
+            } else if (key == "function") {
+                ok = parse_function(tool_call);
+            } else {
+                ok = skip_value();
+            }
+            if (!ok) {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}');
+    }
+
+    bool parse_function(StreamChunkView::ToolCallDelta& tool_call) {
+        if (!consume('{')) {
+            return false;
+        }
+        if (consume('}')) {
+            return true;
+        }
+        do {
+            std::string_view key;
+            if (!parse_string(key) || !consume(':')) {
+                return false;
+            }
+            bool ok = true;
+            if (key == "name") {
+                ok = parse_optional_string(tool_call.name);
+            } else if (key == "arguments") {
+                ok = parse_optional_string(tool_call.arguments);
+            } else {
+                ok = skip_value();
+            }
+            if (!ok) {
+                return false;
+            }
+        } while (consume(','));
+        return consume('}');
+    }
+
+    bool value_span(std::string_view& span) {
+        skip_whitespace();
+        size_t begin = pos_;
+        if (!skip_value()) {
+            return false;
+        }
+        span = json_.substr(begin, pos_ - begin);
+        return true;
+    }
+
+    bool skip_value() {
+        skip_whitespace();
+        if (pos_ >= json_.size()) {
+            return false;
+        }
+        char c = json_[pos_];
+        if (c == '"') {
+            std::string_view ignored;
+            return parse_string(ignored);
+        }
+        if (c == '{' || c == '[') {
+            char close = c == '{' ? '}' : ']';
+            pos_++;
+            if (consume(close)) {
+                return true;
+            }
+            do {
+                if (c == '{') {
+                    std::string_view ignored;
+                    if (!parse_string(ignored) || !consume(':')) {
+                        return false;
+                    }
+                }
+                if (!skip_value()) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(close);
+        }
+        // Numbers and literals; anything else sends the chunk to the full parser
+        // so corrupted streams are still reported as parse errors
+        size_t begin = pos_;
+        while (pos_ < json_.size() && json_[pos_] != ',' && json_[pos_] != '}' &&
+               json_[pos_] != ']' && json_[pos_] != ' ' && json_[pos_] != '\n' &&
+               json_[pos_] != '\r' && json_[pos_] != '\t') {
+            pos_++;
+        }
+        auto token = json_.substr(begin, pos_ - begin);
+        return token == "true" || token == "false" || token == "null" || is_number(token);
+    }
+
+    // JSON number grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    static bool is_number(std::string_view token) {
+        size_t i = 0;
+        auto digits = [&token, &i]() {
+            size_t start = i;
+            while (i < token.size() && token[i] >= '0' && token[i] <= '9') {
+                i++;
+            }
+            return i - start;
+        };
+        if (i < token.size() && token[i] == '-') {
+            i++;
+        }
+        size_t int_start = i;
+        size_t int_digits = digits();
+        if (int_digits == 0 || (int_digits > 1 && token[int_start] == '0')) {
+            return false;
+        }
+        if (i < token.size() && token[i] == '.') {
+            i++;
+            if (digits() == 0) {
+                return false;
+            }
+        }
+        if (i < token.size() && (token[i] == 'e' || token[i] == 'E')) {
+            i++;
+            if (i < token.size() && (token[i] == '+' || token[i] == '-')) {
+                i++;
+            }
+            if (digits() == 0) {
+                return false;
+            }
+        }
+        return i == token.size();
+    }
+
+    std::string_view json_;
+    size_t pos_ = 0;
+};
+
+}  // namespace
+
+bool scan_stream_chunk(std::string_view json, StreamChunkView& view) {
+    return StreamChunkScanner(json).scan(view);
+}
+
+}  // namespace bench_core
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bench_core {
+
+// Streamed delta decoding. Every delta.content value is decoded straight from
+// the raw SSE payload into its destination instead of going through a JSON DOM.
+// Runs of plain ASCII are located with SSE2/AVX2 (scalar elsewhere) and copied
+// in bulk; escapes and multi-byte UTF-8 are handled by a small scalar state
+// machine that also validates the UTF-8.
+namespace simd {
+
+// Offset of the first byte that is a backslash, a control character or
+// non-ASCII, or size if there is none. The implementation is picked once.
+size_t find_special_byte(const char* data, size_t size);
+
+// Every implementation of find_special_byte this CPU supports, scalar first,
+// so tests can check each vector path against the scalar one
+struct FindSpecialByteImplementation {
+    const char* name;
+    size_t (*find)(const char* data, size_t size);
+};
+std::vector<FindSpecialByteImplementation> find_special_byte_implementations();
+
+}  // namespace simd
+
+// Incremental decoder for the escaped contents of JSON strings. State carries
+// over between calls, so an escape, a UTF-16 surrogate pair or a multi-byte
+// UTF-8 sequence may be split across SSE events. Malformed input never fails
+// the request; it is replaced with U+FFFD and counted.
+class JsonStringDecoder {
+public:
+    // Decode `escaped` (the bytes between the quotes) and append UTF-8 to out
+    void decode(std::string_view escaped, std::string& out);
+
+    // End of stream: anything still pending was truncated
+    void finish(std::string& out);
+
+    size_t invalid_sequences() const { return invalid_sequences_; }
+
+private:
+    void replace_invalid(std::string& out);
+    void decode_complete(std::string_view input, std::string& out);
+    size_t decode_escape(std::string_view input, size_t pos, std::string& out);
+
+    uint32_t high_surrogate_ = 0;
+    std::string pending_;
+    size_t invalid_sequences_ = 0;
+};
+
+// Incremental JSON syntax validator for decoded text that arrives in pieces,
+// such as structured output content or streamed tool-call arguments. Only the
+// stack of open containers is kept, so memory grows with nesting depth rather
+// than with the size of the document.
+class JsonStreamValidator {
+public:
+    void feed(std::string_view text);
+
+    // End of stream: a top-level number is only terminated here
+    void finish();
+
+    // No syntax error so far
+    bool valid() const { return state_ != State::kError; }
+    // Exactly one complete value, optionally surrounded by whitespace
+    bool complete() const { return state_ == State::kDone; }
+    size_t bytes() const { return bytes_; }
+    size_t max_depth() const { return max_depth_; }
+    // Offset of the first offending byte, meaningful once !valid()
+    size_t error_offset() const { return error_offset_; }
+
+private:
+    enum class State : uint8_t {
+        kValue,
+        kValueOrClose,
+        kKeyOrClose,
+        kKey,
+        kColon,
+        kCommaOrClose,
+        kString,
+        kEscape,
+        kUnicode,
+        kNumber,
+        kLiteral,
+        kDone,
+        kError
+    };
+    enum class NumberState : uint8_t { kMinus, kZero, kInt, kDot, kFrac, kE, kExpSign, kExp };
+
+    bool step(unsigned char c);
+    bool begin_value(unsigned char c);
+    bool close(unsigned char c);
+    bool number_step(unsigned char c);
+    bool number_terminal() const;
+    void after_value();
+
+    State state_ = State::kValue;
+    NumberState number_state_ = NumberState::kInt;
+    // Open containers, '{' or '['
+    std::string stack_;
+    bool in_key_ = false;
+    const char* literal_ = "";
+    size_t literal_pos_ = 0;
+    int hex_left_ = 0;
+    size_t bytes_ = 0;
+    size_t max_depth_ = 0;
+    size_t error_offset_ = 0;
+};
+
+// Raw view of one streamed chunk, located without building a JSON DOM. String
+// values are left escaped for JsonStringDecoder; usage and time_info are kept
+// as spans since they only appear in the final chunk.
+struct StreamChunkView {
+    // One delta.tool_calls entry; id and name usually only come with the first
+    struct ToolCallDelta {
+        size_t index = 0;
+        std::optional<std::string_view> id;
+        std::optional<std::string_view> name;
+        std::optional<std::string_view> arguments;
+    };
+    struct Choice {
+        size_t index = 0;
+        std::optional<std::string_view> content;
+        std::optional<std::string_view> finish_reason;
+        std::vector<ToolCallDelta> tool_calls;
+    };
+    std::vector<Choice> choices;
+    std::string_view usage;
+    std::string_view time_info;
+};
+
+// Scan the chat/completions chunk shape into view. Returns false on anything
+// unexpected, in which case callers fall back to nlohmann::json.
+bool scan_stream_chunk(std::string_view json, StreamChunkView& view);
+
+}  // namespace bench_core
@@ -0,0 +1,210 @@
+#include "bench_core/trials.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace bench_core {
+
+namespace {
+
+// Metrics summarized across trials, in report order
+constexpr std::array<const char*, 11> kTrialMetrics = {
+    "requests_per_second",        "completion_tokens_per_second", "tokens_per_second",
+    "ttft_p50_seconds",           "ttft_p90_seconds",             "ttft_p99_seconds",
+    "itl_p50_seconds",            "itl_p99_seconds",              "total_duration_p50_seconds",
+    "total_duration_p99_seconds", "total_number_failures"};
+
+// Two-sided normal and Student's t critical values, t for 1 to 30 degrees of
+// freedom
+struct CriticalValues {
+    double confidence;
+    double z;
+    std::array<double, 30> t;
+};
+
+constexpr std::array<CriticalValues, 3> kCriticalValues = {{
+    {0.90, 1.644854, {6.314, 2.920, 2.353, 2.132, 2.015, 1.943, 1.895, 1.860, 1.833, 1.812,
+                      1.796, 1.782, 1.771, 1.761, 1.753, 1.746, 1.740, 1.734, 1.729, 1.725,
+                      1.721, 1.717, 1.714, 1.711, 1.708, 1.706, 1.703, 1.701, 1.699, 1.697}},
+    {0.95, 1.959964, {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                      2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                      2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042}},
+    {0.99, 2.575829, {63.657, 9.925, 5.841, 4.604, 4.032, 3.707, 3.499, 3.355, 3.250, 3.169,
+                      3.106,  3.055, 3.012, 2.977, 2.947, 2.921, 2.898, 2.878, 2.861, 2.845,
+                      2.831,  2.819, 2.807, 2.797, 2.787, 2.779, 2.771, 2.763, 2.756, 2.750}},
+}};
+
+const CriticalValues& critical_values(double confidence) {
+    for (const auto& values : kCriticalValues) {
+        if (std::abs(confidence - values.confidence) < 1e-9) {
+            return values;
+        }
+    }
+    throw std::invalid_argument("Confidence level must be 0.9, 0.95 or 0.99");
+}
+
+double median(std::vector<double> values) { return percentile(std::move(values), 50); }
+
+}  // namespace
+
+double z_critical(double confidence) { return critical_values(confidence).z; }
+
+double t_critical(double confidence, size_t degrees_of_freedom) {
+    const auto& values = critical_values(confidence);
+    if (degrees_of_freedom <= values.t.size()) {
+        return values.t[degrees_of_freedom - 1];
+    }
+    // Cornish-Fisher expansion, accurate to 1e-3 beyond 30 degrees of freedom
+    double z = values.z;
+    double df = static_cast<double>(degrees_of_freedom);
+    double z3 = z * z * z;
+    double z5 = z3 * z * z;
+    return z + (z3 + z) / (4 * df) + (5 * z5 + 16 * z3 + 3 * z) / (96 * df * df);
+}
+
+nlohmann::json summarize_trial(const Stats& stats) {
+    auto overall = stats.first.to_json();
+    std::vector<double> ttfts;
+    std::vector<double> durations;
+    std::vector<double> itls;
+    for (const auto& completion_stats : stats.second) {
+        if (!completion_stats.success) {
+            continue;
+        }
+        if (auto ttft = completion_stats.get_ttft_duration(); ttft.has_value()) {
+            ttfts.push_back(ttft.value());
+        }
+        if (auto duration = completion_stats.get_total_duration(); duration.has_value()) {
+            durations.push_back(duration.value());
+        }
+        for (const auto& choice_stats : completion_stats.choices) {
+            const auto& times = choice_stats.chunk_times;
+            for (size_t i = 1; i < times.size(); ++i) {
+                itls.push_back(seconds_between(times[i - 1], times[i]).value_or(0.0));
+            }
+        }
+    }
+    return {{"total_duration_seconds", overall["total_duration_seconds"]},
+            {"total_number_requests", overall["total_number_requests"]},
+            {"total_number_failures", overall["total_number_failures"]},
+            {"requests_per_second", overall["requests_per_second"]},
+            {"completion_tokens_per_second", overall["completion_tokens_per_second"]},
+            {"tokens_per_second", overall["tokens_per_second"]},
+            {"ttft_p50_seconds", percentile(ttfts, 50)},
+            {"ttft_p90_seconds", percentile(ttfts, 90)},
+            {"ttft_p99_seconds", percentile(ttfts, 99)},
+            {"itl_p50_seconds", percentile(itls, 50)},
+            {"itl_p99_seconds", percentile(itls, 99)},
+            {"total_duration_p50_seconds", percentile(durations, 50)},
+            {"total_duration_p99_seconds", percentile(durations, 99)}};
+}
+
+nlohmann::json summarize_trials(const std::vector<nlohmann::json>& trials, double confidence) {
+    nlohmann::json metrics = nlohmann::json::object();
+    std::map<size_t, std::vector<std::string>> outliers;
+    size_t n = trials.size();
+    for (const char* metric : kTrialMetrics) {
+        std::vector<double> values;
+        for (const auto& trial : trials) {
+            values.push_back(trial.value(metric, 0.0));
+        }
+        if (values.empty()) {
+            continue;
+        }
+
+        double mean = 0.0;
+        for (double value : values) {
+            mean += value;
+        }
+        mean /= static_cast<double>(n);
+        double variance = 0.0;
+        for (double value : values) {
+            variance += (value - mean) * (value - mean);
+        }
+        double stddev = n > 1 ? std::sqrt(variance / static_cast<double>(n - 1)) : 0.0;
+        double half_width =
+            n > 1 ? t_critical(confidence, n - 1) * stddev / std::sqrt(static_cast<double>(n))
+                  : 0.0;
+
+        nlohmann::json metric_json = {
+            {"mean", mean},
+            {"stddev", stddev},
+            {"ci_low", mean - half_width},
+            {"ci_high", mean + half_width},
+            {"ci_relative_half_width", mean != 0.0 ? half_width / std::abs(mean) : 0.0},
+            {"min", *std::min_element(values.begin(), values.end())},
+            {"max", *std::max_element(values.begin(), values.end())}};
+        metrics[metric] = metric_json;
+
+        // Median/MAD is robust to the outlier itself, unlike mean/stddev
+        if (n >= 3) {
+            double center = median(values);
+            std::vector<double> deviations;
+            for (double value : values) {
+                deviations.push_back(std::abs(value - center));
+            }
+            double mad = median(deviations);
+            for (size_t i = 0; i < n && mad > 0; ++i) {
+                if (0.6745 * std::abs(values[i] - center) / mad > 3.5) {
+                    outliers[i].emplace_back(metric);
+                }
+            }
+        }
+    }
+
+    nlohmann::json outlier_json = nlohmann::json::array();
+    for (const auto& [trial, outlier_metrics] : outliers) {
+        outlier_json.push_back({{"trial", trial}, {"metrics", outlier_metrics}});
+    }
+    return {{"trials", n},
+            {"confidence", confidence},
+            {"metrics", metrics},
+            {"outlier_trials", outlier_json}};
+}
+
+TrialsResult run_trials(Engine& engine, const std::vector<nlohmann::json>& requests,
+                        const TrialConfig& config) {
+    // Fail before the first trial rather than after the last
+    t_critical(config.confidence, 1);
+
+    TrialsResult result;
+    std::vector<nlohmann::json> summaries;
+    // Shuffling replaces the engine's ordering only for the trials
+    OrderingPolicy original_ordering = engine.config().ordering;
+    unsigned int original_seed = engine.ordering_seed();
+    for (size_t trial = 0; trial < config.trials; ++trial) {
+        if (trial > 0 && config.cooldown_seconds > 0) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(config.cooldown_seconds));
+        }
+        if (config.shuffle) {
+            engine.set_ordering(OrderingPolicy::kRandom,
+                                engine.config().seed + static_cast<unsigned int>(trial));
+        }
+        std::cout << "[INFO] Trial " + std::to_string(trial + 1) + " of " +
+                         std::to_string(config.trials)
+                  << '\n';
+        Stats stats = engine.run(requests);
+        auto summary = summarize_trial(stats);
+        summary["trial"] = trial;
+        summaries.push_back(std::move(summary));
+        result.last = std::move(stats);
+    }
+    if (config.shuffle) {
+        engine.set_ordering(original_ordering, original_seed);
+    }
+
+    result.report = {{"cooldown_seconds", config.cooldown_seconds},
+                     {"shuffle", config.shuffle},
+                     {"per_trial", summaries},
+                     {"summary", summarize_trials(summaries, config.confidence)}};
+    return result;
+}
+
+}  // namespace bench_core
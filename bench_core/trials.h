@@ -0,0 +1,47 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "bench_core/engine.h"
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// Repeated trials of one workload, so throughput and latency are reported
+// with their run-to-run spread instead of as a single sample
+struct TrialConfig {
+    size_t trials = 1;
+    // Idle time between trials, letting server-side queues and caches settle
+    double cooldown_seconds = 0.0;
+    // Shuffle the dispatch order of every trial with a different seed
+    bool shuffle = false;
+    // Two-sided confidence level of the reported intervals: 0.9, 0.95 or 0.99
+    double confidence = 0.95;
+};
+
+struct TrialsResult {
+    // Full results of the last trial
+    Stats last;
+    nlohmann::json report;
+};
+
+// Two-sided critical values of the normal and Student's t distributions for
+// confidence 0.9, 0.95 or 0.99; throw std::invalid_argument for other levels
+double z_critical(double confidence);
+double t_critical(double confidence, size_t degrees_of_freedom);
+
+// Run the workload config.trials times on engine. The report keeps every
+// trial's summary and gives mean, standard deviation and a Student's t
+// confidence interval of the mean for each metric, with outlier trials flagged.
+TrialsResult run_trials(Engine& engine, const std::vector<nlohmann::json>& requests,
+                        const TrialConfig& config);
+
+// Throughput and latency percentiles of one run
+nlohmann::json summarize_trial(const Stats& stats);
+
+// Statistics over the trial summaries. A trial is an outlier in a metric when
+// its modified z-score (median and MAD based) exceeds 3.5.
+nlohmann::json summarize_trials(const std::vector<nlohmann::json>& trials, double confidence);
+
+}  // namespace bench_core
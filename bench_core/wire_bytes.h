@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <nlohmann/json.hpp>
+#include <string>
+
+namespace bench_core {
+
+// Bytes a request put on the wire in each direction, curl transport only.
+// Response bodies are counted as received (still compressed, without the
+// chunked transfer framing) and again after content decoding, which is what
+// the SSE parser sees.
+struct WireBytes {
+    // Request line and headers, and the body
+    size_t request_header_bytes = 0;
+    size_t request_body_bytes = 0;
+    // Status line and headers, and the body as received
+    size_t response_header_bytes = 0;
+    size_t response_body_bytes = 0;
+    // Body after content decoding
+    size_t decoded_body_bytes = 0;
+    // Accept-Encoding sent (empty = none) and Content-Encoding received
+    std::string accept_encoding;
+    std::string content_encoding;
+
+    bool recorded() const { return request_header_bytes > 0; }
+
+    size_t request_bytes() const { return request_header_bytes + request_body_bytes; }
+    size_t response_bytes() const { return response_header_bytes + response_body_bytes; }
+
+    // content_bytes is the decoded text (and tool-call arguments) carried by
+    // the SSE events; everything else in the decoded body is SSE framing
+    nlohmann::json to_json(size_t content_bytes, size_t completion_tokens) const {
+        nlohmann::json wire_json = {{"request_bytes", request_bytes()},
+                                    {"response_bytes", response_bytes()},
+                                    {"response_header_bytes", response_header_bytes},
+                                    {"response_body_bytes", response_body_bytes},
+                                    {"decoded_body_bytes", decoded_body_bytes},
+                                    {"accept_encoding", accept_encoding},
+                                    {"content_encoding", content_encoding}};
+        if (response_body_bytes > 0) {
+            wire_json["compression_ratio"] = static_cast<double>(decoded_body_bytes) /
+                                             static_cast<double>(response_body_bytes);
+        }
+        if (content_bytes > 0 && decoded_body_bytes >= content_bytes) {
+            wire_json["sse_framing_bytes"] = decoded_body_bytes - content_bytes;
+        }
+        if (completion_tokens > 0) {
+            wire_json["response_bytes_per_output_token"] =
+                static_cast<double>(response_bytes()) / static_cast<double>(completion_tokens);
+            wire_json["decoded_bytes_per_output_token"] =
+                static_cast<double>(decoded_body_bytes) / static_cast<double>(completion_tokens);
+        }
+        return wire_json;
+    }
+};
+
+}  // namespace bench_core
@@ -0,0 +1,573 @@
+#include "bench_core/workflow.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+namespace bench_core {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::string_view kOpen = "{{";
+constexpr std::string_view kClose = "}}";
+
+std::string trim(const std::string& value) {
+    size_t first = value.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return "";
+    }
+    size_t last = value.find_last_not_of(" \t");
+    return value.substr(first, last - first + 1);
+}
+
+// Expand the placeholders of text; resolve returns the value of one
+template <typename Resolver>
+std::string render(const std::string& text, const Resolver& resolve) {
+    std::string rendered;
+    size_t position = 0;
+    while (position < text.size()) {
+        size_t open = text.find(kOpen, position);
+        if (open == std::string::npos) {
+            break;
+        }
+        size_t close = text.find(kClose, open + kOpen.size());
+        if (close == std::string::npos) {
+            throw std::invalid_argument("Unterminated placeholder in: " + text);
+        }
+        rendered.append(text, position, open - position);
+        rendered += resolve(trim(text.substr(open + kOpen.size(), close - open - kOpen.size())));
+        position = close + kClose.size();
+    }
+    rendered.append(text, position, std::string::npos);
+    return rendered;
+}
+
+// Apply render to every string in a JSON value
+template <typename Resolver>
+nlohmann::json render_json(const nlohmann::json& value, const Resolver& resolve) {
+    if (value.is_string()) {
+        return render(value.get<std::string>(), resolve);
+    }
+    if (value.is_object() || value.is_array()) {
+        nlohmann::json rendered = value;
+        for (auto& item : rendered) {
+            item = render_json(item, resolve);
+        }
+        return rendered;
+    }
+    return value;
+}
+
+struct Placeholder {
+    enum class Kind { kInput, kStepOutput, kSession };
+    Kind kind = Kind::kSession;
+    std::string name;
+};
+
+Placeholder parse_placeholder(const std::string& expression) {
+    if (expression == "session") {
+        return {Placeholder::Kind::kSession, ""};
+    }
+    if (expression.starts_with("input.") && expression.size() > 6) {
+        return {Placeholder::Kind::kInput, expression.substr(6)};
+    }
+    const std::string suffix = ".output";
+    if (expression.starts_with("steps.") && expression.ends_with(suffix) &&
+        expression.size() > 6 + suffix.size()) {
+        return {Placeholder::Kind::kStepOutput,
+                expression.substr(6, expression.size() - 6 - suffix.size())};
+    }
+    throw std::invalid_argument("Unknown workflow placeholder: {{" + expression + "}}");
+}
+
+struct StepRun {
+    std::optional<CompletionStats> stats;
+    std::string output;
+    Clock::time_point ready_time;
+    bool finished = false;
+    bool succeeded = false;
+};
+
+struct SessionRun {
+    std::vector<StepRun> steps;
+    Clock::time_point start_time;
+    Clock::time_point end_time;
+};
+
+// Threads running the steps of one session worker. They outlive the sessions,
+// so each keeps its libcurl handle, and with it its connection, across steps
+// the way the engine's workers do.
+class StepPool {
+public:
+    explicit StepPool(size_t threads) {
+        for (size_t i = 0; i < threads; ++i) {
+            threads_.emplace_back([this] { work(); });
+        }
+    }
+
+    ~StepPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        cv_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    StepPool(const StepPool&) = delete;
+    StepPool& operator=(const StepPool&) = delete;
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+private:
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this] { return stopped_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            auto task = std::move(tasks_.front());
+            tasks_.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopped_ = false;
+    std::vector<std::thread> threads_;
+};
+
+// Issue every step of one session on the pool once its dependencies have
+// succeeded, and skip those after a failure. Steps go through the engine's
+// planned, rate-limited path and reach its sinks as request session * steps +
+// step.
+void run_session(Engine& engine, const WorkflowDefinition& definition,
+                 const nlohmann::json& input, size_t session, StepPool& pool, SessionRun& run) {
+    const auto& steps = definition.steps;
+    run.steps.assign(steps.size(), StepRun{});
+    run.start_time = Clock::now();
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t completed = 0;
+    std::vector<char> launched(steps.size(), 0);
+
+    auto execute_step = [&](size_t i) {
+        auto resolve = [&](const std::string& expression) -> std::string {
+            auto placeholder = parse_placeholder(expression);
+            switch (placeholder.kind) {
+                case Placeholder::Kind::kSession:
+                    return std::to_string(session);
+                case Placeholder::Kind::kInput: {
+                    if (!input.contains(placeholder.name)) {
+                        return "";
+                    }
+                    const auto& field = input[placeholder.name];
+                    return field.is_string() ? field.get<std::string>() : field.dump();
+                }
+                case Placeholder::Kind::kStepOutput:
+                    for (size_t j = 0; j < steps.size(); ++j) {
+                        if (steps[j].id == placeholder.name) {
+                            return run.steps[j].output;
+                        }
+                    }
+                    return "";
+            }
+            return "";
+        };
+        auto completion_stats =
+            engine.dispatch(render_json(steps[i].request, resolve), session * steps.size() + i);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& step_run = run.steps[i];
+        step_run.succeeded = completion_stats.success;
+        // Choices are sorted by index, so this is choice 0 rather than the first to stream
+        if (!completion_stats.choices.empty()) {
+            step_run.output = completion_stats.choices.front().output_text;
+        }
+        step_run.stats = std::move(completion_stats);
+        step_run.finished = true;
+        completed++;
+        cv.notify_all();
+    };
+
+    std::unique_lock<std::mutex> lock(mutex);
+    size_t skipped = 0;
+    for (;;) {
+        // Launch or skip every step whose dependencies have all finished;
+        // skipping can unblock further steps, so repeat until nothing changes
+        bool progressed = true;
+        while (progressed) {
+            progressed = false;
+            for (size_t i = 0; i < steps.size(); ++i) {
+                if (launched[i] != 0) {
+                    continue;
+                }
+                bool ready = true;
+                bool dependencies_succeeded = true;
+                for (size_t dependency : steps[i].depends_on) {
+                    ready = ready && run.steps[dependency].finished;
+                    dependencies_succeeded =
+                        dependencies_succeeded && run.steps[dependency].succeeded;
+                }
+                if (!ready) {
+                    continue;
+                }
+                launched[i] = 1;
+                progressed = true;
+                if (!dependencies_succeeded) {
+                    run.steps[i].finished = true;
+                    skipped++;
+                    continue;
+                }
+                run.steps[i].ready_time = Clock::now();
+                pool.submit([&execute_step, i] { execute_step(i); });
+            }
+        }
+        if (skipped + completed == steps.size()) {
+            break;
+        }
+        size_t seen = completed;
+        cv.wait(lock, [&] { return completed > seen; });
+    }
+    run.end_time = Clock::now();
+}
+
+nlohmann::json distribution(const std::vector<double>& values) {
+    double mean = 0.0;
+    for (double value : values) {
+        mean += value / static_cast<double>(values.size());
+    }
+    return {{"count", values.size()},
+            {"mean", mean},
+            {"p50", percentile(values, 50)},
+            {"p90", percentile(values, 90)},
+            {"p99", percentile(values, 99)},
+            {"max", percentile(values, 100)}};
+}
+
+// Steps that gated the end of a session: from the step that finished last,
+// repeatedly follow the dependency that finished last
+std::vector<size_t> critical_path(const WorkflowDefinition& definition, const SessionRun& run) {
+    auto end_of = [&](size_t i) { return run.steps[i].stats->end_time; };
+    std::optional<size_t> current;
+    for (size_t i = 0; i < run.steps.size(); ++i) {
+        if (run.steps[i].stats.has_value() && (!current || end_of(i) > end_of(*current))) {
+            current = i;
+        }
+    }
+    std::vector<size_t> path;
+    while (current.has_value()) {
+        path.push_back(*current);
+        std::optional<size_t> gate;
+        for (size_t dependency : definition.steps[*current].depends_on) {
+            if (run.steps[dependency].stats.has_value() &&
+                (!gate || end_of(dependency) > end_of(*gate))) {
+                gate = dependency;
+            }
+        }
+        current = gate;
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+}  // namespace
+
+WorkflowDefinition parse_workflow(const nlohmann::json& definition) {
+    if (!definition.is_object() || !definition.contains("steps") ||
+        !definition["steps"].is_array() || definition["steps"].empty()) {
+        throw std::invalid_argument("Workflow needs a non-empty \"steps\" array");
+    }
+    WorkflowDefinition workflow;
+    workflow.name = definition.value("name", "workflow");
+
+    std::map<std::string, size_t> indices;
+    for (const auto& step_json : definition["steps"]) {
+        if (!step_json.is_object() || !step_json.contains("id") || !step_json["id"].is_string() ||
+            !step_json.contains("request") || !step_json["request"].is_object()) {
+            throw std::invalid_argument("Workflow steps need a string \"id\" and a \"request\"");
+        }
+        WorkflowStep step;
+        step.id = step_json["id"].get<std::string>();
+        step.request = step_json["request"];
+        if (!indices.emplace(step.id, workflow.steps.size()).second) {
+            throw std::invalid_argument("Duplicate workflow step: " + step.id);
+        }
+        workflow.steps.push_back(std::move(step));
+    }
+    size_t i = 0;
+    for (const auto& step_json : definition["steps"]) {
+        for (const auto& dependency : step_json.value("depends_on", nlohmann::json::array())) {
+            auto it = dependency.is_string() ? indices.find(dependency.get<std::string>())
+                                             : indices.end();
+            if (it == indices.end()) {
+                throw std::invalid_argument("Unknown dependency of workflow step " +
+                                            workflow.steps[i].id + ": " + dependency.dump());
+            }
+            workflow.steps[i].depends_on.push_back(it->second);
+        }
+        i++;
+    }
+
+    // Kahn's algorithm; steps left with unresolved dependencies form a cycle
+    std::vector<size_t> pending(workflow.steps.size());
+    std::vector<std::vector<size_t>> dependents(workflow.steps.size());
+    std::vector<size_t> ready;
+    for (size_t step = 0; step < workflow.steps.size(); ++step) {
+        pending[step] = workflow.steps[step].depends_on.size();
+        for (size_t dependency : workflow.steps[step].depends_on) {
+            dependents[dependency].push_back(step);
+        }
+        if (pending[step] == 0) {
+            ready.push_back(step);
+        }
+    }
+    std::vector<size_t> topological;
+    while (!ready.empty()) {
+        size_t step = ready.back();
+        ready.pop_back();
+        topological.push_back(step);
+        for (size_t dependent : dependents[step]) {
+            if (--pending[dependent] == 0) {
+                ready.push_back(dependent);
+            }
+        }
+    }
+    if (topological.size() != workflow.steps.size()) {
+        throw std::invalid_argument("Workflow steps form a cycle");
+    }
+
+    // Ancestors in topological order, to check which outputs a step may read
+    std::vector<std::vector<char>> ancestors(workflow.steps.size(),
+                                             std::vector<char>(workflow.steps.size(), 0));
+    for (size_t step : topological) {
+        for (size_t dependency : workflow.steps[step].depends_on) {
+            ancestors[step][dependency] = 1;
+            for (size_t k = 0; k < workflow.steps.size(); ++k) {
+                ancestors[step][k] = ancestors[step][k] | ancestors[dependency][k];
+            }
+        }
+    }
+    for (size_t step = 0; step < workflow.steps.size(); ++step) {
+        auto& current = workflow.steps[step];
+        render_json(current.request, [&](const std::string& expression) -> std::string {
+            auto placeholder = parse_placeholder(expression);
+            if (placeholder.kind == Placeholder::Kind::kStepOutput) {
+                auto it = indices.find(placeholder.name);
+                if (it == indices.end() || ancestors[step][it->second] == 0) {
+                    throw std::invalid_argument("Workflow step " + current.id +
+                                                " reads the output of " + placeholder.name +
+                                                ", which is not one of its dependencies");
+                }
+                current.uses_outputs = true;
+            }
+            return "";
+        });
+    }
+    return workflow;
+}
+
+WorkflowDefinition load_workflow(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open workflow file: " + filename);
+    }
+    nlohmann::json definition;
+    try {
+        file >> definition;
+    } catch (const nlohmann::json::parse_error& e) {
+        throw std::invalid_argument("Invalid workflow JSON in " + filename + ": " + e.what());
+    }
+    return parse_workflow(definition);
+}
+
+WorkflowResult run_workflows(Engine& engine, const std::vector<nlohmann::json>& inputs,
+                             const WorkflowConfig& config) {
+    const auto& definition = config.definition;
+    if (inputs.empty() || !config.enabled()) {
+        throw std::invalid_argument("Workflow runs need a workflow and input requests");
+    }
+    bool uses_outputs = std::any_of(definition.steps.begin(), definition.steps.end(),
+                                    [](const WorkflowStep& step) { return step.uses_outputs; });
+    if (uses_outputs && engine.config().text_policy != TextPolicy::kFull) {
+        throw std::invalid_argument("Workflow templates read step outputs, which needs "
+                                    "--output_text_policy full");
+    }
+
+    size_t sessions = config.sessions > 0 ? config.sessions : inputs.size();
+    std::vector<SessionRun> runs(sessions);
+    std::atomic<size_t> next_session{0};
+    engine.begin_run(sessions * definition.steps.size());
+    auto start_time = Clock::now();
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < std::max<size_t>(1, config.concurrent_sessions); ++i) {
+        workers.emplace_back([&]() {
+            // One thread per step covers the widest possible set of ready steps
+            StepPool pool(definition.steps.size());
+            for (size_t session = next_session.fetch_add(1); session < sessions;
+                 session = next_session.fetch_add(1)) {
+                run_session(engine, definition, inputs[session % inputs.size()], session, pool,
+                            runs[session]);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto end_time = Clock::now();
+
+    const size_t step_count = definition.steps.size();
+    WorkflowResult result;
+    std::vector<double> end_to_end;
+    std::vector<std::vector<double>> latencies(step_count);
+    std::vector<std::vector<double>> ttfts(step_count);
+    std::vector<std::vector<double>> start_delays(step_count);
+    std::vector<size_t> failures(step_count, 0);
+    std::vector<size_t> skipped(step_count, 0);
+    std::vector<size_t> on_critical_path(step_count, 0);
+    std::vector<double> critical_share(step_count, 0.0);
+    std::map<std::vector<size_t>, size_t> paths;
+    std::vector<double> critical_path_gaps;
+    size_t failed_sessions = 0;
+    nlohmann::json per_session = nlohmann::json::array();
+
+    for (size_t session = 0; session < sessions; ++session) {
+        auto& run = runs[session];
+        double session_seconds =
+            std::chrono::duration<double>(run.end_time - run.start_time).count();
+        auto path = critical_path(definition, run);
+        double path_seconds = 0.0;
+        std::vector<double> path_latencies;
+        for (size_t step : path) {
+            path_latencies.push_back(run.steps[step].stats->get_total_duration().value_or(0.0));
+            path_seconds += path_latencies.back();
+        }
+
+        bool succeeded = true;
+        nlohmann::json completion_indices = nlohmann::json::object();
+        for (size_t i = 0; i < step_count; ++i) {
+            auto& step_run = run.steps[i];
+            if (!step_run.stats.has_value()) {
+                skipped[i]++;
+                succeeded = false;
+                continue;
+            }
+            if (!step_run.succeeded) {
+                failures[i]++;
+                succeeded = false;
+            }
+            const auto& completion_stats = *step_run.stats;
+            if (auto latency = completion_stats.get_total_duration(); latency.has_value()) {
+                latencies[i].push_back(latency.value());
+            }
+            if (auto ttft = completion_stats.get_ttft_duration(); ttft.has_value()) {
+                ttfts[i].push_back(ttft.value());
+            }
+            start_delays[i].push_back(
+                seconds_between(step_run.ready_time, completion_stats.start_time).value_or(0.0));
+            completion_indices[definition.steps[i].id] = result.stats.second.size();
+            result.stats.second.push_back(std::move(*step_run.stats));
+        }
+
+        nlohmann::json path_ids = nlohmann::json::array();
+        for (size_t step : path) {
+            path_ids.push_back(definition.steps[step].id);
+        }
+        per_session.push_back({{"session", session},
+                               {"success", succeeded},
+                               {"end_to_end_seconds", session_seconds},
+                               {"critical_path", path_ids},
+                               {"completion_indices", completion_indices}});
+        if (!succeeded) {
+            failed_sessions++;
+            continue;
+        }
+
+        end_to_end.push_back(session_seconds);
+        paths[path]++;
+        for (size_t k = 0; k < path.size(); ++k) {
+            on_critical_path[path[k]]++;
+            critical_share[path[k]] += session_seconds > 0 ? path_latencies[k] / session_seconds
+                                                           : 0.0;
+        }
+        critical_path_gaps.push_back(std::max(0.0, session_seconds - path_seconds));
+    }
+
+    double successful = static_cast<double>(std::max<size_t>(1, end_to_end.size()));
+    nlohmann::json steps_json = nlohmann::json::object();
+    for (size_t i = 0; i < step_count; ++i) {
+        nlohmann::json depends_on = nlohmann::json::array();
+        for (size_t dependency : definition.steps[i].depends_on) {
+            depends_on.push_back(definition.steps[dependency].id);
+        }
+        steps_json[definition.steps[i].id] = {
+            {"depends_on", depends_on},
+            {"latency_seconds", distribution(latencies[i])},
+            {"ttft_seconds", distribution(ttfts[i])},
+            {"start_delay_seconds", distribution(start_delays[i])},
+            {"failures", failures[i]},
+            {"skipped", skipped[i]},
+            {"critical_path_fraction", on_critical_path[i] / successful},
+            {"mean_critical_path_share", critical_share[i] / successful}};
+    }
+
+    std::vector<std::pair<size_t, std::vector<size_t>>> ranked_paths;
+    for (const auto& [path, count] : paths) {
+        ranked_paths.emplace_back(count, path);
+    }
+    std::stable_sort(ranked_paths.begin(), ranked_paths.end(),
+                     [](const auto& a, const auto& b) { return a.first > b.first; });
+    nlohmann::json paths_json = nlohmann::json::array();
+    for (const auto& [count, path] : ranked_paths) {
+        nlohmann::json path_ids = nlohmann::json::array();
+        for (size_t step : path) {
+            path_ids.push_back(definition.steps[step].id);
+        }
+        paths_json.push_back(
+            {{"path", path_ids}, {"sessions", count}, {"fraction", count / successful}});
+    }
+
+    result.stats.first = aggregate_stats(result.stats.second);
+    result.stats.first.start_time = start_time;
+    result.stats.first.end_time = end_time;
+    double run_seconds = std::chrono::duration<double>(end_time - start_time).count();
+    result.report = {
+        {"name", definition.name},
+        {"sessions", sessions},
+        {"failed_sessions", failed_sessions},
+        {"concurrent_sessions", config.concurrent_sessions},
+        {"sessions_per_second", run_seconds > 0 ? end_to_end.size() / run_seconds : 0.0},
+        {"end_to_end_seconds", distribution(end_to_end)},
+        {"critical_path_gap_seconds", distribution(critical_path_gaps)},
+        {"steps", steps_json},
+        {"critical_paths", paths_json},
+        {"per_session", per_session}};
+    engine.finish_run(result.stats);
+    return result;
+}
+
+}  // namespace bench_core
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "bench_core/engine.h"
+#include "bench_core/stats.h"
+
+namespace bench_core {
+
+// Agentic workflows: every session runs a DAG of dependent requests, issuing
+// each step as soon as the steps it depends on have finished, so parallel
+// branches overlap. String values of a step's request are templates:
+//   {{input.FIELD}}     field of the session's input request
+//   {{steps.ID.output}} generated text of an earlier step ID (an ancestor)
+//   {{session}}         session number
+struct WorkflowStep {
+    std::string id;
+    // Indices of the steps this one waits for
+    std::vector<size_t> depends_on;
+    nlohmann::json request;
+    // Whether the request templates read step outputs
+    bool uses_outputs = false;
+};
+
+struct WorkflowDefinition {
+    std::string name;
+    std::vector<WorkflowStep> steps;
+};
+
+// Parse {"name": ..., "steps": [{"id", "depends_on": [...], "request": {...}}]}.
+// Throws std::invalid_argument on duplicate or unknown step ids, cycles, and
+// placeholders that are malformed or read a step that is not an ancestor.
+WorkflowDefinition parse_workflow(const nlohmann::json& definition);
+
+WorkflowDefinition load_workflow(const std::string& filename);
+
+struct WorkflowConfig {
+    WorkflowDefinition definition;
+    // Sessions to run, 0 = one per input request; inputs are used round-robin
+    size_t sessions = 0;
+    size_t concurrent_sessions = 1;
+
+    bool enabled() const { return !definition.steps.empty(); }
+};
+
+struct WorkflowResult {
+    // Every executed step, by session and then step order
+    Stats stats;
+    nlohmann::json report;
+};
+
+// Run the sessions on engine. The report gives end-to-end and per-step
+// latency distributions, each step's start delay after becoming ready, and
+// critical-path analysis: the chain of steps that gated each session's end,
+// how often each step lies on it and its share of the end-to-end latency.
+// Steps after a failed dependency are skipped and fail their session. Steps
+// are dispatched like run() requests (rate limiter, simulations, sinks and
+// live counters) from threads kept per concurrent session, so connections are
+// reused across steps and sessions.
+WorkflowResult run_workflows(Engine& engine, const std::vector<nlohmann::json>& inputs,
+                             const WorkflowConfig& config);
+
+}  // namespace bench_core
@@ -1,53 +1,329 @@
-#include <atomic>
 #include <boost/program_options.hpp>
-#include <chrono>
+#include <charconv>
+#include <condition_variable>
 #include <cstdlib>
-#include <fstream>
-#include <future>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <nlohmann/json.hpp>
-#include <queue>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
 
-#include "liboai.h"
+#include "bench_core/convergence.h"
+#include "bench_core/embeddings.h"
+#include "bench_core/engine.h"
+#include "bench_core/interference.h"
+#include "bench_core/log.h"
+#include "bench_core/requests.h"
+#include "bench_core/rerun.h"
+#include "bench_core/shm_ring.h"
+#include "bench_core/sink.h"
+#include "bench_core/structured_output.h"
+#include "bench_core/trials.h"
+#include "bench_core/workflow.h"
+
+using namespace bench_core;
 
 // Command line argument structure
 struct CommandLineConfig {
-    std::string api_key;
+    EngineConfig engine;
     std::string input_file;
     std::string output_file = "benchmark_results.json";
-    std::string api_endpoint = "https://api.cerebras.ai/v1";
-    std::string model = "llama-3.3-70b";
-    int concurrent_requests = 10;
+    std::string ndjson_output_file;
+    double progress_interval_seconds = 0.0;
+    std::string shm_ring;
+    size_t shm_ring_slots = 4096;
+    double shm_snapshot_interval_seconds = 1.0;
+    LogConfig log;
+    std::vector<size_t> embedding_batch_sizes{1};
+    std::string embedding_text_length;
+    unsigned int seed = 42;
+    std::string rerun_from;
+    std::string rerun_filter = "failed";
+    std::string interference_file;
+    InterferenceConfig interference;
+    TrialConfig trials;
+    ConvergenceConfig convergence;
+    std::string workflow_file;
+    WorkflowConfig workflow;
+    bool structured_baselines = false;
 };
 
+// Parse a comma separated list of positive integers, e.g. "1,8,32"
+std::vector<size_t> parse_size_list(const std::string& value) {
+    std::vector<size_t> sizes;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        size_t size = 0;
+        auto [end, error] = std::from_chars(item.data(), item.data() + item.size(), size);
+        if (error != std::errc() || end != item.data() + item.size()) {
+            throw std::invalid_argument("Invalid list value '" + item + "' in: " + value);
+        }
+        if (size == 0) {
+            throw std::invalid_argument("List values must be positive: " + value);
+        }
+        sizes.push_back(size);
+    }
+    if (sizes.empty()) {
+        throw std::invalid_argument("Empty list: " + value);
+    }
+    return sizes;
+}
+
 // Simple command line argument parser using boost::program_options
 CommandLineConfig parse_arguments(int argc, char* argv[]) {
     namespace po = boost::program_options;
 
     CommandLineConfig config;
+    auto& engine = config.engine;
+    std::string text_policy;
+    std::string mode;
+    std::string transport;
+    std::string capture_headers;
+    std::string request_order;
+    std::string order_by;
+    size_t abort_after_tokens = 0;
+    std::string ramp;
+    double slow_reader_pause_ms = 0.0;
+    bool tcp_nodelay = false;
+    std::string pin_addresses;
+    double abort_after_ms = 0.0;
+    std::string embedding_batch_sizes;
+    std::string converge;
+    std::string tail_attribution;
+    double burst_gap_ms = 1.0;
 
     try {
         po::options_description desc("Throughput Test Options");
         desc.add_options()("help,h", "Show this help message")(
-            "api_key", po::value<std::string>(&config.api_key),
+            "api_key", po::value<std::string>(&engine.api_key),
             "API key for Cerebras authentication (required)")(
             "api_endpoint",
-            po::value<std::string>(&config.api_endpoint)
+            po::value<std::string>(&engine.api_endpoint)
                 ->default_value("https://api.cerebras.ai/v1"),
             "API endpoint URL")(
-            "model", po::value<std::string>(&config.model)->default_value("llama-3.3-70b"),
+            "model", po::value<std::string>(&engine.model)->default_value("llama-3.3-70b"),
             "Model to use for completions")(
             "input_file", po::value<std::string>(&config.input_file),
             "Path to JSONL file containing completion requests (required)")(
-            "concurrent_requests", po::value<int>(&config.concurrent_requests)->default_value(10),
+            "concurrent_requests", po::value<int>(&engine.concurrent_requests)->default_value(10),
             "Number of concurrent requests")(
             "output_file",
             po::value<std::string>(&config.output_file)->default_value("throughput_stats.json"),
-            "Path to output JSON stats file");
+            "Path to output JSON stats file")(
+            "ndjson_output_file", po::value<std::string>(&config.ndjson_output_file),
+            "Also stream one JSON line per finished request to this file")(
+            "progress_interval_seconds",
+            po::value<double>(&config.progress_interval_seconds)->default_value(0.0),
+            "Print live metrics every N seconds while running (0 = off)")(
+            "shm_ring", po::value<std::string>(&config.shm_ring),
+            "Publish live results to this POSIX shared-memory ring, e.g. bench_results")(
+            "shm_ring_slots", po::value<size_t>(&config.shm_ring_slots)->default_value(4096),
+            "Number of 128-byte slots in the shared-memory ring")(
+            "shm_snapshot_interval_seconds",
+            po::value<double>(&config.shm_snapshot_interval_seconds)->default_value(1.0),
+            "Publish an aggregate snapshot to the ring every N seconds (0 = off)")(
+            "log_file", po::value<std::string>(&config.log.file),
+            "Write error and warning messages to this file instead of stderr")(
+            "log_json", po::bool_switch(&config.log.json_lines),
+            "Write log messages as JSON lines")(
+            "log_rate_limit",
+            po::value<double>(&config.log.max_messages_per_second)->default_value(10.0),
+            "Messages per second written for each message class; the rest are counted "
+            "(0 = unlimited)")(
+            "output_text_policy", po::value<std::string>(&text_policy)->default_value("full"),
+            "How generated text is kept per choice: full, hash or none")(
+            "mode", po::value<std::string>(&mode)->default_value("completions"),
+            "Endpoint to benchmark: completions or embeddings")(
+            "transport", po::value<std::string>(&transport)->default_value("liboai"),
+            "HTTP client for completions: liboai or curl")(
+            "capture_headers", po::value<std::string>(&capture_headers),
+            "Comma separated response headers to record, '*' suffix allowed, e.g. "
+            "x-request-id,x-ratelimit-* (selects the curl transport)")(
+            "embedding_batch_sizes",
+            po::value<std::string>(&embedding_batch_sizes)->default_value("1"),
+            "Comma separated input batch sizes for embeddings mode, e.g. 1,8,32")(
+            "embedding_text_length", po::value<std::string>(&config.embedding_text_length),
+            "Input length distribution in words for embeddings mode: fixed:N, "
+            "uniform:MIN:MAX or normal:MEAN:STDDEV (defaults to the input texts as-is)")(
+            "seed", po::value<unsigned int>(&config.seed)->default_value(42),
+            "Seed for randomized workload generation")(
+            "request_order", po::value<std::string>(&request_order)->default_value("fifo"),
+            "Dispatch order: fifo, shortest_first, longest_first, interleaved or random")(
+            "order_by", po::value<std::string>(&order_by)->default_value("prompt_length"),
+            "Length ranked by --request_order: prompt_length or output_length")(
+            "ramp", po::value<std::string>(&ramp)->default_value("none"),
+            "Worker start-up: none, linear, step or rate")(
+            "ramp_seconds", po::value<double>(&engine.ramp.duration_seconds)->default_value(10.0),
+            "Duration of a linear ramp")(
+            "ramp_step_workers", po::value<size_t>(&engine.ramp.step_workers)->default_value(1),
+            "Workers added per step of a step ramp")(
+            "ramp_step_seconds", po::value<double>(&engine.ramp.step_seconds)->default_value(1.0),
+            "Seconds between steps of a step ramp")(
+            "ramp_rate", po::value<double>(&engine.ramp.rate_per_second)->default_value(1.0),
+            "New workers (connections) per second for a rate ramp")(
+            "pipeline", po::bool_switch(&engine.pipeline.enabled),
+            "Run requests through scheduler, transport and aggregator stages connected by "
+            "lock-free queues, reporting per-stage metrics")(
+            "pipeline_scheduler_threads",
+            po::value<size_t>(&engine.pipeline.scheduler_threads)->default_value(1),
+            "Scheduler stage threads (transport threads = --concurrent_requests)")(
+            "pipeline_aggregator_threads",
+            po::value<size_t>(&engine.pipeline.aggregator_threads)->default_value(1),
+            "Aggregator stage threads")(
+            "pipeline_queue_capacity",
+            po::value<size_t>(&engine.pipeline.queue_capacity)->default_value(0),
+            "Capacity of each queue between stages (0 = 2 x --concurrent_requests)")(
+            "steady_state", po::bool_switch(&engine.steady_state.enabled),
+            "Detect the warmup transient (MSER-5) and report steady-state metrics")(
+            "steady_state_interval_seconds",
+            po::value<double>(&engine.steady_state.interval_seconds)->default_value(0.0),
+            "Interval width of the steady-state series (0 = run duration / 100)")(
+            "tail_attribution", po::value<std::string>(&tail_attribution)->default_value("none"),
+            "Rank request features by how much they explain the tail of this metric: "
+            "none, ttft or latency")(
+            "tail_percentile",
+            po::value<double>(&engine.tail_attribution.percentile)->default_value(99.0),
+            "Percentile of the metric from which requests count as tail")(
+            "chunk_analytics", po::bool_switch(&engine.chunk_granularity.enabled),
+            "Report tokens per chunk, chunk sizes, inter-chunk gaps and SSE events per read, "
+            "and detect coalesced streaming")(
+            "burst_gap_ms", po::value<double>(&burst_gap_ms)->default_value(1.0),
+            "Chunks closer than this to the previous one form one burst")(
+            "structured_baselines", po::bool_switch(&config.structured_baselines),
+            "Follow every request with response_format or tools by the same request without "
+            "them, as its free-form baseline")(
+            "slow_reader_fraction",
+            po::value<double>(&engine.slow_readers.fraction)->default_value(0.0),
+            "Fraction of streams consumed slowly (selects the curl transport)")(
+            "slow_reader_bytes_per_second",
+            po::value<size_t>(&engine.slow_readers.http.max_receive_bytes_per_second)
+                ->default_value(0),
+            "Read rate limit for slow streams (0 = unlimited)")(
+            "slow_reader_pause_every_bytes",
+            po::value<size_t>(&engine.slow_readers.http.pause_every_bytes)->default_value(0),
+            "Pause slow streams after every N bytes read (0 = never)")(
+            "slow_reader_pause_ms", po::value<double>(&slow_reader_pause_ms)->default_value(0.0),
+            "Length of each slow-stream read pause")(
+            "slow_reader_receive_buffer_bytes",
+            po::value<size_t>(&engine.slow_readers.http.receive_buffer_bytes)->default_value(0),
+            "Socket receive buffer for slow streams (0 = system default)")(
+            "tcp_nodelay", po::value<bool>(&tcp_nodelay),
+            "Set TCP_NODELAY on/off (selects the curl transport; default: libcurl's choice)")(
+            "tcp_quickack", po::bool_switch(&engine.socket_options.tcp_quickack),
+            "Re-arm TCP_QUICKACK after every read to disable delayed ACKs")(
+            "so_rcvbuf",
+            po::value<size_t>(&engine.socket_options.receive_buffer_bytes)->default_value(0),
+            "SO_RCVBUF in bytes (0 = system default)")(
+            "so_sndbuf",
+            po::value<size_t>(&engine.socket_options.send_buffer_bytes)->default_value(0),
+            "SO_SNDBUF in bytes (0 = system default)")(
+            "so_busy_poll_us",
+            po::value<int>(&engine.socket_options.busy_poll_us)->default_value(0),
+            "SO_BUSY_POLL in microseconds (0 = off)")(
+            "tcp_congestion", po::value<std::string>(&engine.socket_options.congestion_control),
+            "TCP congestion control algorithm, e.g. cubic or bbr (default: system)")(
+            "resolve_once", po::bool_switch(&engine.addresses.resolve_once),
+            "Resolve the endpoint host once at startup (selects the curl transport)")(
+            "pin_addresses", po::value<std::string>(&pin_addresses),
+            "Comma-separated backend IPs to connect to instead of resolving the host")(
+            "spread_addresses", po::bool_switch(&engine.addresses.spread),
+            "Spread connections round-robin over all endpoint addresses")(
+            "accept_encoding", po::value<std::string>(&engine.compression.accept_encoding),
+            "Accept-Encoding for responses, e.g. gzip, br or zstd (selects the curl "
+            "transport)")(
+            "accept_encoding_fraction",
+            po::value<double>(&engine.compression.fraction)->default_value(1.0),
+            "Fraction of requests sending --accept_encoding; the rest are the uncompressed "
+            "baseline")(
+            "abort_fraction", po::value<double>(&engine.aborts.fraction)->default_value(0.0),
+            "Fraction of streams the client cancels mid-generation (0 = none)")(
+            "abort_after_tokens", po::value<size_t>(&abort_after_tokens),
+            "Cancel after this many streamed tokens (default: random point below max_tokens)")(
+            "abort_after_ms", po::value<double>(&abort_after_ms),
+            "Cancel this many milliseconds after the request was sent")(
+            "abort_impact_window_seconds",
+            po::value<double>(&engine.aborts.impact_window_seconds)->default_value(1.0),
+            "Window after each abort in which surviving streams' ITL is reported separately")(
+            "max_requests_per_minute",
+            po::value<double>(&engine.max_requests_per_minute)->default_value(0.0),
+            "Client-side request rate limit (0 = unlimited)")(
+            "max_prompt_tokens_per_minute",
+            po::value<double>(&engine.max_prompt_tokens_per_minute)->default_value(0.0),
+            "Client-side prompt token rate limit (0 = unlimited)")(
+            "max_completion_tokens_per_minute",
+            po::value<double>(&engine.max_completion_tokens_per_minute)->default_value(0.0),
+            "Client-side completion token rate limit, estimated from max_tokens (0 = unlimited)")(
+            "rate_limit_burst_seconds",
+            po::value<double>(&engine.rate_limit_burst_seconds)->default_value(1.0),
+            "Seconds of quota the rate limiter may spend in a single burst")(
+            "rerun_from", po::value<std::string>(&config.rerun_from),
+            "Previous results file (JSON or NDJSON) to re-issue selected requests from")(
+            "rerun_filter", po::value<std::string>(&config.rerun_filter)->default_value("failed"),
+            "Comma separated selection for --rerun_from: failed, timed_out, slowest:N, tag:NAME")(
+            "interference_file", po::value<std::string>(&config.interference_file),
+            "JSONL file of long-prompt requests to inject into a steady background of "
+            "--input_file streams (prefill/decode interference experiment)")(
+            "background_streams",
+            po::value<size_t>(&config.interference.background_streams)->default_value(8),
+            "Background streams kept in flight during the interference experiment")(
+            "injection_count", po::value<size_t>(&config.interference.injections)->default_value(5),
+            "Number of long-prompt injections")(
+            "injection_interval_seconds",
+            po::value<double>(&config.interference.injection_interval_seconds)
+                ->default_value(15.0),
+            "Seconds between injections, at least twice the interference window")(
+            "interference_warmup_seconds",
+            po::value<double>(&config.interference.warmup_seconds)->default_value(10.0),
+            "Background-only seconds before the first injection")(
+            "interference_window_seconds",
+            po::value<double>(&config.interference.window_seconds)->default_value(5.0),
+            "Seconds of background ITL analysed before and after each injection")(
+            "interference_bin_seconds",
+            po::value<double>(&config.interference.bin_seconds)->default_value(0.1),
+            "Bin width of the injection-aligned ITL profile")(
+            "trials", po::value<size_t>(&config.trials.trials)->default_value(1),
+            "Repeat the workload N times and report mean, stddev and confidence intervals")(
+            "trial_cooldown_seconds",
+            po::value<double>(&config.trials.cooldown_seconds)->default_value(0.0),
+            "Idle seconds between trials")(
+            "trial_shuffle", po::bool_switch(&config.trials.shuffle),
+            "Shuffle the request order of every trial with a different seed")(
+            "confidence", po::value<double>(&config.trials.confidence)->default_value(0.95),
+            "Confidence level of the trial intervals: 0.9, 0.95 or 0.99")(
+            "converge", po::value<std::string>(&converge),
+            "Keep issuing requests until these metrics converge, e.g. "
+            "ttft:p99,tokens_per_second:mean (sources: ttft, itl, latency, tokens_per_second)")(
+            "converge_relative_width",
+            po::value<double>(&config.convergence.target_relative_width)->default_value(0.05),
+            "Target confidence interval width relative to the estimate")(
+            "converge_confidence",
+            po::value<double>(&config.convergence.confidence)->default_value(0.95),
+            "Confidence level of the convergence intervals: 0.9, 0.95 or 0.99")(
+            "converge_min_requests",
+            po::value<size_t>(&config.convergence.min_requests)->default_value(100),
+            "Requests completed before convergence can be declared")(
+            "converge_max_requests",
+            po::value<size_t>(&config.convergence.max_requests)->default_value(10000),
+            "Request budget; the input file is cycled up to this many requests")(
+            "converge_max_seconds",
+            po::value<double>(&config.convergence.max_seconds)->default_value(0.0),
+            "Time budget in seconds (0 = none)")(
+            "converge_check_seconds",
+            po::value<double>(&config.convergence.check_interval_seconds)->default_value(1.0),
+            "Seconds between convergence checks")(
+            "workflow_file", po::value<std::string>(&config.workflow_file),
+            "JSON workflow DAG run once per session, with --input_file lines as session "
+            "inputs and --concurrent_requests sessions in flight")(
+            "workflow_sessions", po::value<size_t>(&config.workflow.sessions)->default_value(0),
+            "Workflow sessions to run (0 = one per input request)");
 
         po::variables_map vm;
         po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -59,17 +335,135 @@ CommandLineConfig parse_arguments(int argc, char* argv[]) {
             exit(0);
         }
 
-        if (config.api_key.empty()) {
+        if (engine.api_key.empty()) {
             std::cerr << "Error: API key is required. Please provide --api_key flag.\n";
             std::cerr << desc << "\n";
             exit(1);
         }
 
-        if (config.input_file.empty()) {
+        if (config.input_file.empty() && config.rerun_from.empty()) {
             std::cerr << "Error: Input file is required. Please provide --input_file flag.\n";
             std::cerr << desc << "\n";
             exit(1);
         }
+
+        engine.text_policy = parse_text_policy(text_policy);
+        engine.mode = parse_mode(mode);
+        engine.transport = parse_transport(transport);
+        engine.capture_headers = parse_header_patterns(capture_headers);
+        engine.ordering = parse_ordering_policy(request_order);
+        engine.ordering_key = parse_ordering_key(order_by);
+        engine.seed = config.seed;
+        engine.ramp.policy = parse_ramp_policy(ramp);
+        engine.tail_attribution.metric = parse_tail_metric(tail_attribution);
+        if (engine.tail_attribution.percentile <= 75 || engine.tail_attribution.percentile >= 100) {
+            throw std::invalid_argument("--tail_percentile must be between 75 and 100");
+        }
+        if (burst_gap_ms <= 0) {
+            throw std::invalid_argument("--burst_gap_ms must be positive");
+        }
+        engine.chunk_granularity.burst_gap_seconds = burst_gap_ms / 1000.0;
+        // Transport threads are the only consumers of the scheduled queue
+        if (engine.pipeline.enabled && engine.concurrent_requests <= 0) {
+            throw std::invalid_argument("--pipeline needs a positive --concurrent_requests");
+        }
+        if (vm.contains("abort_after_tokens") != 0u) {
+            engine.aborts.after_tokens = abort_after_tokens;
+        }
+        if (vm.contains("abort_after_ms") != 0u) {
+            engine.aborts.after_seconds = abort_after_ms / 1000.0;
+        }
+        if (engine.aborts.fraction < 0 || engine.aborts.fraction > 1) {
+            throw std::invalid_argument("--abort_fraction must be between 0 and 1");
+        }
+        if (engine.aborts.enabled() && engine.mode != Mode::kCompletions) {
+            throw std::invalid_argument("--abort_fraction needs completions mode");
+        }
+        if (!config.interference_file.empty() &&
+            (engine.mode != Mode::kCompletions || !config.rerun_from.empty())) {
+            throw std::invalid_argument(
+                "--interference_file needs completions mode and cannot be combined with "
+                "--rerun_from");
+        }
+        // Interference streams are scheduled outside the engine's run, so no
+        // sink or live counter sees them
+        if (!config.interference_file.empty() &&
+            (!config.shm_ring.empty() || !config.ndjson_output_file.empty() ||
+             config.progress_interval_seconds > 0)) {
+            throw std::invalid_argument(
+                "--interference_file cannot be combined with --shm_ring, --ndjson_output_file "
+                "or --progress_interval_seconds");
+        }
+        if (config.interference.bin_seconds <= 0 || config.interference.window_seconds <= 0) {
+            throw std::invalid_argument("Interference window and bin sizes must be positive");
+        }
+        // Each injection's baseline window must not overlap the previous spike window
+        if (config.interference.injections > 1 &&
+            config.interference.injection_interval_seconds <
+                2 * config.interference.window_seconds) {
+            throw std::invalid_argument(
+                "--injection_interval_seconds must be at least twice "
+                "--interference_window_seconds");
+        }
+        if (config.trials.trials == 0) {
+            throw std::invalid_argument("--trials must be at least 1");
+        }
+        if (config.trials.trials > 1 &&
+            (!config.interference_file.empty() || !config.rerun_from.empty())) {
+            throw std::invalid_argument(
+                "--trials cannot be combined with --interference_file or --rerun_from");
+        }
+        // Shuffled trials dispatch in random order, which would silently
+        // replace a length-based --request_order
+        if (config.trials.shuffle && engine.ordering != OrderingPolicy::kFifo &&
+            engine.ordering != OrderingPolicy::kRandom) {
+            throw std::invalid_argument(
+                "--trial_shuffle cannot be combined with --request_order other than fifo or "
+                "random");
+        }
+        config.convergence.metrics = parse_convergence_metrics(converge);
+        if (config.convergence.enabled() &&
+            (config.trials.trials > 1 || !config.interference_file.empty() ||
+             !config.rerun_from.empty())) {
+            throw std::invalid_argument(
+                "--converge cannot be combined with --trials, --interference_file or "
+                "--rerun_from");
+        }
+        if (config.convergence.check_interval_seconds <= 0) {
+            throw std::invalid_argument("--converge_check_seconds must be positive");
+        }
+        if (!config.workflow_file.empty() &&
+            (engine.mode != Mode::kCompletions || config.trials.trials > 1 ||
+             config.convergence.enabled() || !config.interference_file.empty() ||
+             !config.rerun_from.empty())) {
+            throw std::invalid_argument(
+                "--workflow_file needs completions mode and cannot be combined with --trials, "
+                "--converge, --interference_file or --rerun_from");
+        }
+        if (config.structured_baselines &&
+            (engine.mode != Mode::kCompletions || !config.workflow_file.empty())) {
+            throw std::invalid_argument(
+                "--structured_baselines needs completions mode and cannot be combined with "
+                "--workflow_file");
+        }
+        config.workflow.concurrent_sessions =
+            static_cast<size_t>(std::max(1, engine.concurrent_requests));
+        engine.slow_readers.http.pause_seconds = slow_reader_pause_ms / 1000.0;
+        if (vm.contains("tcp_nodelay") != 0u) {
+            engine.socket_options.tcp_nodelay = tcp_nodelay;
+        }
+        engine.addresses.pinned = parse_address_list(pin_addresses);
+        if (engine.compression.fraction <= 0 || engine.compression.fraction > 1) {
+            throw std::invalid_argument("--accept_encoding_fraction must be in (0, 1]");
+        }
+        // liboai exposes neither response headers nor the socket
+        if ((!engine.capture_headers.empty() || engine.slow_readers.enabled() ||
+             engine.socket_options.configured() || engine.addresses.enabled() ||
+             engine.compression.enabled()) &&
+            vm["transport"].defaulted()) {
+            engine.transport = Transport::kCurl;
+        }
+        config.embedding_batch_sizes = parse_size_list(embedding_batch_sizes);
     } catch (const std::exception& e) {
         std::cerr << "Error parsing command line arguments: " << e.what() << '\n';
         exit(1);
@@ -78,530 +472,262 @@ CommandLineConfig parse_arguments(int argc, char* argv[]) {
     return config;
 }
 
-// Load completion requests from JSONL file
-std::vector<nlohmann::json> load_requests_from_jsonl(const std::string& filename) {
-    std::vector<nlohmann::json> requests;
-    std::ifstream file(filename);
-
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open input file: " + filename);
+// Prefill/decode interference experiment: background streams from the input
+// file, long-prompt injections from --interference_file
+int run_interference_experiment(const CommandLineConfig& config, Engine& engine,
+                                const std::vector<nlohmann::json>& background_requests) {
+    auto injection_requests = load_requests_from_jsonl(config.interference_file);
+    if (injection_requests.empty()) {
+        std::cerr << "[ERROR] No valid requests found in interference file" << '\n';
+        return EXIT_FAILURE;
     }
 
-    std::string line;
-    int line_number = 0;
+    std::cout << "[INFO] Injecting " << config.interference.injections
+              << " long-prompt requests into " << config.interference.background_streams
+              << " background streams" << '\n';
+    auto result =
+        run_interference(engine, background_requests, injection_requests, config.interference);
 
-    while (std::getline(file, line)) {
-        line_number++;
-        if (line.empty()) {
-            continue;
-        }
-
-        try {
-            nlohmann::json request = nlohmann::json::parse(line);
-            requests.push_back(request);
-        } catch (const nlohmann::json::parse_error& e) {
-            std::cerr << "Warning: Failed to parse JSON on line " << line_number << ": " << e.what()
-                      << '\n';
-        }
-    }
+    nlohmann::json output_json = stats_to_json(result.background);
+    output_json["injections"] = stats_to_json(result.injections);
+    output_json["interference"] = result.report;
+    write_json_to_file(output_json, config.output_file);
 
-    file.close();
-    std::cout << "[INFO] Loaded " + std::to_string(requests.size()) + " requests from " + filename
-              << '\n';
-    return requests;
+    flush_logging();
+    std::cout << "[INFO] Done!" << '\n';
+    return EXIT_SUCCESS;
 }
 
-struct CompletionStats {
-    std::chrono::steady_clock::time_point start_time;
-    std::chrono::steady_clock::time_point ttft_time;
-    std::chrono::steady_clock::time_point end_time;
-    size_t number_of_chunks = 0;
-    nlohmann::json input;
-    std::string output_text;
-    bool success = true;
-    std::string error_message;
-
-    // Helper functions to calculate durations
-    std::optional<double> get_total_duration() const {
-        if (end_time.time_since_epoch().count() > 0 && start_time.time_since_epoch().count() > 0) {
-            auto duration =
-                std::chrono::duration_cast<std::chrono::duration<double>>(end_time - start_time);
-            return duration.count();
-        }
-        return std::nullopt;
-    }
-
-    std::optional<double> get_ttft_duration() const {
-        if (ttft_time.time_since_epoch().count() > 0 && start_time.time_since_epoch().count() > 0) {
-            auto duration =
-                std::chrono::duration_cast<std::chrono::duration<double>>(ttft_time - start_time);
-            return duration.count();
-        }
-        return std::nullopt;
+// Repeated trials: the report holds the last trial's results plus the
+// per-trial summaries and their confidence intervals
+int run_trial_experiment(const CommandLineConfig& config, Engine& engine,
+                         const std::vector<nlohmann::json>& requests) {
+    TrialsResult result;
+    try {
+        result = run_trials(engine, requests, config.trials);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << '\n';
+        return EXIT_FAILURE;
     }
 
-    // Helper functions to get timestamps in seconds since epoch
-    std::optional<double> get_start_time() const {
-        if (start_time.time_since_epoch().count() > 0) {
-            return std::chrono::duration_cast<std::chrono::duration<double>>(
-                       start_time.time_since_epoch())
-                .count();
-        }
-        return std::nullopt;
-    }
+    nlohmann::json output_json = stats_to_json(result.last);
+    output_json["trials"] = result.report;
+    write_json_to_file(output_json, config.output_file);
 
-    std::optional<double> get_ttft_time() const {
-        if (ttft_time.time_since_epoch().count() > 0) {
-            return std::chrono::duration_cast<std::chrono::duration<double>>(
-                       ttft_time.time_since_epoch())
-                .count();
-        }
-        return std::nullopt;
-    }
+    flush_logging();
+    std::cout << "[INFO] Done!" << '\n';
+    return EXIT_SUCCESS;
+}
 
-    std::optional<double> get_end_time() const {
-        if (end_time.time_since_epoch().count() > 0) {
-            return std::chrono::duration_cast<std::chrono::duration<double>>(
-                       end_time.time_since_epoch())
-                .count();
-        }
-        return std::nullopt;
+// Sequential stopping: the report holds the results of every issued request
+// plus the convergence history
+int run_convergence_experiment(const CommandLineConfig& config, Engine& engine,
+                               const std::vector<nlohmann::json>& requests) {
+    ConvergenceResult result;
+    try {
+        result = run_until_converged(engine, requests, config.convergence);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << '\n';
+        return EXIT_FAILURE;
     }
+    std::cout << "[INFO] Stopped after " + std::to_string(result.stats.second.size()) +
+                     " requests: " + result.report["stop_reason"].get<std::string>()
+              << '\n';
 
-    // Usage information from API
-    struct UsageDetails {
-        size_t prompt_tokens = 0;
-        size_t completion_tokens = 0;
-        size_t total_tokens = 0;
+    nlohmann::json output_json = stats_to_json(result.stats);
+    output_json["convergence"] = result.report;
+    write_json_to_file(output_json, config.output_file);
 
-        nlohmann::json to_json() const {
-            return {{"prompt_tokens", prompt_tokens},
-                    {"completion_tokens", completion_tokens},
-                    {"total_tokens", total_tokens}};
-        }
-    };
-    UsageDetails api_usage{};
+    flush_logging();
+    std::cout << "[INFO] Done!" << '\n';
+    return EXIT_SUCCESS;
+}
 
-    // Time information from API
-    struct TimeInfo {
-        double queue_time = 0.0;
-        double prompt_time = 0.0;
-        double completion_time = 0.0;
-        double total_time = 0.0;
-        long long created = 0;
+// Workflow sessions: the report holds every executed step plus the workflow
+// latency and critical-path analysis
+int run_workflow_experiment(const CommandLineConfig& config, Engine& engine,
+                            const std::vector<nlohmann::json>& inputs) {
+    WorkflowResult result;
+    try {
+        auto workflow = config.workflow;
+        workflow.definition = load_workflow(config.workflow_file);
+        std::cout << "[INFO] Running workflow '" + workflow.definition.name + "' (" +
+                         std::to_string(workflow.definition.steps.size()) + " steps)"
+                  << '\n';
+        result = run_workflows(engine, inputs, workflow);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
 
-        nlohmann::json to_json() const {
-            return {{"queue_time", queue_time},
-                    {"prompt_time", prompt_time},
-                    {"completion_time", completion_time},
-                    {"total_time", total_time},
-                    {"created", created}};
-        }
-    };
-    TimeInfo api_time_info{};
+    nlohmann::json output_json = stats_to_json(result.stats);
+    output_json["workflow"] = result.report;
+    write_json_to_file(output_json, config.output_file);
 
-    nlohmann::json to_json() const {
-        nlohmann::json completion_json;
-        completion_json["input"] = input;
-        completion_json["output_text"] = output_text;
-        completion_json["success"] = success;
-        completion_json["error_message"] = error_message;
+    flush_logging();
+    std::cout << "[INFO] Done!" << '\n';
+    return EXIT_SUCCESS;
+}
 
-        // Add duration information
-        auto total_duration = get_total_duration();
-        if (total_duration.has_value()) {
-            completion_json["total_duration_seconds"] = total_duration.value();
-        }
+// Publishes a live metrics snapshot every interval until stopped
+class ProgressReporter {
+public:
+    using Publisher = std::function<void(const MetricsSnapshot&)>;
 
-        auto ttft_duration = get_ttft_duration();
-        if (ttft_duration.has_value()) {
-            completion_json["ttft_duration_seconds"] = ttft_duration.value();
+    ProgressReporter(const Engine& engine, double interval_seconds, Publisher publish)
+        : engine_(engine), interval_(interval_seconds), publish_(std::move(publish)) {
+        if (interval_seconds > 0) {
+            thread_ = std::thread([this] { report_loop(); });
         }
+    }
 
-        completion_json["number_of_chunks"] = number_of_chunks;
-
-        // Add timestamp information in seconds since epoch
-        auto start_time_seconds = get_start_time();
-        if (start_time_seconds.has_value()) {
-            completion_json["start_time"] = start_time_seconds.value();
+    ~ProgressReporter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
         }
-
-        auto ttft_time_seconds = get_ttft_time();
-        if (ttft_time_seconds.has_value()) {
-            completion_json["ttft_time"] = ttft_time_seconds.value();
+        cv_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
         }
+    }
 
-        auto end_time_seconds = get_end_time();
-        if (end_time_seconds.has_value()) {
-            completion_json["end_time"] = end_time_seconds.value();
+private:
+    void report_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!cv_.wait_for(lock, interval_, [this] { return stopped_; })) {
+            publish_(engine_.snapshot());
         }
-
-        // Add API usage details
-        completion_json["api_usage"] = api_usage.to_json();
-
-        // Add API time info
-        completion_json["api_time_info"] = api_time_info.to_json();
-
-        return completion_json;
     }
+
+    const Engine& engine_;
+    std::chrono::duration<double> interval_;
+    Publisher publish_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopped_ = false;
+    std::thread thread_;
 };
 
-// Stats structure for overall performance metrics
-struct OverallStats {
-    std::chrono::steady_clock::time_point start_time;
-    std::chrono::steady_clock::time_point end_time;
-    size_t total_prompt_tokens = 0;
-    size_t total_completion_tokens = 0;
-    size_t total_tokens = 0;
-    size_t total_number_requests = 0;
-    size_t total_number_failures = 0;
-
-    // Helper functions to calculate durations
-    std::optional<double> get_total_duration() const {
-        if (end_time.time_since_epoch().count() > 0 && start_time.time_since_epoch().count() > 0) {
-            auto duration =
-                std::chrono::duration_cast<std::chrono::duration<double>>(end_time - start_time);
-            return duration.count();
-        }
-        return std::nullopt;
+int main(int argc, char* argv[]) {
+    // Parse command line arguments
+    const auto config = parse_arguments(argc, argv);
+    try {
+        configure_logging(config.log);
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << '\n';
+        return EXIT_FAILURE;
     }
 
-    // Helper functions to get timestamps in seconds since epoch
-    std::optional<double> get_start_time() const {
-        if (start_time.time_since_epoch().count() > 0) {
-            return std::chrono::duration_cast<std::chrono::duration<double>>(
-                       start_time.time_since_epoch())
-                .count();
+    // Load requests from JSONL file, or the selected requests of a previous run
+    std::vector<nlohmann::json> requests;
+    PreviousResults previous;
+    std::vector<size_t> rerun_indices;
+    if (!config.rerun_from.empty()) {
+        try {
+            previous = load_previous_results(config.rerun_from);
+            rerun_indices = select_rerun_indices(previous.completions, config.rerun_filter);
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] " << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+        for (size_t index : rerun_indices) {
+            requests.push_back(previous.completions[index]["input"]);
+        }
+        std::cout << "[INFO] Re-issuing " + std::to_string(requests.size()) + " of " +
+                         std::to_string(previous.completions.size()) + " requests from " +
+                         config.rerun_from
+                  << '\n';
+        if (requests.empty()) {
+            write_json_to_file(merge_rerun_results(previous, rerun_indices, {}, config.rerun_from,
+                                                   config.rerun_filter),
+                               config.output_file);
+            return EXIT_SUCCESS;
+        }
+    } else {
+        requests = load_requests_from_jsonl(config.input_file);
+        if (requests.empty()) {
+            std::cerr << "[ERROR] No valid requests found in input file" << '\n';
+            return EXIT_FAILURE;
         }
-        return std::nullopt;
     }
 
-    std::optional<double> get_end_time() const {
-        if (end_time.time_since_epoch().count() > 0) {
-            return std::chrono::duration_cast<std::chrono::duration<double>>(
-                       end_time.time_since_epoch())
-                .count();
+    // Rerun inputs are already batched embeddings requests
+    if (config.engine.mode == Mode::kEmbeddings && config.rerun_from.empty()) {
+        try {
+            requests = build_embedding_requests(requests, config.embedding_batch_sizes,
+                                                config.embedding_text_length, config.seed);
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] " << e.what() << '\n';
+            return EXIT_FAILURE;
         }
-        return std::nullopt;
     }
 
-    nlohmann::json to_json() const {
-        // Calculate duration from timestamps
-        auto total_duration = get_total_duration();
-        double total_duration_seconds = total_duration.value_or(0.0);
-
-        double requests_per_second =
-            total_duration_seconds > 0 ? total_number_requests / total_duration_seconds : 0.0;
-
-        nlohmann::json overall_json = {{"total_duration_seconds", total_duration_seconds},
-                                       {"total_prompt_tokens", total_prompt_tokens},
-                                       {"total_completion_tokens", total_completion_tokens},
-                                       {"total_tokens", total_tokens},
-                                       {"total_number_requests", total_number_requests},
-                                       {"total_number_failures", total_number_failures},
-                                       {"requests_per_second", requests_per_second}};
+    // Re-runs already hold the baselines of the original run
+    if (config.structured_baselines && config.rerun_from.empty()) {
+        requests = add_structured_baselines(requests);
+    }
 
-        // Add timestamp information in seconds since epoch
-        auto start_time_seconds = get_start_time();
-        if (start_time_seconds.has_value()) {
-            overall_json["start_time"] = start_time_seconds.value();
+    std::unique_ptr<Engine> engine;
+    std::shared_ptr<ShmRingSink> shm_ring;
+    try {
+        engine = std::make_unique<Engine>(config.engine);
+        if (!config.ndjson_output_file.empty()) {
+            engine->add_sink(std::make_shared<NdjsonFileSink>(config.ndjson_output_file));
         }
-
-        auto end_time_seconds = get_end_time();
-        if (end_time_seconds.has_value()) {
-            overall_json["end_time"] = end_time_seconds.value();
+        if (!config.shm_ring.empty()) {
+            shm_ring = std::make_shared<ShmRingSink>(config.shm_ring, config.shm_ring_slots);
+            engine->add_sink(shm_ring);
         }
-
-        return overall_json;
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << '\n';
+        return EXIT_FAILURE;
     }
-};
 
-CompletionStats do_completion(const nlohmann::json& request, const liboai::OpenAI& oai,
-                              const std::string& model) {
-    CompletionStats stats;
-    stats.start_time = std::chrono::steady_clock::now();
-    stats.input = request;
-
-    // Buffer to accumulate streaming data chunks
-    std::string data_buffer;
-
-    liboai::Completions::StreamCallback stream_callback =
-        [&stats, &data_buffer](std::string data, intptr_t userdata) -> bool {
-        // Log the raw data received
-        data_buffer += data;
-
-        // Process complete lines from the buffer
-        size_t pos = 0;
-        while ((pos = data_buffer.find('\n')) != std::string::npos) {
-            std::string line = data_buffer.substr(0, pos);
-            data_buffer.erase(0, pos + 1);
-
-            // Trim whitespace
-            line.erase(0, line.find_first_not_of(" \r\n"));
-            line.erase(line.find_last_not_of(" \r\n") + 1);
-
-            // Skip empty lines
-            if (line.empty()) {
-                continue;
+    Stats stats;
+    {
+        // Live snapshots cover the experiment runners too, which run for longest
+        ProgressReporter progress(*engine, config.progress_interval_seconds,
+                                  [](const MetricsSnapshot& snapshot) {
+                                      std::cout << "[PROGRESS] " << snapshot.to_json().dump()
+                                                << '\n';
+                                  });
+        ProgressReporter shm_snapshots(
+            *engine, shm_ring != nullptr ? config.shm_snapshot_interval_seconds : 0.0,
+            [&shm_ring](const MetricsSnapshot& snapshot) {
+                shm_ring->publish_snapshot(snapshot);
+            });
+        try {
+            if (!config.interference_file.empty()) {
+                return run_interference_experiment(config, *engine, requests);
             }
-
-            // Handle SSE format - check for data: prefix
-            if (line.starts_with("data:")) {
-                std::string json_data = line.substr(5);
-                // Trim whitespace after data: prefix
-                json_data.erase(0, json_data.find_first_not_of(' '));
-                json_data.erase(json_data.find_last_not_of(' ') + 1);
-
-                // Handle [DONE] message
-                if (json_data == "[DONE]") {
-                    stats.end_time = std::chrono::steady_clock::now();
-                    continue;
-                }
-
-                // Skip empty JSON data
-                if (json_data.empty()) {
-                    continue;
-                }
-
-                // Try to parse JSON and log any errors
-                nlohmann::json chunk;
-                try {
-                    chunk = nlohmann::json::parse(json_data);
-                } catch (const nlohmann::json::parse_error& e) {
-                    std::cerr << "[ERROR] JSON parse error: " + std::string(e.what()) << '\n';
-                    std::cerr << "[ERROR] Failed data: '" + json_data + "'" << '\n';
-                    stats.success = false;
-                    stats.error_message = e.what();
-                    return false;  // Stop streaming on parse error
-                }
-
-                // Extract content from delta or direct text
-                if (chunk.contains("choices") && !chunk["choices"].empty()) {
-                    auto& choice = chunk["choices"][0];
-
-                    // Handle streaming format with delta.content
-                    if (choice.contains("delta")) {
-                        auto& delta = choice["delta"];
-                        if (delta.contains("content") && !delta["content"].is_null()) {
-                            std::string content = delta["content"];
-                            stats.output_text += content;
-                        }
-                    }
-                    // Handle non-streaming format with direct text
-                    else if (choice.contains("text") && !choice["text"].is_null()) {
-                        std::string content = choice["text"];
-                        stats.output_text += content;
-                    }
-                }
-
-                // Record TTFT (Time To First Token) only if we have received actual content
-                if (stats.number_of_chunks == 0 && !stats.output_text.empty()) {
-                    stats.ttft_time = std::chrono::steady_clock::now();
-                }
-                stats.number_of_chunks++;
-
-                // Extract usage information from final chunk
-                if (chunk.contains("usage")) {
-                    stats.api_usage.prompt_tokens = chunk["usage"].value("prompt_tokens", 0);
-                    stats.api_usage.completion_tokens =
-                        chunk["usage"].value("completion_tokens", 0);
-                    stats.api_usage.total_tokens = chunk["usage"].value("total_tokens", 0);
-                }
-
-                // Extract time information from final chunk
-                if (chunk.contains("time_info")) {
-                    stats.api_time_info.queue_time = chunk["time_info"].value("queue_time", 0.0);
-                    stats.api_time_info.prompt_time = chunk["time_info"].value("prompt_time", 0.0);
-                    stats.api_time_info.completion_time =
-                        chunk["time_info"].value("completion_time", 0.0);
-                    stats.api_time_info.total_time = chunk["time_info"].value("total_time", 0.0);
-                    stats.api_time_info.created = chunk["time_info"].value("created", 0);
-                }
+            if (config.trials.trials > 1) {
+                return run_trial_experiment(config, *engine, requests);
             }
-            // Ignore other SSE event types (like event:, id:, retry:, etc.)
-        }
-
-        return true;
-    };
-
-    try {
-        bool is_streaming = request.value("stream", true);
-
-        liboai::Response response = oai.Completion->create(
-            model,
-            request.contains("prompt") ? std::make_optional(request["prompt"].get<std::string>())
-                                       : std::nullopt,
-            request.contains("suffix") ? std::make_optional(request["suffix"].get<std::string>())
-                                       : std::nullopt,
-            request.contains("max_tokens")
-                ? std::make_optional(request["max_tokens"].get<uint16_t>())
-                : std::nullopt,
-            request.contains("temperature")
-                ? std::make_optional(request["temperature"].get<float>())
-                : std::nullopt,
-            request.contains("top_p") ? std::make_optional(request["top_p"].get<float>())
-                                      : std::nullopt,
-            request.contains("n") ? std::make_optional(request["n"].get<uint16_t>()) : std::nullopt,
-            is_streaming ? std::make_optional(stream_callback) : std::nullopt,
-            request.contains("logprobs") ? std::make_optional(request["logprobs"].get<uint8_t>())
-                                         : std::nullopt,
-            request.contains("echo") ? std::make_optional(request["echo"].get<bool>())
-                                     : std::nullopt,
-            request.contains("stop")
-                ? std::make_optional(request["stop"].get<std::vector<std::string>>())
-                : std::nullopt,
-            request.contains("presence_penalty")
-                ? std::make_optional(request["presence_penalty"].get<float>())
-                : std::nullopt,
-            request.contains("frequency_penalty")
-                ? std::make_optional(request["frequency_penalty"].get<float>())
-                : std::nullopt,
-            request.contains("best_of") ? std::make_optional(request["best_of"].get<uint16_t>())
-                                        : std::nullopt,
-            request.contains("logit_bias")
-                ? std::make_optional(
-                      request["logit_bias"].get<std::unordered_map<std::string, int8_t>>())
-                : std::nullopt,
-            request.contains("user") ? std::make_optional(request["user"].get<std::string>())
-                                     : std::nullopt);
-        stats.end_time = std::chrono::steady_clock::now();
-
-        if (!is_streaming) {
-            // Extract content from choices.text for non-streaming responses
-            if (response.raw_json.contains("choices") && !response.raw_json["choices"].empty()) {
-                auto& choice = response.raw_json["choices"][0];
-                if (choice.contains("text") && !choice["text"].is_null()) {
-                    stats.output_text = choice["text"].get<std::string>();
-                }
-            } else {
-                // Fallback to response.content if no choices structure
-                stats.output_text = response.content;
+            if (config.convergence.enabled()) {
+                return run_convergence_experiment(config, *engine, requests);
             }
-
-            // Record TTFT only if we have actual content
-            if (!stats.output_text.empty()) {
-                stats.ttft_time = stats.end_time;
+            if (!config.workflow_file.empty()) {
+                return run_workflow_experiment(config, *engine, requests);
             }
-
-            if (response.raw_json.contains("usage")) {
-                stats.api_usage.prompt_tokens =
-                    response.raw_json["usage"].value("prompt_tokens", 0);
-                stats.api_usage.completion_tokens =
-                    response.raw_json["usage"].value("completion_tokens", 0);
-                stats.api_usage.total_tokens = response.raw_json["usage"].value("total_tokens", 0);
+            // Re-runs are consolidated with the previous results below instead
+            if (config.rerun_from.empty()) {
+                engine->add_sink(std::make_shared<JsonFileSink>(config.output_file));
             }
-            if (response.raw_json.contains("time_info")) {
-                stats.api_time_info.queue_time =
-                    response.raw_json["time_info"].value("queue_time", 0.0);
-                stats.api_time_info.prompt_time =
-                    response.raw_json["time_info"].value("prompt_time", 0.0);
-                stats.api_time_info.completion_time =
-                    response.raw_json["time_info"].value("completion_time", 0.0);
-                stats.api_time_info.total_time =
-                    response.raw_json["time_info"].value("total_time", 0.0);
-                stats.api_time_info.created = response.raw_json["time_info"].value("created", 0);
-            }
-        }
-    } catch (const std::exception& e) {
-        stats.success = false;
-        stats.error_message = e.what();
-        stats.end_time = std::chrono::steady_clock::now();
-        return stats;
-    }
-    return stats;
-}
-
-using Stats = std::pair<OverallStats, std::vector<CompletionStats>>;
-Stats do_completions(const std::vector<nlohmann::json>& requests, int concurrent_requests,
-                     liboai::OpenAI& oai, const std::string& model) {
-    OverallStats stats;
-    std::vector<CompletionStats> all_completion_stats(requests.size());
-
-    stats.start_time = std::chrono::steady_clock::now();
-
-    // Create a thread pool-like approach using futures
-    std::atomic<size_t> next_request_index{0};
-
-    auto worker = [&]() -> void {
-        while (true) {
-            size_t index = next_request_index.fetch_add(1);
-            if (index >= requests.size()) {
-                break;
-            }
-            all_completion_stats[index] = do_completion(requests[index], oai, model);
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] " << e.what() << '\n';
+            return EXIT_FAILURE;
         }
-    };
-    std::vector<std::thread> threads;
-    for (int i = 0; i < concurrent_requests; ++i) {
-        threads.emplace_back(worker);
-    }
-    for (auto& thread : threads) {
-        thread.join();
-    }
-
-    stats.end_time = std::chrono::steady_clock::now();
-    stats.total_number_requests = requests.size();
-
-    for (const auto& completion_stats : all_completion_stats) {
-        stats.total_prompt_tokens += completion_stats.api_usage.prompt_tokens;
-        stats.total_completion_tokens += completion_stats.api_usage.completion_tokens;
-        stats.total_tokens += completion_stats.api_usage.total_tokens;
-        if (!completion_stats.success) {
-            stats.total_number_failures++;
-        }
-    }
-
-    return std::make_pair(stats, all_completion_stats);
-}
-
-void dump_stats_to_file(const Stats& stats, const std::string& filename) {
-    nlohmann::json output_json;
-
-    // Add overall stats using the to_json method
-    output_json["overall_stats"] = stats.first.to_json();
-
-    // Add individual completion stats using the to_json method
-    nlohmann::json completions_array = nlohmann::json::array();
-    for (const auto& completion_stats : stats.second) {
-        completions_array.push_back(completion_stats.to_json());
-    }
-
-    output_json["completions"] = completions_array;
-
-    // Write to file
-    std::ofstream output_file(filename);
-    if (output_file.is_open()) {
-        output_file << output_json.dump(4);
-        output_file.close();
-        std::cout << "[INFO] Statistics written to " + filename << '\n';
-    } else {
-        std::cerr << "[ERROR] Failed to open output file: " + filename << '\n';
-    }
-}
-
-int main(int argc, char* argv[]) {
-    // Parse command line arguments
-    const auto config = parse_arguments(argc, argv);
-
-    // Load requests from JSONL file
-    const auto requests = load_requests_from_jsonl(config.input_file);
-    if (requests.empty()) {
-        std::cerr << "[ERROR] No valid requests found in input file" << '\n';
-        return EXIT_FAILURE;
+        stats = engine->run(requests);
     }
 
-    // Initialize liboai with the provided API key and endpoint
-    liboai::OpenAI oai(config.api_endpoint);
-    if (!oai.auth.SetKey(config.api_key)) {
-        std::cerr << "[ERROR] Failed to set API key." << '\n';
-        return EXIT_FAILURE;
+    if (!config.rerun_from.empty()) {
+        write_json_to_file(merge_rerun_results(previous, rerun_indices, stats, config.rerun_from,
+                                               config.rerun_filter),
+                           config.output_file);
     }
 
-    const auto stats = do_completions(requests, config.concurrent_requests, oai, config.model);
-
-    // Dump stats to output file
-    dump_stats_to_file(stats, config.output_file);
-
+    flush_logging();
     std::cout << "[INFO] Done!" << '\n';
     return EXIT_SUCCESS;
 }
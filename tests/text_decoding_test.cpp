@@ -0,0 +1,97 @@
+// Checks that the SSE2/AVX2 paths of the streamed delta decoder agree with the
+// scalar path. Every finder the CPU supports is compared with a plain loop, and
+// strings with escapes and UTF-8 straddling the 16/32-byte blocks are decoded
+// both in one call and a byte at a time; inputs shorter than a block only ever
+// take the scalar tail.
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "bench_core/text_decoding.h"
+
+using bench_core::JsonStringDecoder;
+
+namespace {
+
+size_t find_special_byte_reference(std::string_view data) {
+    for (size_t i = 0; i < data.size(); ++i) {
+        auto c = static_cast<unsigned char>(data[i]);
+        if (c == '\\' || c < 0x20 || c >= 0x80) {
+            return i;
+        }
+    }
+    return data.size();
+}
+
+int check_find_special_byte() {
+    int failures = 0;
+    auto implementations = bench_core::simd::find_special_byte_implementations();
+    // 0x7f is not special and must not stop the scan
+    const std::string_view specials("\\\x00\x1f\x7f\x80\xff", 6);
+    for (char special : specials) {
+        for (size_t size = 0; size <= 80; ++size) {
+            for (size_t at = 0; at <= size; ++at) {
+                std::string probe(size, 'a');
+                if (at < size) {
+                    probe[at] = special;
+                }
+                size_t expected = find_special_byte_reference(probe);
+                for (const auto& implementation : implementations) {
+                    size_t actual = implementation.find(probe.data(), probe.size());
+                    if (actual != expected) {
+                        std::cerr << implementation.name << " find_special_byte: byte 0x"
+                                  << std::hex << (static_cast<unsigned int>(special) & 0xFF)
+                                  << std::dec << " at " << at << " of " << size << ": got "
+                                  << actual << ", expected " << expected << '\n';
+                        failures++;
+                    }
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+int check_decode_boundaries() {
+    int failures = 0;
+    const std::string_view sequences[] = {
+        "\\n", "\\\"", "\\u00e9", "\\ud83d\\ude00", "\xc3\xa9", "\xf0\x9f\x98\x80", "\\q", "\xc3("};
+    for (auto sequence : sequences) {
+        for (size_t at = 0; at <= 70; ++at) {
+            std::string escaped(at, 'a');
+            escaped.append(sequence);
+            escaped.append(40, 'b');
+
+            std::string whole;
+            std::string bytewise;
+            JsonStringDecoder whole_decoder;
+            JsonStringDecoder bytewise_decoder;
+            whole_decoder.decode(escaped, whole);
+            whole_decoder.finish(whole);
+            for (size_t i = 0; i < escaped.size(); ++i) {
+                bytewise_decoder.decode(std::string_view(escaped).substr(i, 1), bytewise);
+            }
+            bytewise_decoder.finish(bytewise);
+            if (whole != bytewise ||
+                whole_decoder.invalid_sequences() != bytewise_decoder.invalid_sequences()) {
+                std::cerr << "JsonStringDecoder: sequence '" << sequence << "' at " << at
+                          << " decodes differently in one call and byte by byte\n";
+                failures++;
+            }
+        }
+    }
+    return failures;
+}
+
+}  // namespace
+
+int main() {
+    int failures = check_find_special_byte() + check_decode_boundaries();
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}